@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+
+#define BENCH_RUNS      5
+#define BENCH_TARGET_NS 100000000ULL // 100 ms per run
+
+static const char* benchFilter;
+static uint32_t benchSeed = 0x12345678;
+
+static uint64_t benchNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+uint32_t benchRand(void)
+{
+	// xorshift32
+	benchSeed ^= benchSeed << 13;
+	benchSeed ^= benchSeed >> 17;
+	benchSeed ^= benchSeed << 5;
+	return benchSeed;
+}
+
+void benchRun(const char* name, benchFn fn, void* ctx, size_t bytes)
+{
+	if (benchFilter && !strstr(name, benchFilter))
+		return;
+
+	// Calibrate the number of iterations
+	uint64_t iters = 1, elapsed;
+	for (;;)
+	{
+		uint64_t start = benchNow();
+		fn(ctx, iters);
+		elapsed = benchNow() - start;
+		if (elapsed >= BENCH_TARGET_NS/10)
+			break;
+		iters *= 2;
+	}
+	iters = iters * BENCH_TARGET_NS / elapsed;
+
+	double best = 0;
+	for (int run = 0; run < BENCH_RUNS; run ++)
+	{
+		uint64_t start = benchNow();
+		fn(ctx, iters);
+		double ns = (double)(benchNow() - start) / iters;
+		if (!run || ns < best)
+			best = ns;
+	}
+
+	if (bytes)
+		printf("%-40s %12.1f ns/op %10.1f MB/s\n", name, best, bytes / best * 1e9 / (1024*1024));
+	else
+		printf("%-40s %12.1f ns/op\n", name, best);
+	fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1)
+		benchFilter = argv[1];
+
+	benchUtf();
+	benchDecompress();
+	benchRbtree();
+	benchMemPool();
+	benchFont();
+	benchRomfs();
+	benchConsole();
+	benchMalloc();
+	return 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file bench.h
+ * @brief Host microbenchmark harness for the portable parts of libctru.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Benchmark body: runs the measured operation iters times.
+typedef void (*benchFn)(void* ctx, uint64_t iters);
+
+/**
+ * @brief Measures a benchmark and prints its result.
+ * @param name Name of the benchmark.
+ * @param fn Benchmark body.
+ * @param ctx Context passed to the body.
+ * @param bytes Bytes processed per operation, used to report the throughput (0 if not meaningful).
+ * The number of iterations is calibrated so that a run lasts about 100 ms; the best of several runs is reported.
+ */
+void benchRun(const char* name, benchFn fn, void* ctx, size_t bytes);
+
+/// Returns a deterministic pseudo-random number (the sequence is the same on every run).
+uint32_t benchRand(void);
+
+/// Prevents the compiler from optimizing away a computed value.
+static inline void benchKeep(uintptr_t value)
+{
+	__asm__ __volatile__("" :: "r" (value) : "memory");
+}
+
+/// Benchmark suites.
+void benchUtf(void);
+void benchDecompress(void);
+void benchRbtree(void);
+void benchMemPool(void);
+void benchFont(void);
+void benchRomfs(void);
+void benchConsole(void);
+void benchMalloc(void);
+
+#ifdef __cplusplus
+}
+#endif
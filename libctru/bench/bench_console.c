@@ -0,0 +1,34 @@
+#include <3ds/types.h>
+#include <3ds/console.h>
+#include "bench.h"
+
+// Not exported by console.h
+void consoleDrawChar(int c);
+void consolePrintChar(int c);
+
+static void benchConsoleDraw(void* arg, uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i ++)
+		consoleDrawChar('!' + (int)(i % 94));
+}
+
+static void benchConsolePrint(void* arg, uint64_t iters)
+{
+	// Includes cursor movement and scrolling
+	for (uint64_t i = 0; i < iters; i ++)
+		consolePrintChar(i % 61 == 60 ? '\n' : '!' + (int)(i % 94));
+}
+
+void benchConsole(void)
+{
+	static u16 framebuffer[400*240];
+	static PrintConsole console;
+
+	console = *consoleGetDefault();
+	console.frameBuffer = framebuffer;
+	console.consoleInitialised = true;
+	consoleSelect(&console);
+
+	benchRun("console/draw glyph", benchConsoleDraw, NULL, 0);
+	benchRun("console/print char", benchConsolePrint, NULL, 0);
+}
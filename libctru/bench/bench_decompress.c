@@ -0,0 +1,159 @@
+#include <stdlib.h>
+#include <string.h>
+#include <3ds/types.h>
+#include <3ds/util/decompress.h>
+#include "bench.h"
+
+#define DECOMP_SIZE (256 << 10)
+
+typedef struct
+{
+	u8* in;
+	size_t insize;
+	u8* out;
+} decompCtx;
+
+// Greedy LZ10/LZ11 encoder (single-entry hash table), only meant to produce realistic inputs
+static size_t encodeLZ(u8* out, const u8* in, size_t size, bool lz11)
+{
+	static u32 table[1 << 12];
+	size_t maxLen = lz11 ? 0x10110 : 18, o = 4, i = 0;
+	memset(table, 0xFF, sizeof(table));
+
+	out[0] = lz11 ? DECOMPRESS_LZ11 : DECOMPRESS_LZ10;
+	out[1] = size; out[2] = size >> 8; out[3] = size >> 16;
+
+	while (i < size)
+	{
+		size_t flagPos = o++;
+		out[flagPos] = 0;
+		for (int bit = 7; bit >= 0 && i < size; bit --)
+		{
+			size_t len = 0, disp = 0;
+			if (i + 3 <= size)
+			{
+				u32 h = ((in[i] << 8) ^ (in[i+1] << 4) ^ in[i+2]) & 0xFFF;
+				u32 cand = table[h];
+				table[h] = i;
+				if (cand != 0xFFFFFFFF && i - cand <= 0x1000)
+				{
+					while (i + len < size && len < maxLen && in[cand + len] == in[i + len])
+						len ++;
+					disp = i - cand - 1;
+				}
+			}
+
+			if (len < 3)
+			{
+				out[o++] = in[i++];
+				continue;
+			}
+
+			out[flagPos] |= 1 << bit;
+			if (!lz11)
+			{
+				out[o++] = ((len - 3) << 4) | (disp >> 8);
+				out[o++] = disp;
+			}
+			else if (len <= 0x10)
+			{
+				out[o++] = ((len - 1) << 4) | (disp >> 8);
+				out[o++] = disp;
+			}
+			else if (len <= 0x110)
+			{
+				out[o++] = (len - 0x11) >> 4;
+				out[o++] = ((len - 0x11) << 4) | (disp >> 8);
+				out[o++] = disp;
+			}
+			else
+			{
+				out[o++] = 0x10 | ((len - 0x111) >> 12);
+				out[o++] = (len - 0x111) >> 4;
+				out[o++] = ((len - 0x111) << 4) | (disp >> 8);
+				out[o++] = disp;
+			}
+			i += len;
+		}
+	}
+	return o;
+}
+
+static size_t encodeRLE(u8* out, const u8* in, size_t size)
+{
+	size_t o = 4, i = 0;
+	out[0] = DECOMPRESS_RLE;
+	out[1] = size; out[2] = size >> 8; out[3] = size >> 16;
+
+	while (i < size)
+	{
+		size_t run = 1;
+		while (i + run < size && run < 130 && in[i + run] == in[i])
+			run ++;
+		if (run >= 3)
+		{
+			out[o++] = 0x80 | (run - 3);
+			out[o++] = in[i];
+			i += run;
+			continue;
+		}
+
+		size_t lit = 0;
+		while (i + lit < size && lit < 128 && !(i + lit + 2 < size && in[i+lit] == in[i+lit+1] && in[i+lit] == in[i+lit+2]))
+			lit ++;
+		out[o++] = lit - 1;
+		memcpy(out + o, in + i, lit);
+		o += lit;
+		i += lit;
+	}
+	return o;
+}
+
+static void benchDecompressRun(void* arg, uint64_t iters)
+{
+	decompCtx* ctx = (decompCtx*)arg;
+	while (iters--)
+		if (!decompress(ctx->out, DECOMP_SIZE, NULL, ctx->in, ctx->insize))
+			abort();
+}
+
+void benchDecompress(void)
+{
+	static const char* words[] = { "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog ", "sprite ", "texture ", "\n" };
+	u8* data = (u8*)malloc(DECOMP_SIZE);
+	decompCtx ctx = { (u8*)malloc(DECOMP_SIZE*2), 0, (u8*)malloc(DECOMP_SIZE) };
+
+	// Text-like data for the LZ formats
+	for (size_t i = 0; i < DECOMP_SIZE;)
+	{
+		const char* w = words[benchRand() % 11];
+		for (; *w && i < DECOMP_SIZE; w ++)
+			data[i++] = *w;
+	}
+
+	ctx.insize = encodeLZ(ctx.in, data, DECOMP_SIZE, false);
+	benchRun("decompress/lz10 256K text", benchDecompressRun, &ctx, DECOMP_SIZE);
+	ctx.insize = encodeLZ(ctx.in, data, DECOMP_SIZE, true);
+	benchRun("decompress/lz11 256K text", benchDecompressRun, &ctx, DECOMP_SIZE);
+
+	// Runs of bytes for RLE, as in simple bitmaps
+	for (size_t i = 0; i < DECOMP_SIZE;)
+	{
+		u8 value = benchRand();
+		size_t run = 1 + benchRand() % 40;
+		for (; run-- && i < DECOMP_SIZE; i ++)
+			data[i] = value;
+	}
+	ctx.insize = encodeRLE(ctx.in, data, DECOMP_SIZE);
+
+	// Check the round trip once, so that a broken decoder doesn't go unnoticed
+	benchDecompressRun(&ctx, 1);
+	if (memcmp(ctx.out, data, DECOMP_SIZE) != 0)
+		abort();
+
+	benchRun("decompress/rle 256K runs", benchDecompressRun, &ctx, DECOMP_SIZE);
+
+	free(ctx.out);
+	free(ctx.in);
+	free(data);
+}
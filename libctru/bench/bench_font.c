@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <string.h>
+#include <3ds/types.h>
+#include <3ds/font.h>
+#include "bench.h"
+
+// Builds a font with the kinds of character maps found in the system font
+static CFNT_s* fontBuild(void)
+{
+	CFNT_s* font = (CFNT_s*)calloc(1, sizeof(CFNT_s));
+	font->finf.alterCharIndex = 0;
+
+	// ASCII: direct mapping
+	CMAP_s* direct = (CMAP_s*)calloc(1, sizeof(CMAP_s));
+	direct->codeBegin = 0x20;
+	direct->codeEnd = 0x7E;
+	direct->mappingMethod = CMAP_TYPE_DIRECT;
+	direct->indexOffset = 1;
+
+	// Kana: table mapping
+	CMAP_s* table = (CMAP_s*)calloc(1, sizeof(CMAP_s) + 0x60*sizeof(u16));
+	table->codeBegin = 0x3040;
+	table->codeEnd = 0x309F;
+	table->mappingMethod = CMAP_TYPE_TABLE;
+	for (int i = 0; i < 0x60; i ++)
+		table->indexTable[i] = 0x100 + i;
+
+	// Kanji: scan list, which the lookup searches linearly
+	const int nScan = 2000;
+	CMAP_s* scan = (CMAP_s*)calloc(1, sizeof(CMAP_s) + nScan*sizeof(scan->scanEntries[0]));
+	scan->codeBegin = 0;
+	scan->codeEnd = 0xFFFF;
+	scan->mappingMethod = CMAP_TYPE_SCAN;
+	scan->nScanEntries = nScan;
+	for (int i = 0; i < nScan; i ++)
+	{
+		scan->scanEntries[i].code = 0x4E00 + i*3;
+		scan->scanEntries[i].glyphIndex = 0x200 + i;
+	}
+
+	direct->next = table;
+	table->next = scan;
+	font->finf.cmap = direct;
+	return font;
+}
+
+static u32 fontCodes[1024];
+
+static void benchFontLookup(void* arg, uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i ++)
+		benchKeep(fontGlyphIndexFromCodePoint((CFNT_s*)arg, fontCodes[i & 1023]));
+}
+
+void benchFont(void)
+{
+	CFNT_s* font = fontBuild();
+
+	for (int i = 0; i < 1024; i ++)
+		fontCodes[i] = 0x20 + benchRand() % 0x5F;
+	benchRun("font/glyph index ascii", benchFontLookup, font, 0);
+
+	for (int i = 0; i < 1024; i ++)
+		fontCodes[i] = 0x3040 + benchRand() % 0x60;
+	benchRun("font/glyph index kana", benchFontLookup, font, 0);
+
+	for (int i = 0; i < 1024; i ++)
+		fontCodes[i] = 0x4E00 + (benchRand() % 2000)*3;
+	benchRun("font/glyph index kanji", benchFontLookup, font, 0);
+
+	for (CMAP_s* cmap = font->finf.cmap, *next; cmap; cmap = next)
+	{
+		next = cmap->next;
+		free(cmap);
+	}
+	free(font);
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/reent.h>
+#include <3ds/types.h>
+#include <3ds/os.h>
+#include "bench.h"
+
+#define MALLOC_SLOTS 1024
+
+// The baseline is the host C library's allocator, not newlib's (which applications use on the console)
+#ifdef __GLIBC__
+#define MALLOC_HOST_NAME "glibc"
+#else
+#define MALLOC_HOST_NAME "host-libc"
+#endif
+
+// Entry points of the thread-caching allocator (see fastmalloc.h)
+void* __wrap__malloc_r(struct _reent* r, size_t size);
+void __wrap__free_r(struct _reent* r, void* ptr);
+
+// The allocator manages the application heap area, so it is given a mapping at the same address
+static u8* benchHeapEnd;
+static u8* benchHeapLimit;
+
+void* benchSbrk(ptrdiff_t incr)
+{
+	if (benchHeapEnd + incr > benchHeapLimit)
+		return (void*)-1;
+	void* ret = benchHeapEnd;
+	benchHeapEnd += incr;
+	return ret;
+}
+
+typedef struct
+{
+	void* (*alloc)(size_t size);
+	void (*release)(void* ptr);
+	void* slots[MALLOC_SLOTS];
+	u32 sizes[4096];
+	u32 maxSize;
+} mallocCtx;
+
+static struct _reent benchReent;
+
+static void* fastAlloc(size_t size) { return __wrap__malloc_r(&benchReent, size); }
+static void fastFree(void* ptr) { __wrap__free_r(&benchReent, ptr); }
+
+static void benchMallocChurn(void* arg, uint64_t iters)
+{
+	mallocCtx* ctx = (mallocCtx*)arg;
+	for (uint64_t i = 0; i < iters; i ++)
+	{
+		u32 slot = (u32)(i * 2654435761u) % MALLOC_SLOTS;
+		ctx->release(ctx->slots[slot]);
+		ctx->slots[slot] = ctx->alloc(ctx->sizes[i & 4095]);
+		if (!ctx->slots[slot])
+			abort();
+	}
+}
+
+static void benchMallocPair(mallocCtx* ctx, const char* name, u32 maxSize)
+{
+	char label[64];
+	for (int i = 0; i < 4096; i ++)
+		ctx->sizes[i] = 1 + benchRand() % maxSize;
+
+	for (int pass = 0; pass < 2; pass ++)
+	{
+		ctx->alloc = pass ? fastAlloc : malloc;
+		ctx->release = pass ? fastFree : free;
+		for (int i = 0; i < MALLOC_SLOTS; i ++)
+			ctx->slots[i] = ctx->alloc(ctx->sizes[i]);
+
+		snprintf(label, sizeof(label), "malloc/%s %s", pass ? "fastmalloc" : MALLOC_HOST_NAME, name);
+		benchRun(label, benchMallocChurn, ctx, 0);
+
+		for (int i = 0; i < MALLOC_SLOTS; i ++)
+			ctx->release(ctx->slots[i]);
+	}
+}
+
+void benchMalloc(void)
+{
+	const size_t size = OS_HEAP_AREA_END - OS_HEAP_AREA_BEGIN;
+	void* heap = mmap((void*)OS_HEAP_AREA_BEGIN, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+	if (heap != (void*)OS_HEAP_AREA_BEGIN)
+	{
+		printf("malloc: heap area unavailable, skipped\n");
+		return;
+	}
+	benchHeapEnd = (u8*)heap;
+	benchHeapLimit = benchHeapEnd + size;
+
+	static mallocCtx ctx;
+	benchMallocPair(&ctx, "16-256B", 256);
+	benchMallocPair(&ctx, "16B-4K", 4096);
+	benchMallocPair(&ctx, "16B-64K", 65536);
+
+	munmap(heap, size);
+}
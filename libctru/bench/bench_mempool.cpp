@@ -0,0 +1,46 @@
+#include <stdlib.h>
+#include "../source/allocator/mem_pool.h"
+#include "bench.h"
+
+#define MEMPOOL_SIZE   (16 << 20)
+#define MEMPOOL_CHUNKS 256
+
+struct memPoolCtx
+{
+	MemPool pool;
+	MemChunk chunks[MEMPOOL_CHUNKS];
+	u32 sizes[MEMPOOL_CHUNKS];
+};
+
+// Replaces a random live chunk with a new one, as the linear/VRAM allocators do
+static void benchMemPoolChurn(void* arg, uint64_t iters)
+{
+	auto ctx = (memPoolCtx*)arg;
+	for (uint64_t i = 0; i < iters; i ++)
+	{
+		u32 slot = (u32)(i * 2654435761u) % MEMPOOL_CHUNKS;
+		ctx->pool.Deallocate(ctx->chunks[slot]);
+		if (!ctx->pool.Allocate(ctx->chunks[slot], ctx->sizes[slot], 7))
+			abort();
+	}
+}
+
+void benchMemPool(void)
+{
+	auto ctx = (memPoolCtx*)calloc(1, sizeof(memPoolCtx));
+	auto base = (u8*)aligned_alloc(0x1000, MEMPOOL_SIZE);
+	ctx->pool.AddBlock(MemBlock::Create(base, MEMPOOL_SIZE));
+
+	for (int i = 0; i < MEMPOOL_CHUNKS; i ++)
+	{
+		ctx->sizes[i] = 0x80 + benchRand() % 0x8000;
+		if (!ctx->pool.Allocate(ctx->chunks[i], ctx->sizes[i], 7))
+			abort();
+	}
+
+	benchRun("mem_pool/free+alloc 256 live", benchMemPoolChurn, ctx, 0);
+
+	ctx->pool.Destroy();
+	free(base);
+	free(ctx);
+}
@@ -0,0 +1,67 @@
+#include <stdlib.h>
+#include <3ds/util/rbtree.h>
+#include "bench.h"
+
+#define RBTREE_NODES 4096
+
+typedef struct
+{
+	rbtree_node_t node;
+	uint32_t key;
+} rbItem;
+
+typedef struct
+{
+	rbtree_t tree;
+	rbItem items[RBTREE_NODES];
+} rbCtx;
+
+static int rbCompare(const rbtree_node_t* lhs, const rbtree_node_t* rhs)
+{
+	uint32_t a = rbtree_item(lhs, rbItem, node)->key;
+	uint32_t b = rbtree_item(rhs, rbItem, node)->key;
+	return a < b ? -1 : a > b;
+}
+
+static void benchRbInsertRemove(void* arg, uint64_t iters)
+{
+	rbCtx* ctx = (rbCtx*)arg;
+	for (uint64_t i = 0; i < iters; i ++)
+	{
+		rbItem* item = &ctx->items[i % RBTREE_NODES];
+		rbtree_remove(&ctx->tree, &item->node, NULL);
+		benchKeep((uintptr_t)rbtree_insert(&ctx->tree, &item->node));
+	}
+}
+
+static void benchRbFind(void* arg, uint64_t iters)
+{
+	rbCtx* ctx = (rbCtx*)arg;
+	for (uint64_t i = 0; i < iters; i ++)
+		benchKeep((uintptr_t)rbtree_find(&ctx->tree, &ctx->items[(i * 2654435761u) % RBTREE_NODES].node));
+}
+
+static void benchRbIterate(void* arg, uint64_t iters)
+{
+	rbCtx* ctx = (rbCtx*)arg;
+	while (iters--)
+		for (rbtree_node_t* node = rbtree_min(&ctx->tree); node; node = rbtree_node_next(node))
+			benchKeep((uintptr_t)node);
+}
+
+void benchRbtree(void)
+{
+	rbCtx* ctx = (rbCtx*)malloc(sizeof(rbCtx));
+	rbtree_init(&ctx->tree, rbCompare);
+	for (int i = 0; i < RBTREE_NODES; i ++)
+	{
+		ctx->items[i].key = benchRand();
+		benchKeep((uintptr_t)rbtree_insert(&ctx->tree, &ctx->items[i].node));
+	}
+
+	benchRun("rbtree/remove+insert 4096", benchRbInsertRemove, ctx, 0);
+	benchRun("rbtree/find 4096", benchRbFind, ctx, 0);
+	benchRun("rbtree/iterate 4096", benchRbIterate, ctx, 0);
+
+	free(ctx);
+}
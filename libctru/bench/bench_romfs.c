@@ -0,0 +1,31 @@
+#include <3ds/types.h>
+#include "../source/romfs_hash.h"
+#include "bench.h"
+
+typedef struct
+{
+	u16 names[256][32];
+	u32 lens[256];
+} romfsCtx;
+
+static void benchRomfsHash(void* arg, uint64_t iters)
+{
+	romfsCtx* ctx = (romfsCtx*)arg;
+	for (uint64_t i = 0; i < iters; i ++)
+		benchKeep(romfsCalcHash((u32)i*0x20, ctx->names[i & 255], ctx->lens[i & 255], 0x3F1));
+}
+
+void benchRomfs(void)
+{
+	static romfsCtx ctx;
+	u32 total = 0;
+	for (int i = 0; i < 256; i ++)
+	{
+		ctx.lens[i] = 4 + benchRand() % 28;
+		for (u32 j = 0; j < ctx.lens[i]; j ++)
+			ctx.names[i][j] = 'a' + benchRand() % 26;
+		total += ctx.lens[i];
+	}
+
+	benchRun("romfs/name hash", benchRomfsHash, &ctx, total*sizeof(u16)/256);
+}
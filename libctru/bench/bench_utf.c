@@ -0,0 +1,73 @@
+#include <stdlib.h>
+#include <3ds/types.h>
+#include <3ds/util/utf.h>
+#include "bench.h"
+
+#define UTF_TEXT_LEN 4096
+
+typedef struct
+{
+	uint8_t utf8[UTF_TEXT_LEN*4+1];
+	uint16_t utf16[UTF_TEXT_LEN*2+1];
+	uint32_t utf32[UTF_TEXT_LEN+1];
+	size_t len8, len16;
+} utfCtx;
+
+static void benchUtf8To16(void* arg, uint64_t iters)
+{
+	utfCtx* ctx = (utfCtx*)arg;
+	while (iters--)
+		benchKeep(utf8_to_utf16(ctx->utf16, ctx->utf8, ctx->len16));
+}
+
+static void benchUtf16To8(void* arg, uint64_t iters)
+{
+	utfCtx* ctx = (utfCtx*)arg;
+	while (iters--)
+		benchKeep(utf16_to_utf8(ctx->utf8, ctx->utf16, ctx->len8));
+}
+
+static void benchUtf8To32(void* arg, uint64_t iters)
+{
+	utfCtx* ctx = (utfCtx*)arg;
+	while (iters--)
+		benchKeep(utf8_to_utf32(ctx->utf32, ctx->utf8, UTF_TEXT_LEN));
+}
+
+// Fills the buffers with text, mixing ASCII with the given proportion of 2 and 3-byte characters
+static void utfFill(utfCtx* ctx, unsigned percentNonAscii)
+{
+	for (size_t i = 0; i < UTF_TEXT_LEN; i ++)
+	{
+		uint32_t r = benchRand();
+		if (r % 100 >= percentNonAscii)
+			ctx->utf32[i] = 0x20 + (r >> 8) % 0x5F;
+		else if (r & 0x100)
+			ctx->utf32[i] = 0x80 + (r >> 9) % 0x780;
+		else
+			ctx->utf32[i] = 0x3040 + (r >> 9) % 0x60; // Hiragana
+	}
+	ctx->utf32[UTF_TEXT_LEN] = 0;
+
+	ctx->len8 = utf32_to_utf8(ctx->utf8, ctx->utf32, UTF_TEXT_LEN*4);
+	ctx->utf8[ctx->len8] = 0;
+	ctx->len16 = utf32_to_utf16(ctx->utf16, ctx->utf32, UTF_TEXT_LEN*2);
+	ctx->utf16[ctx->len16] = 0;
+}
+
+void benchUtf(void)
+{
+	utfCtx* ctx = (utfCtx*)malloc(sizeof(utfCtx));
+
+	utfFill(ctx, 0);
+	benchRun("utf/utf8_to_utf16 ascii", benchUtf8To16, ctx, ctx->len8);
+	benchRun("utf/utf16_to_utf8 ascii", benchUtf16To8, ctx, ctx->len8);
+	benchRun("utf/utf8_to_utf32 ascii", benchUtf8To32, ctx, ctx->len8);
+
+	utfFill(ctx, 50);
+	benchRun("utf/utf8_to_utf16 mixed", benchUtf8To16, ctx, ctx->len8);
+	benchRun("utf/utf16_to_utf8 mixed", benchUtf16To8, ctx, ctx->len8);
+	benchRun("utf/utf8_to_utf32 mixed", benchUtf8To32, ctx, ctx->len8);
+
+	free(ctx);
+}
@@ -0,0 +1,41 @@
+// Host implementations of the system functions referenced by the benchmarked sources
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/iosupport.h>
+#include <3ds/types.h>
+#include <3ds/svc.h>
+#include <3ds/gfx.h>
+#include <3ds/services/gspgpu.h>
+#include <3ds/services/apt.h>
+#include <3ds/services/ptmsysm.h>
+
+const devoptab_t* devoptab_list[STD_MAX];
+
+static u16 benchFramebuffer[400*240];
+
+u8* gfxGetFramebuffer(gfxScreen_t screen, gfx3dSide_t side, u16* width, u16* height)
+{
+	if (width) *width = 240;
+	if (height) *height = screen == GFX_TOP ? 400 : 320;
+	return (u8*)benchFramebuffer;
+}
+
+void gfxFlushBuffers(void) { }
+void gfxSwapBuffersGpu(void) { }
+bool gfxIsWide(void) { return false; }
+void gfxSetDoubleBuffering(gfxScreen_t screen, bool enable) { }
+void gfxSetScreenFormat(gfxScreen_t screen, GSPGPU_FramebufferFormat format) { }
+void gspWaitForEvent(GSPGPU_Event id, bool nextEvent) { }
+
+void svcBreak(UserBreakType breakReason) { abort(); }
+u64 svcGetSystemTick(void) { return 0; }
+Result svcOutputDebugString(const char* str, s32 length) { return 0; }
+Result svcCloseHandle(Handle handle) { return 0; }
+Result svcQueryMemory(MemInfo* info, PageInfo* out, u32 addr) { return -1; }
+Result svcMapMemoryBlock(Handle memblock, u32 addr, MemPerm my_perm, MemPerm other_perm) { return -1; }
+Result APT_GetSharedFont(Handle* fontHandle, u32* mapAddr) { return -1; }
+
+Result ptmSysmInit(void) { return -1; }
+void ptmSysmExit(void) { }
+Result PTMSYSM_ConfigureNew3DSCPU(u8 value) { return -1; }
@@ -0,0 +1,17 @@
+// Host stand-in for <3ds/synchronization.h>: the real one uses ARM instructions.
+// The benchmarks are single-threaded, so locks only need to exist.
+#pragma once
+#include <sys/lock.h>
+#include <3ds/types.h>
+
+typedef _LOCK_T LightLock;
+typedef s32 CondVar;
+
+static inline void __dmb(void)
+{
+	__sync_synchronize();
+}
+
+static inline void LightLock_Init(LightLock* lock) { *lock = 1; }
+static inline void LightLock_Lock(LightLock* lock) { (void)lock; }
+static inline void LightLock_Unlock(LightLock* lock) { (void)lock; }
@@ -0,0 +1,3 @@
+// Host stand-in for newlib's <reent.h>
+#pragma once
+#include <sys/reent.h>
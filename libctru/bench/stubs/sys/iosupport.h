@@ -0,0 +1,21 @@
+// Host stand-in for devkitARM's <sys/iosupport.h>, with what console.c uses
+#pragma once
+#include <sys/reent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+enum { STD_IN, STD_OUT, STD_ERR, STD_MAX = 16 };
+
+typedef struct
+{
+	const char* name;
+	size_t structSize;
+	int (*open_r)(struct _reent* r, void* fileStruct, const char* path, int flags, int mode);
+	int (*close_r)(struct _reent* r, void* fd);
+	ssize_t (*write_r)(struct _reent* r, void* fd, const char* ptr, size_t len);
+	ssize_t (*read_r)(struct _reent* r, void* fd, char* ptr, size_t len);
+	off_t (*seek_r)(struct _reent* r, void* fd, off_t pos, int dir);
+	int (*fstat_r)(struct _reent* r, void* fd, struct stat* st);
+} devoptab_t;
+
+extern const devoptab_t* devoptab_list[];
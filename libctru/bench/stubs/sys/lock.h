@@ -0,0 +1,6 @@
+// Host stand-in for devkitARM's <sys/lock.h>
+#pragma once
+#include <stdint.h>
+
+typedef int32_t _LOCK_T;
+typedef struct { _LOCK_T lock; uint32_t thread_tag; uint32_t counter; } _LOCK_RECURSIVE_T;
@@ -0,0 +1,9 @@
+// Host stand-in for newlib's <sys/reent.h>
+#pragma once
+#include <stdio.h>
+
+struct _reent
+{
+	int _errno;
+	void* deviceData;
+};
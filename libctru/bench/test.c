@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include "test.h"
+
+static unsigned testChecks, testFailures;
+static uint32_t testSeed = 0x12345678;
+
+uint32_t testRand(void)
+{
+	// xorshift32
+	testSeed ^= testSeed << 13;
+	testSeed ^= testSeed >> 17;
+	testSeed ^= testSeed << 5;
+	return testSeed;
+}
+
+bool testCheck(bool ok, const char* expr, const char* file, int line)
+{
+	testChecks++;
+	if (!ok)
+	{
+		testFailures++;
+		printf("%s:%d: check failed: %s\n", file, line, expr);
+		fflush(stdout);
+	}
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	testGpu();
+	testCmdDecode();
+	testOs();
+	testMappable();
+	testHttp();
+	testSoc();
+
+	printf("%u checks, %u failures\n", testChecks, testFailures);
+	return testFailures ? 1 : 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file test.h
+ * @brief Host unit test harness for the portable parts of libctru.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Records the result of a check, printing it if it failed.
+ * @param ok Whether the check passed.
+ * @param expr Text of the checked expression.
+ * @param file Source file of the check.
+ * @param line Source line of the check.
+ * @return ok.
+ */
+bool testCheck(bool ok, const char* expr, const char* file, int line);
+
+/// Checks a condition, the test keeps running if it fails.
+#define TEST_CHECK(cond) testCheck(!!(cond), #cond, __FILE__, __LINE__)
+
+/// Returns a deterministic pseudo-random number (the sequence is the same on every run).
+uint32_t testRand(void);
+
+/// Test suites.
+void testGpu(void);
+void testCmdDecode(void);
+void testOs(void);
+void testMappable(void);
+void testHttp(void);
+void testSoc(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,232 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <3ds/types.h>
+#include <3ds/gpu/gpu.h>
+#include <3ds/gpu/registers.h>
+#include <3ds/gpu/cmddecode.h>
+#include "test.h"
+
+static u32 cmdBuf[0x100];
+static gpuCmdIssue_s lastIssue;
+
+static void issueCallback(const gpuCmdIssue_s* issue, void* user)
+{
+	lastIssue = *issue;
+	(*(u32*)user)++;
+}
+
+static u32 issueCount(const gpuCmdDecoder_s* dec)
+{
+	u32 total = 0;
+	for (int i = 0; i < GPUCMD_ISSUE_MAX; i ++)
+		total += dec->numIssues[i];
+	return total;
+}
+
+// Decodes the commands added since the last GPUCMD_SetBuffer
+static bool decode(gpuCmdDecoder_s* dec)
+{
+	return gpuCmdDecode(dec, gpuCmdBuf, gpuCmdBufOffset);
+}
+
+static void testDecodeWrites(void)
+{
+	gpuCmdDecoder_s dec;
+	gpuCmdDecoderInit(&dec);
+
+	static const u32 vals[] = { 1, 2, 3 };
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddWrite(GPUREG_FACECULLING_CONFIG, 2);
+	GPUCMD_AddMaskedWrite(GPUREG_VIEWPORT_XY, 0x3, 0xAABBCCDD);
+	GPUCMD_AddIncrementalWrites(GPUREG_FRAGOP_CLIP_DATA0, vals, 3);
+	GPUCMD_AddWrites(GPUREG_VSH_FLOATUNIFORM_DATA, vals, 3);
+
+	TEST_CHECK(decode(&dec));
+	TEST_CHECK(dec.numCommands == 4);
+	TEST_CHECK(dec.numWrites == 8);
+	TEST_CHECK(issueCount(&dec) == 0);
+
+	TEST_CHECK(dec.values[GPUREG_FACECULLING_CONFIG] == 2);
+	TEST_CHECK(dec.values[GPUREG_VIEWPORT_XY] == 0xCCDD);
+	TEST_CHECK(dec.values[GPUREG_FRAGOP_CLIP_DATA0] == 1);
+	TEST_CHECK(dec.values[GPUREG_FRAGOP_CLIP_DATA1] == 2);
+	TEST_CHECK(dec.values[GPUREG_FRAGOP_CLIP_DATA2] == 3);
+	TEST_CHECK(dec.values[GPUREG_FRAGOP_CLIP_DATA3] == 0);
+	TEST_CHECK(dec.writeCounts[GPUREG_VSH_FLOATUNIFORM_DATA] == 3);
+	TEST_CHECK(dec.values[GPUREG_VSH_FLOATUNIFORM_DATA] == 3);
+	TEST_CHECK(dec.writeCounts[GPUREG_VSH_FLOATUNIFORM_DATA+1] == 0);
+
+	// A partial write merges with the known value
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddMaskedWrite(GPUREG_VIEWPORT_XY, 0xC, 0x11223344);
+	TEST_CHECK(decode(&dec));
+	TEST_CHECK(dec.values[GPUREG_VIEWPORT_XY] == 0x1122CCDD);
+}
+
+static void testDecodeWaste(void)
+{
+	gpuCmdDecoder_s dec;
+	u32 numCalls = 0;
+	gpuCmdDecoderInit(&dec);
+	gpuCmdDecoderSetCallback(&dec, issueCallback, &numCalls);
+
+	// Rewriting the same value
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddWrite(GPUREG_DEPTHMAP_ENABLE, 1);
+	GPUCMD_AddWrite(GPUREG_DEPTHMAP_ENABLE, 1);
+	TEST_CHECK(decode(&dec));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_REDUNDANT] == 1);
+	TEST_CHECK(numCalls == 1);
+	TEST_CHECK(lastIssue.type == GPUCMD_ISSUE_REDUNDANT && lastIssue.reg == GPUREG_DEPTHMAP_ENABLE && lastIssue.offset == 2);
+
+	// Changing a value before a draw used it
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddWrite(GPUREG_DEPTHMAP_ENABLE, 0);
+	TEST_CHECK(decode(&dec));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_OVERWRITTEN] == 1);
+
+	// A trigger consumes the state
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddWrite(GPUREG_DRAWARRAYS, 1);
+	GPUCMD_AddWrite(GPUREG_DEPTHMAP_ENABLE, 1);
+	GPUCMD_AddWrite(GPUREG_DRAWARRAYS, 1);
+	TEST_CHECK(decode(&dec));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_OVERWRITTEN] == 1);
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_REDUNDANT] == 1);
+
+	// Data ports and triggers are never redundant
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddWrite(GPUREG_FIXEDATTRIB_INDEX, 0);
+	GPUCMD_AddWrite(GPUREG_FIXEDATTRIB_INDEX, 0);
+	GPUCMD_AddWrite(GPUREG_LIGHTING_LUT_DATA3, 5);
+	GPUCMD_AddWrite(GPUREG_LIGHTING_LUT_DATA3, 5);
+	GPUCMD_AddWrite(GPUREG_DRAWARRAYS, 1);
+	TEST_CHECK(decode(&dec));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_REDUNDANT] == 1);
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_OVERWRITTEN] == 1);
+
+	// Empty mask
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddMaskedWrite(GPUREG_FACECULLING_CONFIG, 0, 1);
+	TEST_CHECK(decode(&dec));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_ZERO_MASK] == 1);
+	TEST_CHECK(dec.values[GPUREG_FACECULLING_CONFIG] == 0);
+	TEST_CHECK(numCalls == issueCount(&dec));
+}
+
+static void testDecodeMalformed(void)
+{
+	gpuCmdDecoder_s dec;
+
+	// Header missing
+	gpuCmdDecoderInit(&dec);
+	static const u32 lone[] = { 0x12345678 };
+	TEST_CHECK(!gpuCmdDecode(&dec, lone, 1));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_TRUNCATED] == 1);
+
+	// Parameters missing
+	gpuCmdDecoderInit(&dec);
+	static const u32 shortCmd[] = { 1, GPUCMD_HEADER(0, 0xF, GPUREG_VIEWPORT_XY) | (3 << 20), 2 };
+	TEST_CHECK(!gpuCmdDecode(&dec, shortCmd, 3));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_TRUNCATED] == 1);
+	TEST_CHECK(dec.numWrites == 0);
+
+	// The padding word is part of the command
+	gpuCmdDecoderInit(&dec);
+	static const u32 noPad[] = { 1, GPUCMD_HEADER(0, 0xF, GPUREG_VIEWPORT_XY) | (1 << 20), 2 };
+	TEST_CHECK(!gpuCmdDecode(&dec, noPad, 3));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_TRUNCATED] == 1);
+
+	// Reserved header bits
+	gpuCmdDecoderInit(&dec);
+	static const u32 reserved[] = { 1, GPUCMD_HEADER(0, 0xF, GPUREG_VIEWPORT_XY) | BIT(28), 1, GPUCMD_HEADER(0, 0xF, GPUREG_FACECULLING_CONFIG) };
+	TEST_CHECK(!gpuCmdDecode(&dec, reserved, 4));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_RESERVED_BITS] == 1);
+	TEST_CHECK(dec.numCommands == 2);
+
+	// Incremental write past the last register
+	gpuCmdDecoderInit(&dec);
+	static const u32 overflow[] = { 1, GPUCMD_HEADER(1, 0xF, 0x3FF) | (1 << 20), 2, 0 };
+	TEST_CHECK(!gpuCmdDecode(&dec, overflow, 4));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_REG_OVERFLOW] == 1);
+	TEST_CHECK(dec.writeCounts[0x3FF] == 1);
+
+	// Unaligned buffer size
+	gpuCmdDecoderInit(&dec);
+	static const u32 unaligned[] = { 1, GPUCMD_HEADER(0, 0xF, GPUREG_VIEWPORT_XY) };
+	TEST_CHECK(gpuCmdDecode(&dec, unaligned, 2));
+	TEST_CHECK(dec.numIssues[GPUCMD_ISSUE_UNALIGNED_SIZE] == 1);
+
+	// A split buffer is padded
+	gpuCmdDecoderInit(&dec);
+	GPUCMD_SetBuffer(cmdBuf, sizeof(cmdBuf)/4, 0);
+	GPUCMD_AddWrite(GPUREG_VIEWPORT_XY, 1);
+	u32* buf; u32 size;
+	GPUCMD_Split(&buf, &size);
+	TEST_CHECK(gpuCmdDecode(&dec, buf, size));
+	TEST_CHECK(issueCount(&dec) == 0);
+}
+
+// Every register named in registers.h has that name (or the name of an alias), unnamed ones have none
+static void testRegNames(void)
+{
+	static char names[GPUREG_COUNT][4][64];
+	static bool named[GPUREG_COUNT];
+
+	FILE* f = fopen(TEST_INCLUDE_DIR "/3ds/gpu/registers.h", "r");
+	if (!TEST_CHECK(f))
+		return;
+
+	char line[256], name[64];
+	unsigned value;
+	while (fgets(line, sizeof(line), f))
+	{
+		if (sscanf(line, "#define GPUREG_%63s 0x%x", name, &value) != 2 || value >= GPUREG_COUNT)
+			continue;
+
+		// Placeholders for unknown registers are named after their ID
+		if (strlen(name) == 4 && isxdigit((unsigned char)name[0]) && strtoul(name, NULL, 16) == value)
+			continue;
+
+		for (int i = 0; i < 4; i ++)
+		{
+			if (names[value][i][0])
+				continue;
+			strcpy(names[value][i], name);
+			break;
+		}
+		named[value] = true;
+	}
+	fclose(f);
+
+	u32 numNamed = 0;
+	for (u32 reg = 0; reg < GPUREG_COUNT; reg ++)
+	{
+		const char* got = gpuCmdGetRegName(reg);
+		if (!named[reg])
+		{
+			if (!TEST_CHECK(got == NULL))
+				printf("register 0x%03X has no name in registers.h, but is named %s\n", reg, got);
+			continue;
+		}
+
+		numNamed ++;
+		bool found = false;
+		for (int i = 0; i < 4 && got; i ++)
+			found = found || strcmp(got, names[reg][i]) == 0;
+		if (!TEST_CHECK(found))
+			printf("register 0x%03X is GPUREG_%s in registers.h, but is named %s\n", reg, names[reg][0], got ? got : "(null)");
+	}
+	TEST_CHECK(numNamed > 300);
+	TEST_CHECK(gpuCmdGetRegName(GPUREG_COUNT) == NULL);
+}
+
+void testCmdDecode(void)
+{
+	testDecodeWrites();
+	testDecodeWaste();
+	testDecodeMalformed();
+	testRegNames();
+}
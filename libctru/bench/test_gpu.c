@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <string.h>
+#include <3ds/types.h>
+#include <3ds/gpu/gpu.h>
+#include <3ds/gpu/registers.h>
+#include "test.h"
+
+#define GPU_TEST_CHUNK 4096
+
+// The scalar conversion as it was written before the formats shared a helper
+static u32 refF32tof24(float f)
+{
+	u32 i;
+	memcpy(&i, &f, sizeof(i));
+
+	u32 mantissa = (i << 9) >>  9;
+	s32 exponent = (i << 1) >> 24;
+	u32 sign     = (i << 0) >> 31;
+
+	mantissa >>= 7;
+	exponent = exponent - 127 + 63;
+	if (exponent < 0)
+		return sign << 23;
+	else if (exponent > 0x7F)
+		return sign << 23 | 0x7F << 16;
+	return sign << 23 | exponent << 16 | mantissa;
+}
+
+// Packs the vector as a 96-bit number (w in the top bits), most significant word first
+static void refVec4Pack(u32* out, const float* in)
+{
+	unsigned __int128 v = 0;
+	for (int i = 3; i >= 0; i --)
+		v = v << 24 | refF32tof24(in[i]);
+	out[0] = (u32)(v >> 64);
+	out[1] = (u32)(v >> 32);
+	out[2] = (u32)v;
+}
+
+static float bitsToFloat(u32 bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// Converts count bit patterns with every converter, returns false (printing the pattern) on the first mismatch
+static bool checkRange(u32 first, u32 count, u32 stride)
+{
+	static float in[GPU_TEST_CHUNK];
+	static u32 out[GPU_TEST_CHUNK], packed[GPU_TEST_CHUNK/4*3];
+
+	while (count)
+	{
+		u32 num = count > GPU_TEST_CHUNK ? GPU_TEST_CHUNK : count;
+		for (u32 i = 0; i < num; i ++)
+			in[i] = bitsToFloat(first + i*stride);
+
+		// Odd sizes also go through the tail of the unrolled loop
+		f32tof24Array(out, in, num);
+		f32tof24Vec4Pack(packed, in, num/4);
+
+		for (u32 i = 0; i < num; i ++)
+		{
+			u32 ref = refF32tof24(in[i]);
+			if (f32tof24(in[i]) != ref || out[i] != ref)
+			{
+				printf("f24 mismatch for 0x%08X\n", first + i*stride);
+				return false;
+			}
+		}
+		for (u32 i = 0; i < num/4; i ++)
+		{
+			u32 ref[3];
+			refVec4Pack(ref, &in[i*4]);
+			if (memcmp(&packed[i*3], ref, sizeof(ref)) != 0)
+			{
+				printf("f24 vec4 mismatch for 0x%08X\n", first + i*4*stride);
+				return false;
+			}
+		}
+
+		first += num*stride;
+		count -= num;
+	}
+	return true;
+}
+
+static void testF24Values(void)
+{
+	static const struct { u32 bits, f24; } values[] =
+	{
+		{ 0x00000000, 0x000000 }, // +0
+		{ 0x80000000, 0x800000 }, // -0
+		{ 0x3F800000, 0x3F0000 }, // 1.0
+		{ 0xC0000000, 0xC00000 }, // -2.0
+		{ 0x3FC00000, 0x3F8000 }, // 1.5
+		{ 0x3F8000FF, 0x3F0001 }, // Truncated mantissa
+		{ 0x00000001, 0x000000 }, // Smallest denormal
+		{ 0x807FFFFF, 0x800000 }, // Largest negative denormal
+		{ 0x1F800000, 0x000000 }, // 2^-64, below the f24 range
+		{ 0x20000000, 0x000000 }, // 2^-63, smallest f24 exponent
+		{ 0x5F7FFFFF, 0x7EFFFF }, // Just below 2^64
+		{ 0x5FFFFFFF, 0x7FFFFF }, // Largest f24 value
+		{ 0x60000000, 0x7F0000 }, // 2^65, saturates
+		{ 0x7F800000, 0x7F0000 }, // +Inf
+		{ 0xFF800000, 0xFF0000 }, // -Inf
+		{ 0x7FC00000, 0x7F0000 }, // NaN
+	};
+
+	for (u32 i = 0; i < sizeof(values)/sizeof(values[0]); i ++)
+	{
+		float f = bitsToFloat(values[i].bits);
+		u32 out;
+		TEST_CHECK(f32tof24(f) == values[i].f24);
+		f32tof24Array(&out, &f, 1);
+		TEST_CHECK(out == values[i].f24);
+	}
+}
+
+static void testF24Sweep(void)
+{
+	// Every mantissa of the exponents around the edges of the f24 range, for both signs:
+	// denormals, underflow, the smallest and largest f24 exponents, overflow, infinities and NaNs
+	static const u32 exponents[] = { 0, 1, 62, 63, 64, 126, 127, 128, 189, 190, 191, 192, 254, 255 };
+	for (u32 sign = 0; sign < 2; sign ++)
+		for (u32 i = 0; i < sizeof(exponents)/sizeof(exponents[0]); i ++)
+			TEST_CHECK(checkRange(sign << 31 | exponents[i] << 23, 1 << 23, 1));
+
+	// A strided sweep of every other pattern (the stride is odd so that all mantissa bits vary)
+	TEST_CHECK(checkRange(0, (0xFFFFFFFF / 4099) + 1, 4099));
+}
+
+static void testFloatUniforms(void)
+{
+	static u32 cmd[0x400], ref[0x400];
+	float data[0x45*4];
+	u32 packed[0x45*3];
+
+	for (u32 i = 0; i < 0x45*4; i ++)
+		data[i] = (float)i * 0.37f - 20.0f;
+	for (u32 i = 0; i < 0x45; i ++)
+		refVec4Pack(&packed[i*3], &data[i*4]);
+
+	for (int type = 0; type < 2; type ++)
+	{
+		u32 regOffset = type ? (-0x30) : 0;
+
+		// Expected stream: the start register, then the data in writes of at most 0x20 vectors
+		GPUCMD_SetBuffer(ref, sizeof(ref)/4, 0);
+		GPUCMD_AddWrite(GPUREG_VSH_FLOATUNIFORM_CONFIG+regOffset, 0x10);
+		for (u32 i = 0; i < 0x45; i += 0x20)
+			GPUCMD_AddWrites(GPUREG_VSH_FLOATUNIFORM_DATA+regOffset, &packed[i*3], (0x45-i < 0x20 ? 0x45-i : 0x20)*3);
+		u32 refSize = gpuCmdBufOffset;
+
+		GPUCMD_SetBuffer(cmd, sizeof(cmd)/4, 0);
+		GPUCMD_AddFloatUniforms(type ? GPU_GEOMETRY_SHADER : GPU_VERTEX_SHADER, 0x10, data, 0x45);
+
+		TEST_CHECK(gpuCmdBufOffset == refSize);
+		TEST_CHECK(memcmp(cmd, ref, refSize*4) == 0);
+	}
+}
+
+void testGpu(void)
+{
+	testF24Values();
+	testF24Sweep();
+	testFloatUniforms();
+}
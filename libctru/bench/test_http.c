@@ -0,0 +1,364 @@
+// HTTP client tests against a local server, over a BSD socket transport
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <3ds/util/http.h>
+#include "test.h"
+
+#define HTTP_TEST_HEAD_SIZE 4096 // MAX_REQUEST_HEAD in http.c
+
+static int httpListenFd;
+static uint16_t httpPort;
+static pthread_mutex_t httpMutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned httpAccepts;
+static char httpLastHead[8192];
+
+//---------------------------------------------------------------------------------
+// Transport
+//---------------------------------------------------------------------------------
+
+static void* sockConnect(void* user, const char* host, uint16_t port, bool tls)
+{
+	struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM }, *ai;
+	char service[8];
+
+	if (tls)
+		return NULL;
+
+	snprintf(service, sizeof(service), "%u", port);
+	if (getaddrinfo(host, service, &hints, &ai) != 0)
+		return NULL;
+
+	int fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+	if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0)
+	{
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(ai);
+	if (fd < 0)
+		return NULL;
+
+	int* conn = (int*)malloc(sizeof(int));
+	*conn = fd;
+	return conn;
+}
+
+static ssize_t sockRead(void* conn, void* buf, size_t len)
+{
+	return recv(*(int*)conn, buf, len, 0);
+}
+
+static ssize_t sockWrite(void* conn, const void* buf, size_t len)
+{
+	return send(*(int*)conn, buf, len, MSG_NOSIGNAL);
+}
+
+static void sockClose(void* conn)
+{
+	close(*(int*)conn);
+	free(conn);
+}
+
+static const http_transport_t sockTransport = { sockConnect, sockRead, sockWrite, sockClose, NULL, NULL, NULL };
+
+//---------------------------------------------------------------------------------
+// Server
+//---------------------------------------------------------------------------------
+
+static bool sendAll(int fd, const char* data)
+{
+	size_t len = strlen(data);
+	while (len)
+	{
+		ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+		if (n <= 0)
+			return false;
+		data += n;
+		len -= n;
+	}
+	return true;
+}
+
+// Serves the requests of a connection, the path selects the response
+static void* serverConnection(void* arg)
+{
+	int fd = (int)(intptr_t)arg;
+	static __thread char buf[16384];
+	size_t len = 0;
+
+	for (;;)
+	{
+		char* end;
+		while (!(end = memmem(buf, len, "\r\n\r\n", 4)))
+		{
+			ssize_t n = len < sizeof(buf) ? recv(fd, buf + len, sizeof(buf) - len, 0) : 0;
+			if (n <= 0)
+			{
+				close(fd);
+				return NULL;
+			}
+			len += n;
+		}
+
+		size_t headLen = end + 4 - buf;
+		pthread_mutex_lock(&httpMutex);
+		memcpy(httpLastHead, buf, headLen < sizeof(httpLastHead) ? headLen : sizeof(httpLastHead) - 1);
+		httpLastHead[headLen < sizeof(httpLastHead) ? headLen : sizeof(httpLastHead) - 1] = 0;
+		pthread_mutex_unlock(&httpMutex);
+
+		// Request bodies are echoed back
+		size_t bodyLen = 0;
+		const char* cl = memmem(buf, headLen, "\r\nContent-Length: ", 18);
+		if (cl)
+			bodyLen = strtoul(cl + 18, NULL, 10);
+		while (len < headLen + bodyLen)
+		{
+			ssize_t n = recv(fd, buf + len, sizeof(buf) - len, 0);
+			if (n <= 0)
+			{
+				close(fd);
+				return NULL;
+			}
+			len += n;
+		}
+
+		char path[64] = "";
+		sscanf(buf, "%*s %63s", path);
+		bool closeAfter = false, ok = true;
+
+		if (strcmp(path, "/hello") == 0)
+			ok = sendAll(fd, "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nContent-Type: text/plain\r\n\r\nhello");
+		else if (strcmp(path, "/chunked") == 0)
+			ok = sendAll(fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nhel\r\n2;ext=1\r\nlo\r\n0\r\nX-Trailer: 1\r\n\r\n");
+		else if (strcmp(path, "/eof") == 0)
+		{
+			ok = sendAll(fd, "HTTP/1.1 200 OK\r\n\r\nuntil close");
+			closeAfter = true;
+		} else if (strcmp(path, "/stale") == 0)
+		{
+			// Claims keep-alive, but the connection goes away before the next request
+			ok = sendAll(fd, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+			closeAfter = true;
+		} else if (strcmp(path, "/echo") == 0)
+		{
+			char head[64];
+			snprintf(head, sizeof(head), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n", bodyLen);
+			buf[headLen + bodyLen] = 0;
+			ok = sendAll(fd, head) && sendAll(fd, buf + headLen);
+		} else if (strcmp(path, "/continue") == 0)
+			ok = sendAll(fd, "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 204 No Content\r\n\r\n");
+		else
+			ok = sendAll(fd, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+
+		memmove(buf, buf + headLen + bodyLen, len - headLen - bodyLen);
+		len -= headLen + bodyLen;
+
+		if (!ok || closeAfter)
+		{
+			close(fd);
+			return NULL;
+		}
+	}
+}
+
+static void* serverMain(void* arg)
+{
+	for (;;)
+	{
+		int fd = accept(httpListenFd, NULL, NULL);
+		if (fd < 0)
+			return NULL;
+
+		pthread_mutex_lock(&httpMutex);
+		httpAccepts++;
+		pthread_mutex_unlock(&httpMutex);
+
+		pthread_t thread;
+		pthread_create(&thread, NULL, serverConnection, (void*)(intptr_t)fd);
+		pthread_detach(thread);
+	}
+}
+
+static bool serverStart(void)
+{
+	struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+	socklen_t addrLen = sizeof(addr);
+
+	httpListenFd = socket(AF_INET, SOCK_STREAM, 0);
+	if (httpListenFd < 0 || bind(httpListenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(httpListenFd, 8) != 0
+		|| getsockname(httpListenFd, (struct sockaddr*)&addr, &addrLen) != 0)
+		return false;
+	httpPort = ntohs(addr.sin_port);
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, serverMain, NULL) != 0)
+		return false;
+	pthread_detach(thread);
+	return true;
+}
+
+static unsigned serverAccepts(void)
+{
+	pthread_mutex_lock(&httpMutex);
+	unsigned accepts = httpAccepts;
+	pthread_mutex_unlock(&httpMutex);
+	return accepts;
+}
+
+//---------------------------------------------------------------------------------
+// Tests
+//---------------------------------------------------------------------------------
+
+typedef struct
+{
+	char data[256];
+	size_t size;
+} bodyBuf;
+
+static bool collectBody(void* user, const void* data, size_t size)
+{
+	bodyBuf* body = (bodyBuf*)user;
+	if (body->size + size >= sizeof(body->data))
+		return false;
+	memcpy(body->data + body->size, data, size);
+	body->size += size;
+	body->data[body->size] = 0;
+	return true;
+}
+
+static int get(http_client_t* client, const char* path, const char* headers, bodyBuf* body, http_response_t* resp)
+{
+	char url[128];
+	snprintf(url, sizeof(url), "http://127.0.0.1:%u%s", httpPort, path);
+
+	http_request_t req = { .url = url, .headers = headers, .on_data = collectBody, .user = body };
+	memset(body, 0, sizeof(*body));
+	return http_perform(client, &req, resp);
+}
+
+static void testHttpRequests(http_client_t* client)
+{
+	http_response_t resp;
+	bodyBuf body;
+
+	unsigned accepts = serverAccepts();
+	TEST_CHECK(get(client, "/hello", NULL, &body, &resp) == 0);
+	TEST_CHECK(resp.status == 200 && resp.content_length == 5);
+	TEST_CHECK(strcmp(body.data, "hello") == 0);
+	TEST_CHECK(strcmp(resp.content_type, "text/plain") == 0);
+
+	char expected[128];
+	snprintf(expected, sizeof(expected), "GET /hello HTTP/1.1\r\nHost: 127.0.0.1:%u\r\nUser-Agent: ctrutest\r\n\r\n", httpPort);
+	pthread_mutex_lock(&httpMutex);
+	TEST_CHECK(strcmp(httpLastHead, expected) == 0);
+	pthread_mutex_unlock(&httpMutex);
+
+	// Same connection
+	TEST_CHECK(get(client, "/chunked", NULL, &body, &resp) == 0);
+	TEST_CHECK(resp.status == 200 && resp.content_length == UINT64_MAX);
+	TEST_CHECK(strcmp(body.data, "hello") == 0);
+	TEST_CHECK(get(client, "/continue", NULL, &body, &resp) == 0);
+	TEST_CHECK(resp.status == 204 && body.size == 0);
+	TEST_CHECK(get(client, "/missing", NULL, &body, &resp) == 0);
+	TEST_CHECK(resp.status == 404);
+	TEST_CHECK(serverAccepts() == accepts + 1);
+
+	// Body until the connection is closed
+	TEST_CHECK(get(client, "/eof", NULL, &body, &resp) == 0);
+	TEST_CHECK(strcmp(body.data, "until close") == 0);
+
+	// A kept-alive connection closed by the server is replaced transparently
+	TEST_CHECK(get(client, "/stale", NULL, &body, &resp) == 0);
+	usleep(10000);
+	accepts = serverAccepts();
+	TEST_CHECK(get(client, "/hello", NULL, &body, &resp) == 0);
+	TEST_CHECK(strcmp(body.data, "hello") == 0);
+	TEST_CHECK(serverAccepts() == accepts + 1);
+
+	// Request body and range
+	char url[128];
+	snprintf(url, sizeof(url), "http://127.0.0.1:%u/echo", httpPort);
+	http_request_t req = { .method = "POST", .url = url, .body = "payload", .body_size = 7, .range = true, .range_start = 2, .range_end = UINT64_MAX, .on_data = collectBody, .user = &body };
+	memset(&body, 0, sizeof(body));
+	TEST_CHECK(http_perform(client, &req, &resp) == 0);
+	TEST_CHECK(strcmp(body.data, "payload") == 0);
+	pthread_mutex_lock(&httpMutex);
+	TEST_CHECK(strstr(httpLastHead, "POST /echo HTTP/1.1\r\n") == httpLastHead);
+	TEST_CHECK(strstr(httpLastHead, "\r\nRange: bytes=2-\r\n") != NULL);
+	TEST_CHECK(strstr(httpLastHead, "\r\nContent-Length: 7\r\n") != NULL);
+	pthread_mutex_unlock(&httpMutex);
+
+	TEST_CHECK(get(client, "/hello#fragment", NULL, &body, &resp) == 0);
+	TEST_CHECK(strcmp(body.data, "hello") == 0);
+
+	// Nothing is listening on port 1
+	snprintf(url, sizeof(url), "http://127.0.0.1:1/");
+	http_request_t refused = { .url = url };
+	TEST_CHECK(http_perform(client, &refused, &resp) == HTTP_ERR_CONNECT);
+}
+
+static void testHttpHeadSize(http_client_t* client)
+{
+	static char headers[HTTP_TEST_HEAD_SIZE * 2];
+	http_response_t resp;
+	bodyBuf body;
+
+	// Length of the head without extra headers
+	char base[128];
+	size_t baseLen = snprintf(base, sizeof(base), "GET /hello HTTP/1.1\r\nHost: 127.0.0.1:%u\r\nUser-Agent: ctrutest\r\n\r\n", httpPort);
+
+	// Pads the extra headers so that the head (with its terminating NUL) is the given size
+	for (size_t total = HTTP_TEST_HEAD_SIZE - 2; total <= HTTP_TEST_HEAD_SIZE + 1; total ++)
+	{
+		size_t padLen = total - 1 - baseLen - strlen("X-Pad: \r\n");
+		strcpy(headers, "X-Pad: ");
+		memset(headers + 7, 'a', padLen);
+		strcpy(headers + 7 + padLen, "\r\n");
+
+		unsigned accepts = serverAccepts();
+		int rc = get(client, "/hello", headers, &body, &resp);
+		if (total <= HTTP_TEST_HEAD_SIZE)
+		{
+			TEST_CHECK(rc == 0 && strcmp(body.data, "hello") == 0);
+			pthread_mutex_lock(&httpMutex);
+			TEST_CHECK(strlen(httpLastHead) == total - 1);
+			pthread_mutex_unlock(&httpMutex);
+		} else
+		{
+			// Fails without sending anything
+			TEST_CHECK(rc != 0);
+			TEST_CHECK(serverAccepts() == accepts);
+		}
+	}
+
+	// Much larger than the head buffer, every header past the overflow is skipped
+	memset(headers, 'b', sizeof(headers) - 3);
+	memcpy(headers, "X-Big: ", 7);
+	strcpy(headers + sizeof(headers) - 3, "\r\n");
+	TEST_CHECK(get(client, "/hello", headers, &body, &resp) != 0);
+	client->user_agent = NULL;
+	TEST_CHECK(get(client, "/hello", headers, &body, &resp) != 0);
+	client->user_agent = "ctrutest";
+}
+
+void testHttp(void)
+{
+	if (!TEST_CHECK(serverStart()))
+		return;
+
+	http_client_t client;
+	http_client_init(&client, &sockTransport);
+	client.user_agent = "ctrutest";
+
+	testHttpRequests(&client);
+	testHttpHeadSize(&client);
+
+	http_client_exit(&client);
+}
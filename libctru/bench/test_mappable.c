@@ -0,0 +1,211 @@
+#include <stdint.h>
+#include <3ds/types.h>
+#include <3ds/svc.h>
+#include <3ds/result.h>
+#include <3ds/allocator/mappable.h>
+#include "test.h"
+
+#define MAP_TEST_BEGIN  0x10000000
+#define MAP_TEST_USER   0x40000000 // End of the simulated address space
+#define MAP_TEST_RANGES 64
+
+// Simulated address space: the mapped ranges, everything else is free
+typedef struct
+{
+	u32 addr, end;
+} mapRange;
+
+static mapRange mapRanges[MAP_TEST_RANGES];
+static u32 mapNumRanges, mapNumQueries;
+
+static void simMap(u32 addr, u32 size)
+{
+	mapRanges[mapNumRanges++] = (mapRange){ addr, addr + size };
+}
+
+static void simUnmap(u32 addr)
+{
+	for (u32 i = 0; i < mapNumRanges; i ++)
+	{
+		if (mapRanges[i].addr != addr)
+			continue;
+		mapRanges[i] = mapRanges[--mapNumRanges];
+		return;
+	}
+}
+
+static bool simOverlaps(u32 addr, u32 size)
+{
+	for (u32 i = 0; i < mapNumRanges; i ++)
+		if (addr < mapRanges[i].end && mapRanges[i].addr < addr + size)
+			return true;
+	return false;
+}
+
+static Result simQuery(MemInfo* info, u32 addr)
+{
+	mapNumQueries++;
+	u32 base = 0, end = MAP_TEST_USER;
+	for (u32 i = 0; i < mapNumRanges; i ++)
+	{
+		const mapRange* r = &mapRanges[i];
+		if (addr >= r->addr && addr < r->end)
+		{
+			info->base_addr = r->addr;
+			info->size = r->end - r->addr;
+			info->state = MEMSTATE_SHARED;
+			return 0;
+		}
+		if (r->end <= addr && r->end > base) base = r->end;
+		if (r->addr > addr && r->addr < end) end = r->addr;
+	}
+	info->base_addr = base;
+	info->size = end - base;
+	info->state = MEMSTATE_FREE;
+	return 0;
+}
+
+static void simReset(u32 size)
+{
+	mapNumRanges = 0;
+	mapNumQueries = 0;
+	mappableInit(MAP_TEST_BEGIN, MAP_TEST_BEGIN + size);
+	mappableSetQueryFunc(simQuery);
+}
+
+// Allocates and maps an area like a user of the allocator would, returns 0 on failure
+static u32 allocMap(u32 size, u32 alignment)
+{
+	u32 addr = (u32)(uintptr_t)mappableAllocAligned(size, alignment);
+	if (!addr)
+		return 0;
+	TEST_CHECK(addr >= MAP_TEST_BEGIN && !(addr & (alignment - 1)));
+	TEST_CHECK(!simOverlaps(addr, size));
+	simMap(addr, size);
+	return addr;
+}
+
+static void unmapFree(u32 addr)
+{
+	simUnmap(addr);
+	mappableFree((void*)(uintptr_t)addr);
+}
+
+static void testMappableQueries(void)
+{
+	simReset(0x4000000);
+
+	// One query finds a large free area, the allocations within it don't need any more
+	u32 a = allocMap(0x3000, 0x1000);
+	TEST_CHECK(a == MAP_TEST_BEGIN);
+	TEST_CHECK(mapNumQueries == 1);
+	u32 b = allocMap(0x1000, 0x1000);
+	TEST_CHECK(b == MAP_TEST_BEGIN + 0x3000);
+	u32 c = allocMap(0x10000, 0x10000);
+	TEST_CHECK(c == MAP_TEST_BEGIN + 0x10000);
+	TEST_CHECK(mapNumQueries == 1);
+
+	// Freed pages are reused first, still without querying
+	unmapFree(a);
+	TEST_CHECK(allocMap(0x2000, 0x1000) == MAP_TEST_BEGIN);
+	TEST_CHECK(mapNumQueries == 1);
+
+	// The whole allocation is released
+	unmapFree(c);
+	TEST_CHECK(allocMap(0x10000, 0x1000) == MAP_TEST_BEGIN + 0x4000);
+	unmapFree(b);
+}
+
+static void testMappableExternal(void)
+{
+	simReset(0x10000);
+
+	// Area mapped by other means in the middle
+	simMap(MAP_TEST_BEGIN + 0x4000, 0x4000);
+	u32 a = allocMap(0x4000, 0x1000);
+	TEST_CHECK(a == MAP_TEST_BEGIN);
+	u32 b = allocMap(0x2000, 0x1000);
+	TEST_CHECK(b == MAP_TEST_BEGIN + 0x8000);
+	u32 queries = mapNumQueries;
+
+	// The external area isn't queried again while there's space elsewhere
+	u32 c = allocMap(0x2000, 0x1000);
+	TEST_CHECK(c == MAP_TEST_BEGIN + 0xA000);
+	TEST_CHECK(mapNumQueries == queries);
+
+	// Not enough space, even after checking the external area again
+	TEST_CHECK(!allocMap(0x8000, 0x1000));
+
+	// Once the external area is unmapped, its pages are usable again
+	simUnmap(MAP_TEST_BEGIN + 0x4000);
+	unmapFree(b);
+	unmapFree(c);
+	u32 d = allocMap(0xC000, 0x1000);
+	TEST_CHECK(d == MAP_TEST_BEGIN + 0x4000);
+	unmapFree(a);
+	unmapFree(d);
+
+	// The whole area
+	TEST_CHECK(allocMap(0x10000, 0x1000) == MAP_TEST_BEGIN);
+	TEST_CHECK(!allocMap(0x1000, 0x1000));
+}
+
+static void testMappableStress(void)
+{
+	u32 live[32] = { 0 };
+	u32 external[16];
+	u32 numAllocs = 0;
+	simReset(0x100000);
+
+	// Areas mapped by other means before the allocator is used, they are unmapped over time
+	for (u32 i = 0; i < 16; i ++)
+	{
+		external[i] = MAP_TEST_BEGIN + i * 0x10000 + (testRand() % 12) * 0x1000;
+		simMap(external[i], 0x3000);
+	}
+
+	for (u32 iter = 0; iter < 20000; iter ++)
+	{
+		u32 r = testRand();
+		u32 slot = r % 32;
+
+		if ((r >> 8) % 256 == 0)
+		{
+			u32 i = (r >> 16) % 16;
+			simUnmap(external[i]);
+			continue;
+		}
+
+		if (live[slot])
+		{
+			unmapFree(live[slot]);
+			live[slot] = 0;
+		} else
+		{
+			u32 size = (1 + (r >> 8) % 16) * 0x1000;
+			u32 alignment = 0x1000 << ((r >> 16) % 4);
+			live[slot] = allocMap(size, alignment);
+			numAllocs++;
+		}
+	}
+
+	// Most allocations were done without any query
+	TEST_CHECK(mapNumQueries < numAllocs / 4);
+
+	for (u32 i = 0; i < 32; i ++)
+		if (live[i])
+			unmapFree(live[i]);
+
+	// Everything was unmapped in the end, so the whole area can be allocated again
+	for (u32 i = 0; i < 16; i ++)
+		simUnmap(external[i]);
+	TEST_CHECK(allocMap(0x100000, 0x1000) == MAP_TEST_BEGIN);
+}
+
+void testMappable(void)
+{
+	testMappableQueries();
+	testMappableExternal();
+	testMappableStress();
+	mappableSetQueryFunc(NULL);
+}
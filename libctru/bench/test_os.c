@@ -0,0 +1,130 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <3ds/types.h>
+#include <3ds/result.h>
+#include <3ds/os.h>
+#include "test.h"
+
+#define OS_TEST_CHUNK 4096
+
+// The region lookup as it was written before the region table
+static u32 refConvertVirtToPhys(u32 vaddr)
+{
+#define CONVERT_REGION(_name) \
+	if (vaddr >= OS_##_name##_VADDR && vaddr < (OS_##_name##_VADDR + OS_##_name##_SIZE)) \
+		return vaddr + (OS_##_name##_PADDR - OS_##_name##_VADDR);
+
+	CONVERT_REGION(FCRAM);
+	CONVERT_REGION(VRAM);
+	CONVERT_REGION(OLD_FCRAM);
+	CONVERT_REGION(DSPRAM);
+	CONVERT_REGION(QTMRAM);
+	CONVERT_REGION(MMIO);
+
+#undef CONVERT_REGION
+	return 0;
+}
+
+static const void* osTestPtr(u32 vaddr)
+{
+	return (const void*)(uintptr_t)vaddr;
+}
+
+// Converts every 32-bit address, returns false (printing the address) on the first mismatch
+static bool checkAllAddresses(void)
+{
+	static const void* in[OS_TEST_CHUNK];
+	static u32 out[OS_TEST_CHUNK], ref[OS_TEST_CHUNK];
+
+	u32 vaddr = 0;
+	do
+	{
+		size_t expected = 0;
+		for (u32 i = 0; i < OS_TEST_CHUNK; i ++)
+		{
+			in[i] = osTestPtr(vaddr + i);
+			ref[i] = refConvertVirtToPhys(vaddr + i);
+			if (ref[i])
+				expected ++;
+		}
+
+		if (osConvertVirtToPhysBatch(out, in, OS_TEST_CHUNK) != expected)
+		{
+			printf("phys batch count mismatch at 0x%08X\n", vaddr);
+			return false;
+		}
+		for (u32 i = 0; i < OS_TEST_CHUNK; i ++)
+		{
+			if (out[i] != ref[i])
+			{
+				printf("phys mismatch for 0x%08X\n", vaddr + i);
+				return false;
+			}
+		}
+
+		// The single conversion shares the lookup, check it on a few addresses of each page
+		for (u32 i = 0; i < OS_TEST_CHUNK; i += 0x3FF)
+		{
+			if (osConvertVirtToPhys(in[i]) != out[i])
+			{
+				printf("phys mismatch for 0x%08X\n", vaddr + i);
+				return false;
+			}
+		}
+
+		vaddr += OS_TEST_CHUNK;
+	} while (vaddr);
+	return true;
+}
+
+static void testPhysRegions(void)
+{
+	TEST_CHECK(checkAllAddresses());
+}
+
+static void testPhysMappings(void)
+{
+	// Fixed regions can't be overridden
+	TEST_CHECK(R_FAILED(osRegisterPhysMapping(osTestPtr(OS_VRAM_VADDR), 0x20000000, 0x1000)));
+	TEST_CHECK(R_FAILED(osRegisterPhysMapping(osTestPtr(OS_FCRAM_VADDR - 0x1000), 0x20000000, 0x2000)));
+	TEST_CHECK(R_FAILED(osRegisterPhysMapping(osTestPtr(0x10000000), 0x20000000, 0)));
+	TEST_CHECK(R_FAILED(osRegisterPhysMapping(osTestPtr(0xFFFFF000), 0x20000000, 0x2000)));
+
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x10000000)) == 0);
+	TEST_CHECK(R_SUCCEEDED(osRegisterPhysMapping(osTestPtr(0x10000000), 0x20000000, 0x3000)));
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x10000000)) == 0x20000000);
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x10002FFF)) == 0x20002FFF);
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x10003000)) == 0);
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x0FFFFFFF)) == 0);
+	TEST_CHECK(osConvertVirtToPhys(NULL) == 0);
+
+	// Fixed regions are unaffected
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(OS_FCRAM_VADDR)) == OS_FCRAM_PADDR);
+
+	// Overlapping mappings are rejected
+	TEST_CHECK(R_FAILED(osRegisterPhysMapping(osTestPtr(0x10002000), 0x21000000, 0x2000)));
+	TEST_CHECK(R_FAILED(osRegisterPhysMapping(osTestPtr(0x0FFFF000), 0x21000000, 0x2000)));
+
+	// The table is limited
+	u32 registered = 1;
+	while (R_SUCCEEDED(osRegisterPhysMapping(osTestPtr(0x11000000 + registered*0x10000), 0x22000000 + registered*0x10000, 0x1000)))
+		registered ++;
+	TEST_CHECK(registered == OS_MAX_PHYS_MAPPINGS);
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x11000000 + (OS_MAX_PHYS_MAPPINGS-1)*0x10000 + 0x10)) == 0x22000000 + (OS_MAX_PHYS_MAPPINGS-1)*0x10000 + 0x10);
+
+	// Unregistering keeps the other mappings
+	TEST_CHECK(R_SUCCEEDED(osUnregisterPhysMapping(osTestPtr(0x10000000))));
+	TEST_CHECK(R_FAILED(osUnregisterPhysMapping(osTestPtr(0x10000000))));
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x10000000)) == 0);
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x11010000)) == 0x22010000);
+
+	for (u32 i = 1; i < registered; i ++)
+		TEST_CHECK(R_SUCCEEDED(osUnregisterPhysMapping(osTestPtr(0x11000000 + i*0x10000))));
+	TEST_CHECK(osConvertVirtToPhys(osTestPtr(0x11010000)) == 0);
+}
+
+void testOs(void)
+{
+	testPhysRegions();
+	testPhysMappings();
+}
@@ -0,0 +1,75 @@
+#include <3ds/types.h>
+#include "../source/services/soc/soc_session.h"
+#include "test.h"
+
+static void testSessionPick(void)
+{
+	socSessionPool_s pool = { .handles = { 0x100 }, .numSessions = 1, .maxSessions = SOC_MAX_SESSIONS };
+
+	// A single free session is kept for short calls while the pool can grow
+	TEST_CHECK(socSessionPick(&pool, -1, false) == 0);
+	TEST_CHECK(socSessionPick(&pool, -1, true) == SOC_SESSION_GROW);
+
+	// Nothing free: grow, or wait once the pool is full
+	pool.busyMask = BIT(0);
+	TEST_CHECK(socSessionPick(&pool, -1, false) == SOC_SESSION_GROW);
+	TEST_CHECK(socSessionPick(&pool, 0, true) == SOC_SESSION_GROW);
+	pool.maxSessions = 1;
+	TEST_CHECK(socSessionPick(&pool, -1, false) == SOC_SESSION_WAIT);
+	TEST_CHECK(socSessionPick(&pool, -1, true) == SOC_SESSION_WAIT);
+
+	// The last free session goes to blocking calls too when the pool can't grow
+	pool.busyMask = 0;
+	TEST_CHECK(socSessionPick(&pool, -1, true) == 0);
+
+	// Sessions being opened by other threads count towards the limit
+	pool.maxSessions = 4;
+	pool.busyMask = BIT(0);
+	pool.numOpening = 3;
+	TEST_CHECK(socSessionPick(&pool, -1, false) == SOC_SESSION_WAIT);
+	pool.numOpening = 2;
+	TEST_CHECK(socSessionPick(&pool, -1, false) == SOC_SESSION_GROW);
+	pool.numOpening = 0;
+
+	// The preferred session is used when free, otherwise the first free one
+	pool.numSessions = 4;
+	pool.busyMask = BIT(0) | BIT(2);
+	TEST_CHECK(socSessionPick(&pool, 3, false) == 3);
+	TEST_CHECK(socSessionPick(&pool, 2, false) == 1);
+	TEST_CHECK(socSessionPick(&pool, -1, false) == 1);
+	TEST_CHECK(socSessionPick(&pool, 3, true) == 3);
+
+	// Sessions past numSessions are never picked
+	pool.busyMask = 0xF;
+	TEST_CHECK(socSessionPick(&pool, 5, false) == SOC_SESSION_WAIT);
+	pool.maxSessions = SOC_MAX_SESSIONS;
+	TEST_CHECK(socSessionPick(&pool, 5, false) == SOC_SESSION_GROW);
+
+	// Blocking calls leave the last free session alone
+	pool.busyMask = 0x7;
+	TEST_CHECK(socSessionPick(&pool, 3, false) == 3);
+	TEST_CHECK(socSessionPick(&pool, 3, true) == SOC_SESSION_GROW);
+
+	// A full pool of the maximum size
+	pool.numSessions = SOC_MAX_SESSIONS;
+	pool.busyMask = BIT(SOC_MAX_SESSIONS) - 1;
+	TEST_CHECK(socSessionPick(&pool, -1, false) == SOC_SESSION_WAIT);
+	pool.busyMask &= ~BIT(SOC_MAX_SESSIONS-1);
+	TEST_CHECK(socSessionPick(&pool, -1, true) == SOC_MAX_SESSIONS-1);
+}
+
+static void testSessionFind(void)
+{
+	socSessionPool_s pool = { .handles = { 0x100, 0x200, 0x300 }, .numSessions = 2, .maxSessions = SOC_MAX_SESSIONS };
+
+	TEST_CHECK(socSessionFind(&pool, 0x100) == 0);
+	TEST_CHECK(socSessionFind(&pool, 0x200) == 1);
+	TEST_CHECK(socSessionFind(&pool, 0x300) == -1);
+	TEST_CHECK(socSessionFind(&pool, 0x400) == -1);
+}
+
+void testSoc(void)
+{
+	testSessionPick();
+	testSessionFind();
+}
@@ -28,11 +28,15 @@ extern "C" {
 #include <3ds/console.h>
 #include <3ds/env.h>
 #include <3ds/util/decompress.h>
+#include <3ds/util/http.h>
 #include <3ds/util/utf.h>
 
 #include <3ds/allocator/linear.h>
 #include <3ds/allocator/mappable.h>
 #include <3ds/allocator/vram.h>
+#include <3ds/allocator/arena.h>
+#include <3ds/allocator/heap.h>
+#include <3ds/allocator/fastmalloc.h>
 
 #include <3ds/services/ac.h>
 #include <3ds/services/am.h>
@@ -84,6 +88,9 @@ extern "C" {
 #include <3ds/gpu/gpu.h>
 #include <3ds/gpu/shbin.h>
 #include <3ds/gpu/shaderProgram.h>
+#include <3ds/gpu/streambuf.h>
+#include <3ds/gpu/texupload.h>
+#include <3ds/gpu/cmddecode.h>
 
 #include <3ds/ndsp/ndsp.h>
 #include <3ds/ndsp/channel.h>
@@ -0,0 +1,104 @@
+/**
+ * @file arena.h
+ * @brief Per-frame linear memory arena allocator.
+ *
+ * The arena carves a single block out of linear memory and splits it into a fixed number of
+ * frame regions. Allocations within a frame are simple pointer bumps, and a frame's region is
+ * recycled as a whole once the fence associated to it has been signaled (usually from a GSP
+ * event callback or a GX command queue callback once the GPU is done with the data).
+ */
+#pragma once
+
+#include <3ds/types.h>
+#include <3ds/synchronization.h>
+
+/// Linear arena frame region.
+typedef struct
+{
+	LightEvent fence; ///< Signaled once the GPU no longer uses the data of this frame.
+	u32 used;         ///< Number of bytes allocated in this frame when it was ended.
+	bool pending;     ///< Whether the frame has been ended and is waiting for its fence.
+} linearArenaFrame_s;
+
+/// Linear arena.
+typedef struct
+{
+	u8* base;                   ///< Linear memory block backing the arena.
+	u32 frameSize;              ///< Size of each frame region.
+	u32 numFrames;              ///< Number of frame regions (frames in flight).
+	u32 curFrame;               ///< Index of the frame currently being recorded.
+	u32 offset;                 ///< Allocation offset within the current frame region.
+	u32 peak;                   ///< Highest number of bytes used by a single frame.
+	linearArenaFrame_s* frames; ///< Frame region array.
+} linearArena_s;
+
+/**
+ * @brief Initializes a linear arena.
+ * @param arena Arena to initialize.
+ * @param frameSize Size of each frame region (rounded up to 0x80 bytes).
+ * @param numFrames Number of frames that can be in flight at the same time.
+ * @return true on success, false on failure.
+ */
+bool linearArenaInit(linearArena_s* arena, u32 frameSize, u32 numFrames);
+
+/**
+ * @brief Waits for all pending frames and frees the memory used by a linear arena.
+ * @param arena Arena to free.
+ */
+void linearArenaExit(linearArena_s* arena);
+
+/**
+ * @brief Begins a new frame, recycling the oldest frame region.
+ * @param arena Arena to use.
+ * @param timeout Timeout (in nanoseconds) to wait for the fence of the region to be recycled (specify -1 for no timeout).
+ * @return false if the timeout expired (in which case no frame is begun), true otherwise.
+ */
+bool linearArenaBeginFrame(linearArena_s* arena, s64 timeout);
+
+/**
+ * @brief Ends the current frame.
+ * @param arena Arena to use.
+ * @return The frame region, which must be passed to \ref linearArenaSignalFrame once the GPU is done with it.
+ * @note The returned pointer can directly be used as the data of a one-shot \ref gspSetEventCallback callback.
+ */
+linearArenaFrame_s* linearArenaEndFrame(linearArena_s* arena);
+
+/**
+ * @brief Signals the fence of a frame region, allowing it to be recycled.
+ * @param frame Frame region (as returned by \ref linearArenaEndFrame).
+ * @note This function has a ThreadFunc compatible signature so that it can be used as a GSP event callback.
+ */
+void linearArenaSignalFrame(void* frame);
+
+/**
+ * @brief Flushes the data cache for the memory allocated so far in the current frame.
+ * @param arena Arena to use.
+ * @return The result of the flush operation.
+ */
+Result linearArenaFlush(linearArena_s* arena);
+
+/**
+ * @brief Allocates memory from the current frame of a linear arena.
+ * @param arena Arena to allocate from.
+ * @param size Size of the allocation.
+ * @param alignment Alignment of the allocation (must be a power of two, and no greater than 0x80).
+ * @return The allocated buffer, or NULL if the frame region is exhausted or no frame is begun.
+ */
+static inline void* linearArenaAlloc(linearArena_s* arena, u32 size, u32 alignment)
+{
+	u32 offset = (arena->offset + alignment - 1) &~ (alignment - 1);
+	if (offset > arena->frameSize || size > arena->frameSize - offset)
+		return NULL;
+	arena->offset = offset + size;
+	return arena->base + arena->curFrame*arena->frameSize + offset;
+}
+
+/**
+ * @brief Gets the amount of free space in the current frame of a linear arena.
+ * @param arena Arena to use.
+ * @return The free space in bytes.
+ */
+static inline u32 linearArenaSpaceFree(const linearArena_s* arena)
+{
+	return arena->offset < arena->frameSize ? arena->frameSize - arena->offset : 0;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file fastmalloc.h
+ * @brief Thread-caching size-class allocator for the application heap.
+ *
+ * This allocator can replace newlib's malloc for applications which allocate heavily from several
+ * threads. Small requests are served from per-thread caches of size-class objects, which are refilled
+ * in batches from central per-class span lists; large requests and spans come from a page heap over
+ * the application heap (obtained with sbrk).
+ *
+ * It is selected at link time by wrapping newlib's reentrant allocation functions, e.g. by adding the
+ * following to the application's LDFLAGS:
+ *
+ *     -Wl,--wrap=_malloc_r,--wrap=_free_r,--wrap=_calloc_r,--wrap=_realloc_r,--wrap=_memalign_r,--wrap=_malloc_usable_size_r
+ *
+ * malloc, free, memalign etc. (including the calls made by newlib itself) then go through it.
+ */
+#pragma once
+
+#include <3ds/types.h>
+
+/// Allocator statistics.
+typedef struct
+{
+	size_t heapSize;      ///< Memory obtained from the application heap.
+	size_t pageHeapFree;  ///< Free memory in the page heap.
+	size_t smallSpans;    ///< Memory used by small object spans (objects in use or cached).
+	size_t largeInUse;    ///< Memory used by large allocations.
+	size_t metadata;      ///< Memory used by the allocator metadata.
+	size_t threadCached;  ///< Free objects held by the cache of the calling thread.
+} fastMallocStats;
+
+/**
+ * @brief Retrieves allocator statistics.
+ * @param stats Output statistics.
+ */
+void fastMallocGetStats(fastMallocStats* stats);
+
+/**
+ * @brief Returns the objects cached by the calling thread to the central lists.
+ * @note This is done automatically when a libctru thread exits.
+ */
+void fastMallocFlushThreadCache(void);
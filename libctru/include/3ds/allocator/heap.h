@@ -0,0 +1,43 @@
+/**
+ * @file heap.h
+ * @brief Heap pool management and usage statistics.
+ *
+ * Commit memory which isn't given to the application heap or to the initial linear heap at startup is
+ * kept in a shared pool. The linear heap grows from the pool on demand, the application heap can be
+ * grown from it explicitly, and free tail pages of both heaps can be returned to it.
+ */
+#pragma once
+
+#include <3ds/types.h>
+
+/// Heap usage statistics.
+typedef struct
+{
+	u32 heapSize;           ///< Committed size of the application heap.
+	u32 heapUsed;           ///< Size of the application heap below the program break.
+	u32 linearSize;         ///< Committed size of the linear heap.
+	u32 linearUsed;         ///< Size of the allocated linear memory.
+	u32 linearPeakUsed;     ///< Peak size of the allocated linear memory.
+	u32 poolSize;           ///< Size of the pool, i.e. memory that can still be committed to either heap.
+	u32 linearGrowCount;    ///< Number of times the linear heap was grown from the pool.
+	u32 linearGrowFailures; ///< Number of linear allocations that failed even after trying to grow the heap.
+} HeapStats;
+
+/**
+ * @brief Grows the application heap using memory from the pool.
+ * @param size Size to grow the heap by (rounded up to a page).
+ * @return The result of the operation.
+ */
+Result heapGrow(u32 size);
+
+/**
+ * @brief Returns the free pages at the end of the application heap to the pool.
+ * @return The amount of memory returned to the pool.
+ */
+u32 heapTrim(void);
+
+/**
+ * @brief Retrieves heap usage statistics.
+ * @param stats Output statistics.
+ */
+void heapGetStats(HeapStats* stats);
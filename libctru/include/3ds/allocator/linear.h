@@ -44,6 +44,12 @@ void linearFree(void* mem);
 
 /**
  * @brief Gets the current linear free space.
- * @return The current linear free space.
+ * @return The current linear free space, including the memory that the linear heap can still grow into.
  */
 u32 linearSpaceFree(void);
+
+/**
+ * @brief Returns linear memory which was committed on demand and is now entirely free to the heap pool.
+ * @return The amount of memory returned to the pool.
+ */
+u32 linearTrim(void);
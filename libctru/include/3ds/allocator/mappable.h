@@ -5,14 +5,31 @@
 #pragma once
 
 #include <3ds/types.h>
+#include <3ds/svc.h>
+
+/**
+ * @brief Memory query function used by the mappable allocator to detect areas mapped by other means.
+ * @param info Output memory info of the block containing the address.
+ * @param addr Address to query.
+ */
+typedef Result (*mappableQueryFunc)(MemInfo* info, u32 addr);
 
 /**
  * @brief Initializes the mappable allocator.
  * @param addrMin Minimum address.
  * @param addrMax Maxium address.
+ * Areas mapped without this allocator are detected with memory queries. Areas that were seen free are
+ * not queried again, so such mappings have to be done before the allocator is used (or with an area
+ * allocated from it).
  */
 void mappableInit(u32 addrMin, u32 addrMax);
 
+/**
+ * @brief Sets the memory query function used by the mappable allocator.
+ * @param func Query function, or NULL for the default one (svcQueryMemory).
+ */
+void mappableSetQueryFunc(mappableQueryFunc func);
+
 /**
  * @brief Finds a mappable memory area.
  * @param size Size of the area to find.
@@ -21,7 +38,15 @@ void mappableInit(u32 addrMin, u32 addrMax);
 void* mappableAlloc(size_t size);
 
 /**
- * @brief Frees a mappable area (stubbed).
+ * @brief Finds a mappable memory area with the specified alignment.
+ * @param size Size of the area to find.
+ * @param alignment Alignment of the area, must be a power of two (at least a page).
+ * @return The mappable area.
+ */
+void* mappableAllocAligned(size_t size, size_t alignment);
+
+/**
+ * @brief Frees a mappable area. The area must be unmapped first: it can be returned again without checking it.
  * @param mem Mappable area to free.
  */
 void mappableFree(void* mem);
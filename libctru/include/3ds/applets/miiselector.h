@@ -92,6 +92,23 @@ void miiSelectorInit(MiiSelectorConf *conf);
  */
 void miiSelectorLaunch(const MiiSelectorConf *conf, MiiSelectorReturn* returnbuf);
 
+/**
+ * @brief Launch the Mii selector library applet without waiting for it to close
+ *
+ * @param conf Configuration determining how the applet should behave
+ * @return false if a Mii selector launched this way is still up
+ */
+bool miiSelectorLaunchAsync(const MiiSelectorConf *conf);
+
+/**
+ * @brief Check whether the Mii selector launched with \ref miiSelectorLaunchAsync was closed, without blocking
+ *
+ * @param returnbuf Buffer receiving the result of the applet once it closed (can be NULL)
+ * @return true if the applet was closed, false if it is still up or if no applet launched with \ref miiSelectorLaunchAsync is in flight
+ * (the closing of an applet is only reported once)
+ */
+bool miiSelectorPoll(MiiSelectorReturn* returnbuf);
+
 /**
  * @brief Sets title of the Mii selector library applet
  *
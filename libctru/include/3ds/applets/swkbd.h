@@ -310,6 +310,30 @@ void swkbdSetFilterCallback(SwkbdState* swkbd, SwkbdCallbackFn callback, void* u
  */
 SwkbdButton swkbdInputText(SwkbdState* swkbd, char* buf, size_t bufsize);
 
+/**
+ * @brief Launches a software keyboard without waiting for it to close.
+ * @param swkbd Pointer to swkbd state, which must stay valid until the keyboard closes.
+ * @return true if the keyboard was launched, false otherwise - in that case use swkbdGetResult to check the condition.
+ * Only one keyboard can be up at a time. See \ref aptLaunchLibraryAppletAsync for what the application may do meanwhile.
+ */
+bool swkbdInputTextAsync(SwkbdState* swkbd);
+
+/**
+ * @brief Checks whether a software keyboard launched with \ref swkbdInputTextAsync was closed, without blocking.
+ * @param swkbd Pointer to swkbd state.
+ * @param buf Pointer to output buffer which will hold the inputted text.
+ * @param bufsize Maximum number of UTF-8 code units that the buffer can hold (including null terminator).
+ * @param button Pointer to output the identifier of the dialog button that was pressed (see \ref swkbdInputText).
+ * @return true if the keyboard was closed, false if it is still up or if no keyboard launched with \ref swkbdInputTextAsync is in flight.
+ * The closing of a keyboard is only reported once, by the call which outputs its result.
+ */
+bool swkbdInputTextPoll(SwkbdState* swkbd, char* buf, size_t bufsize, SwkbdButton* button);
+
+/**
+ * @brief Frees the shared memory block kept by the software keyboard between invocations.
+ */
+void swkbdFreeSharedMem(void);
+
 /**
  * @brief Retrieves the result condition of a software keyboard after it has been used.
  * @param swkbd Pointer to swkbd state.
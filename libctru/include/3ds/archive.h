@@ -32,6 +32,41 @@ Result archiveMount(FS_ArchiveID archiveID, FS_Path archivePath, const char *dev
 /// Returns -1 if the specified device is not found
 Result archiveCommitSaveData(const char *deviceName);
 
+/// Gets the free space of a device, cached and updated as files are written through the device (also used by statvfs)
+/// Returns -1 if the specified device is not found
+Result archiveGetFreeBytes(const char *deviceName, u64 *freeBytes);
+
+/// Save data transaction, see \ref archiveTransactionBegin
+typedef struct archiveTransaction archiveTransaction;
+
+/// Starts a transaction on a save data archive mounted with archiveMount.
+/// Writes are staged in memory (only the modified ranges of 4 KiB blocks are kept) until the transaction is committed.
+/// Returns -1 if the specified device is not found or isn't a save data archive
+Result archiveTransactionBegin(archiveTransaction **txn, const char *deviceName);
+
+/// Stages a write to a file, which is created at commit if it doesn't exist
+/// Returns -1 (with errno set) if the path is invalid
+Result archiveTransactionWrite(archiveTransaction *txn, const char *path, u64 offset, const void *data, u32 size);
+
+/// Stages a change of the size of a file, discarding the staged writes past the new end of file
+Result archiveTransactionSetSize(archiveTransaction *txn, const char *path, u64 size);
+
+/// Reads a file as it would be after the commit of the transaction
+Result archiveTransactionRead(archiveTransaction *txn, const char *path, u64 offset, void *buffer, u32 size, u32 *bytesRead);
+
+/// Returns the amount of memory used by the data staged in a transaction
+size_t archiveTransactionGetStagedSize(archiveTransaction *txn);
+
+/// Writes the staged data of all the files, coalescing contiguous modified blocks, then commits the save data once.
+/// If a write or the commit fails, the archive is reopened to discard the pending changes, including the uncommitted
+/// changes made outside of the transaction. This invalidates the files and directories still open on the device,
+/// which must be closed and reopened. If the archive can't be reopened, the device is unmounted and the error of the
+/// reopen is returned instead of the original one. The transaction is freed in all cases.
+Result archiveTransactionCommit(archiveTransaction *txn);
+
+/// Discards a transaction and its staged data
+void archiveTransactionAbort(archiveTransaction *txn);
+
 /// Unmounts the specified device, closing its archive in the process
 /// Returns -1 if the specified device was not found
 Result archiveUnmount(const char *deviceName);
@@ -0,0 +1,94 @@
+/**
+ * @file cmddecode.h
+ * @brief GPU command buffer decoder and validator.
+ *
+ * The decoder walks GPU command buffers (as built by the GPUCMD_* functions), interprets the command
+ * headers and keeps track of the resulting register state. It reports malformed commands as well as
+ * wasted ones (writes that do not change anything, or that are overwritten before being used) and
+ * counts the writes done to each register. It only depends on plain C, so it can be used both in
+ * debug builds on the console and in host-side tools.
+ */
+#pragma once
+
+#include <3ds/types.h>
+
+/// Number of GPU registers.
+#define GPUREG_COUNT 0x400
+
+/// GPU command buffer issue types.
+typedef enum
+{
+	GPUCMD_ISSUE_TRUNCATED = 0,  ///< The command extends past the end of the buffer.
+	GPUCMD_ISSUE_RESERVED_BITS,  ///< The command header has reserved bits set.
+	GPUCMD_ISSUE_REG_OVERFLOW,   ///< An incremental write goes past the last register.
+	GPUCMD_ISSUE_ZERO_MASK,      ///< The write mask is empty, so the write has no effect.
+	GPUCMD_ISSUE_REDUNDANT,      ///< The write does not change the value of the register.
+	GPUCMD_ISSUE_OVERWRITTEN,    ///< The previous value of the register was overwritten before being used by a draw or trigger.
+	GPUCMD_ISSUE_UNALIGNED_SIZE, ///< The size of the buffer is not a multiple of 16 bytes.
+
+	GPUCMD_ISSUE_MAX,            ///< Number of issue types.
+} GPUCMD_ISSUE;
+
+/// GPU command buffer issue.
+typedef struct
+{
+	GPUCMD_ISSUE type; ///< Issue type.
+	u32 offset;        ///< Offset (in words) of the command within the decoded buffer.
+	u16 reg;           ///< Register involved in the issue.
+	u32 value;         ///< Value written to the register.
+} gpuCmdIssue_s;
+
+/// GPU command buffer decoder.
+typedef struct
+{
+	u32 values[GPUREG_COUNT];           ///< Last written value of each register.
+	u32 writeCounts[GPUREG_COUNT];      ///< Number of writes done to each register.
+	u32 known[GPUREG_COUNT/32];         ///< Bitmap of registers whose whole value is known.
+	u32 pending[GPUREG_COUNT/32];       ///< Bitmap of registers written since the last draw or trigger.
+	u32 numCommands;                    ///< Number of decoded commands.
+	u32 numWrites;                      ///< Number of decoded register writes.
+	u32 numIssues[GPUCMD_ISSUE_MAX];    ///< Number of issues found, by type.
+	void (* callback)(const gpuCmdIssue_s* issue, void* user); ///< Issue callback.
+	void* user;                         ///< Data for the issue callback.
+} gpuCmdDecoder_s;
+
+/**
+ * @brief Initializes a GPU command buffer decoder.
+ * @param dec Decoder to initialize.
+ */
+void gpuCmdDecoderInit(gpuCmdDecoder_s* dec);
+
+/**
+ * @brief Sets the callback called for every issue found by a GPU command buffer decoder.
+ * @param dec Decoder to use.
+ * @param callback Issue callback.
+ * @param user User data.
+ */
+static inline void gpuCmdDecoderSetCallback(gpuCmdDecoder_s* dec, void (* callback)(const gpuCmdIssue_s*, void*), void* user)
+{
+	dec->callback = callback;
+	dec->user = user;
+}
+
+/**
+ * @brief Decodes a GPU command buffer.
+ * @param dec Decoder to use. Register state is kept across calls, so consecutive buffers can be decoded in order.
+ * @param buf Command buffer to decode.
+ * @param size Size (in words) of the command buffer.
+ * @return false if the buffer is malformed (truncated or with invalid headers), true otherwise.
+ */
+bool gpuCmdDecode(gpuCmdDecoder_s* dec, const u32* buf, u32 size);
+
+/**
+ * @brief Gets the name of a GPU register.
+ * @param reg Register ID.
+ * @return The name of the register (without the GPUREG_ prefix), or NULL if it is unknown.
+ */
+const char* gpuCmdGetRegName(u16 reg);
+
+/**
+ * @brief Gets a short description of a GPU command buffer issue type.
+ * @param type Issue type.
+ * @return The description of the issue type.
+ */
+const char* gpuCmdGetIssueName(GPUCMD_ISSUE type);
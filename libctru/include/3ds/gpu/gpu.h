@@ -99,6 +99,31 @@ u32 f32tof24(float f);
  */
 u32 f32tof31(float f);
 
+/**
+ * @brief Converts an array of 32-bit floats to 24-bit floats.
+ * @param out Output array (one word per converted float).
+ * @param in Floats to convert.
+ * @param count Number of floats to convert.
+ */
+void f32tof24Array(u32* out, const float* in, u32 count);
+
+/**
+ * @brief Converts an array of 32-bit float vectors to packed 24-bit float uniform data.
+ * @param out Output buffer (three words per vector), in the layout expected by the float uniform data registers.
+ * @param in Vectors to convert (four floats per vector, in x, y, z, w order).
+ * @param numVec4 Number of vectors to convert.
+ */
+void f32tof24Vec4Pack(u32* out, const float* in, u32 numVec4);
+
+/**
+ * @brief Adds commands uploading 24-bit float uniforms to the current command buffer.
+ * @param type Type of shader to upload the uniforms to.
+ * @param startreg First float uniform register to write.
+ * @param data Vectors to upload (four 32-bit floats per vector, in x, y, z, w order).
+ * @param numVec4 Number of vectors to upload.
+ */
+void GPUCMD_AddFloatUniforms(GPU_SHADER_TYPE type, u32 startreg, const float* data, u32 numVec4);
+
 /// Adds a command with a single parameter to the current command buffer.
 static inline void GPUCMD_AddSingleParam(u32 header, u32 param)
 {
@@ -107,15 +107,23 @@ void gxCmdQueueAdd(gxCmdQueue_s* queue, const gxCmdEntry_s* entry);
 /**
  * @brief Runs a GX command queue, causing it to begin processing incoming commands as they arrive.
  * @param queue The GX command queue.
+ * @return false if another GX command queue is still processing commands (the queue is then not run), true otherwise.
  */
-void gxCmdQueueRun(gxCmdQueue_s* queue);
+bool gxCmdQueueRun(gxCmdQueue_s* queue);
 
 /**
  * @brief Stops a GX command queue from processing incoming commands.
- * @param queue The GX command queue.
+ * @param queue The GX command queue. Nothing is done if it isn't the current one.
  */
 void gxCmdQueueStop(gxCmdQueue_s* queue);
 
+/**
+ * @brief Gets the GX command queue that is currently run.
+ * @param running Optional output: whether the queue is processing commands.
+ * @return The GX command queue selected with \ref gxCmdQueueRun, or NULL if none.
+ */
+gxCmdQueue_s* gxCmdQueueGetCurrent(bool* running);
+
 /**
  * @brief Waits for a GX command queue to finish executing pending commands.
  * @param queue The GX command queue.
@@ -142,6 +150,12 @@ static inline void gxCmdQueueSetCallback(gxCmdQueue_s* queue, void (* callback)(
  */
 void GX_BindQueue(gxCmdQueue_s* queue);
 
+/**
+ * @brief Gets the command queue to which GX_* functions currently add commands.
+ * @return The bound GX command queue, or NULL if commands are immediately submitted to GX.
+ */
+gxCmdQueue_s* GX_GetBoundQueue(void);
+
 /**
  * @brief Requests a DMA.
  * @param src Source to DMA from.
@@ -0,0 +1,108 @@
+/**
+ * @file streambuf.h
+ * @brief Streaming vertex/index buffer ring in linear memory.
+ *
+ * A stream buffer hands out aligned sub-ranges of a linear memory ring for dynamic geometry.
+ * Allocations are grouped into batches, each of which is closed by a fence that must be signaled
+ * once the GPU is done with it (usually from a one-shot P3D event callback). Only the span written
+ * since the last flush is flushed from the data cache, and the ring wraps around once the oldest
+ * batches have been retired.
+ */
+#pragma once
+
+#include <3ds/types.h>
+#include <3ds/synchronization.h>
+
+/// Stream buffer batch fence.
+typedef struct
+{
+	LightEvent fence; ///< Signaled once the GPU no longer uses the data of the batch.
+	u32 end;          ///< Ring offset right past the end of the batch.
+} gpuStreamBufFence_s;
+
+/// Stream buffer.
+typedef struct
+{
+	u8* base;                     ///< Linear memory block backing the ring.
+	u32 size;                     ///< Size of the ring.
+	u32 head;                     ///< Offset at which the next allocation is attempted.
+	u32 tail;                     ///< Offset of the oldest data still in use by the GPU.
+	u32 batch;                    ///< Offset at which the current (unfenced) batch begins.
+	u32 flushed;                  ///< Offset up to which the current batch has been flushed.
+	u32 wrap;                     ///< Offset at which the ring last wrapped around.
+	gpuStreamBufFence_s* fences;  ///< Fence ring.
+	u16 maxFences;                ///< Capacity of the fence ring.
+	u16 firstFence;               ///< Index of the oldest pending fence.
+	u16 numFences;                ///< Number of pending fences.
+} gpuStreamBuf_s;
+
+/**
+ * @brief Initializes a stream buffer.
+ * @param sb Stream buffer to initialize.
+ * @param size Size of the ring (rounded up to 0x80 bytes).
+ * @param maxFences Maximum number of batches that can be in flight at the same time.
+ * @return true on success, false on failure.
+ */
+bool gpuStreamBufInit(gpuStreamBuf_s* sb, u32 size, u16 maxFences);
+
+/**
+ * @brief Waits for all pending batches and frees the memory used by a stream buffer.
+ * @param sb Stream buffer to free.
+ */
+void gpuStreamBufExit(gpuStreamBuf_s* sb);
+
+/**
+ * @brief Allocates a sub-range of a stream buffer for the current batch.
+ * @param sb Stream buffer to allocate from.
+ * @param size Size of the allocation.
+ * @param alignment Alignment of the allocation (must be a power of two, and no greater than 0x80).
+ * @return The allocated buffer, or NULL if it cannot fit even after all previous batches have been retired.
+ * @note This function waits for the oldest batches to be retired if there isn't enough free space.
+ */
+void* gpuStreamBufAlloc(gpuStreamBuf_s* sb, u32 size, u32 alignment);
+
+/**
+ * @brief Flushes the data cache for the span written in the current batch since the last flush.
+ * @param sb Stream buffer to flush.
+ * @return The result of the flush operation.
+ */
+Result gpuStreamBufFlush(gpuStreamBuf_s* sb);
+
+/**
+ * @brief Flushes and closes the current batch.
+ * @param sb Stream buffer to use.
+ * @return The batch fence, which must be passed to \ref gpuStreamBufSignal once the GPU is done with the batch.
+ * @note The returned pointer can directly be used as the data of a one-shot \ref gspSetEventCallback callback.
+ */
+gpuStreamBufFence_s* gpuStreamBufFence(gpuStreamBuf_s* sb);
+
+/**
+ * @brief Signals a batch fence, allowing its data to be overwritten.
+ * @param fence Batch fence (as returned by \ref gpuStreamBufFence).
+ * @note This function has a ThreadFunc compatible signature so that it can be used as a GSP event callback.
+ */
+void gpuStreamBufSignal(void* fence);
+
+/**
+ * @brief Adds a command setting the attribute buffer base location to the stream buffer.
+ * @param sb Stream buffer to use.
+ */
+void GPUCMD_AddStreamBufLocation(const gpuStreamBuf_s* sb);
+
+/**
+ * @brief Adds a command pointing an attribute buffer at data allocated from a stream buffer.
+ * @param sb Stream buffer the data was allocated from.
+ * @param id ID of the attribute buffer (0 to 11).
+ * @param data Vertex data.
+ * @note \ref GPUCMD_AddStreamBufLocation must have been used to set the attribute buffer base location.
+ */
+void GPUCMD_AddStreamBufAttribBuffer(const gpuStreamBuf_s* sb, u32 id, const void* data);
+
+/**
+ * @brief Adds a command pointing the index buffer at data allocated from a stream buffer.
+ * @param sb Stream buffer the data was allocated from.
+ * @param data Index data.
+ * @param shortIndices Whether the indices are 16-bit (true) or 8-bit (false).
+ * @note \ref GPUCMD_AddStreamBufLocation must have been used to set the attribute buffer base location.
+ */
+void GPUCMD_AddStreamBufIndexBuffer(const gpuStreamBuf_s* sb, const void* data, bool shortIndices);
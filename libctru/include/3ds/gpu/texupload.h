@@ -0,0 +1,124 @@
+/**
+ * @file texupload.h
+ * @brief Asynchronous batched texture upload manager.
+ *
+ * Uploads are recorded into a texture uploader and submitted together: the data cache is flushed
+ * once for the merged source ranges of the whole batch, and all the transfers are packed into a single
+ * GX command queue run. Completion is tracked per upload.
+ */
+#pragma once
+
+#include <3ds/types.h>
+#include <3ds/synchronization.h>
+#include <3ds/gpu/gx.h>
+
+typedef struct tag_gxTexUpload_s gxTexUpload_s;
+
+/// Texture upload.
+struct tag_gxTexUpload_s
+{
+	const void* src;                     ///< Source data.
+	void* dst;                           ///< Destination texture data.
+	u32 size;                            ///< Size of the data (raw copies only).
+	u32 flags;                           ///< GX transfer flags (display transfers only).
+	u16 width;                           ///< Width of the first level (display transfers only).
+	u16 height;                          ///< Height of the first level (display transfers only).
+	u8 numLevels;                        ///< Number of mipmap levels (display transfers only).
+	bool done;                           ///< Whether the upload has completed.
+	u16 lastCmd;                         ///< Number of completed GX commands after which the upload is complete.
+	void (* callback)(gxTexUpload_s*);   ///< Optional completion callback.
+	void* user;                          ///< Data for the completion callback.
+	gxTexUpload_s* next;                 ///< Next upload in the uploader's list.
+};
+
+/// Texture uploader.
+typedef struct
+{
+	gxCmdQueue_s queue;                  ///< GX command queue used for the transfers.
+	gxTexUpload_s* first;                ///< First in-flight upload.
+	gxTexUpload_s* last;                 ///< Last in-flight upload.
+	gxTexUpload_s* firstPending;         ///< First recorded upload that has not been submitted yet.
+	gxTexUpload_s* lastPending;          ///< Last recorded upload that has not been submitted yet.
+	LightEvent idle;                     ///< Signaled when no batch is being processed by GX.
+} gxTexUploader_s;
+
+/**
+ * @brief Initializes a texture uploader.
+ * @param up Texture uploader to initialize.
+ * @param maxCmds Maximum number of GX commands per batch (one per mipmap level).
+ * @return true on success, false on failure.
+ */
+bool gxTexUploaderInit(gxTexUploader_s* up, u16 maxCmds);
+
+/**
+ * @brief Waits for in-flight uploads and frees the memory used by a texture uploader.
+ * @param up Texture uploader to free.
+ */
+void gxTexUploaderExit(gxTexUploader_s* up);
+
+/**
+ * @brief Records the upload of a linear image (and optionally its mipmap chain) to a tiled texture.
+ * @param up Texture uploader to use.
+ * @param upload Upload structure (must remain valid until the upload completes).
+ * @param src Linear source image in linear memory, with the mipmap levels stored consecutively.
+ * @param dst Destination texture data, with the mipmap levels stored consecutively.
+ * @param width Width of the first level (multiple of 8).
+ * @param height Height of the first level (multiple of 8).
+ * @param inFmt Format of the source image.
+ * @param outFmt Format of the destination texture.
+ * @param numLevels Number of mipmap levels to upload (at least 1).
+ * @param flip Whether to vertically flip the image.
+ * @return true on success, false if the parameters are invalid.
+ */
+bool gxTexUploadImage(gxTexUploader_s* up, gxTexUpload_s* upload, const void* src, void* dst, u16 width, u16 height,
+	GX_TRANSFER_FORMAT inFmt, GX_TRANSFER_FORMAT outFmt, u8 numLevels, bool flip);
+
+/**
+ * @brief Records a raw copy of already tiled (or compressed) texture data.
+ * @param up Texture uploader to use.
+ * @param upload Upload structure (must remain valid until the upload completes).
+ * @param src Source data in linear memory.
+ * @param dst Destination texture data.
+ * @param size Size of the data (multiple of 16 bytes).
+ * @return true on success, false if the parameters are invalid.
+ */
+bool gxTexUploadRaw(gxTexUploader_s* up, gxTexUpload_s* upload, const void* src, void* dst, u32 size);
+
+/**
+ * @brief Flushes the sources of all recorded uploads and submits them to GX as a single batch.
+ * @param up Texture uploader to use.
+ * @return The result of the operation. If another GX command queue is processing commands, the batch is not
+ *         submitted and an RD_BUSY error is returned: the uploads stay recorded and can be submitted later.
+ * @note If the previous batch is still being processed, this function waits for it first.
+ * @note The uploader's command queue becomes the current one until the batch completes, then no queue is current.
+ *       The queue that was current before isn't run again on its owner's behalf: the owner must call
+ *       \ref gxCmdQueueRun once the batch completed (see \ref gxTexUploaderWait) to process the commands added to it.
+ */
+Result gxTexUploaderSubmit(gxTexUploader_s* up);
+
+/**
+ * @brief Marks completed uploads as done and calls their completion callbacks.
+ * @param up Texture uploader to use.
+ */
+void gxTexUploaderPoll(gxTexUploader_s* up);
+
+/**
+ * @brief Waits for all submitted uploads to complete, then calls their completion callbacks.
+ * @param up Texture uploader to use.
+ * @param timeout Timeout (in nanoseconds) to wait (specify -1 for no timeout).
+ * @return false if the timeout expired, true otherwise.
+ */
+bool gxTexUploaderWait(gxTexUploader_s* up, s64 timeout);
+
+/**
+ * @brief Sets the completion callback of a texture upload.
+ * @note Recording an upload clears its callback, so this must be called afterwards.
+ * @param upload Texture upload.
+ * @param callback The completion callback.
+ * @param user User data.
+ */
+static inline void gxTexUploadSetCallback(gxTexUpload_s* upload, void (* callback)(gxTexUpload_s*), void* user)
+{
+	upload->callback = callback;
+	upload->user = user;
+}
@@ -45,6 +45,24 @@ typedef enum
 	NDSP_INTERP_NONE      = 2, ///< No interpolation
 } ndspInterpType;
 
+/// Channel parameters which can be automated.
+typedef enum
+{
+	NDSP_AUTO_VOLUME         = 0, ///< Gain applied to the mix parameters (1.0 leaves them unchanged).
+	NDSP_AUTO_RATE           = 1, ///< Sample rate, in Hz.
+	NDSP_AUTO_IIR_MONO_LPF   = 2, ///< Cut-off frequency of the monopole low pass filter, in Hz.
+	NDSP_AUTO_IIR_MONO_HPF   = 3, ///< Cut-off frequency of the monopole high pass filter, in Hz.
+	NDSP_AUTO_IIR_BIQUAD_LPF = 4, ///< Cut-off frequency of the biquad low pass filter, in Hz.
+	NDSP_AUTO_IIR_BIQUAD_HPF = 5, ///< Cut-off frequency of the biquad high pass filter, in Hz.
+} ndspAutoParam;
+
+/// Automation curve types.
+typedef enum
+{
+	NDSP_CURVE_LINEAR      = 0, ///< Constant change per frame.
+	NDSP_CURVE_EXPONENTIAL = 1, ///< Constant ratio per frame (start and end values must be positive).
+} ndspCurveType;
+
 ///@}
 
 ///@name Basic channel operation
@@ -233,3 +251,56 @@ bool ndspChnIirBiquadSetParamsNotchFilter(int id, float f0, float Q);
  */
 bool ndspChnIirBiquadSetParamsPeakingEqualizer(int id, float f0, float Q, float gain);
 ///@}
+
+///@name Parameter automation
+///@{
+/**
+ * @brief Automates a parameter of a channel along a curve.
+ * @param id ID of the channel (0..23).
+ * @param param Parameter to automate.
+ * @param curve Curve type.
+ * @param start Value of the parameter at the first frame.
+ * @param end Value of the parameter after the last frame, which is kept once the automation ends.
+ * @param frames Duration of the automation in frames (of 160 samples at \ref NDSP_SAMPLE_RATE).
+ * @return Whether the automation was started.
+ * @remark The parameter is updated by the NDSP thread from the next frame on, without waking up the application.
+ *         The low and high pass variants of a filter share the filter: automating one replaces the other.
+ *         Automating a filter enables it. While a parameter is automated, its setter has no lasting effect
+ *         (except for the volume, which scales the mix set with \ref ndspChnSetMix).
+ */
+bool ndspChnAutomate(int id, ndspAutoParam param, ndspCurveType curve, float start, float end, u32 frames);
+
+/**
+ * @brief Automates a parameter of a channel with a table of values, linearly interpolated between frames.
+ * @param id ID of the channel (0..23).
+ * @param param Parameter to automate.
+ * @param table Values of the parameter (2..32768 entries), evenly spread over the duration. It must remain valid while the automation runs.
+ * @param count Number of values in the table.
+ * @param frames Duration of the automation in frames, or period of the table if looping.
+ * @param loop Whether to repeat the table, interpolating from its last value back to its first (e.g. for a tremolo or a vibrato).
+ * @return Whether the automation was started.
+ */
+bool ndspChnAutomateTable(int id, ndspAutoParam param, const float* table, u32 count, u32 frames, bool loop);
+
+/**
+ * @brief Sets the quality factor used by the biquad filter automations of a channel.
+ * @param id ID of the channel (0..23).
+ * @param Q "Quality factor", sqrt(2)/2 (i.e. 0.7071) by default.
+ */
+void ndspChnAutomationSetQ(int id, float Q);
+
+/**
+ * @brief Checks whether a parameter of a channel is being automated.
+ * @param id ID of the channel (0..23).
+ * @param param Parameter to check.
+ * @return Whether the parameter is being automated.
+ */
+bool ndspChnIsAutomating(int id, ndspAutoParam param);
+
+/**
+ * @brief Stops the automation of a parameter of a channel, keeping its current value.
+ * @param id ID of the channel (0..23).
+ * @param param Parameter whose automation is to be stopped.
+ */
+void ndspChnAutomationStop(int id, ndspAutoParam param);
+///@}
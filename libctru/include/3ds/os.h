@@ -157,6 +157,33 @@ typedef struct
  */
 u32 osConvertVirtToPhys(const void* vaddr);
 
+/**
+ * @brief Converts an array of addresses from virtual (process) memory to physical memory.
+ * @param out Output physical addresses (0 for the addresses that could not be converted).
+ * @param vaddrs Input virtual addresses.
+ * @param count Number of addresses.
+ * @return The number of addresses successfully converted.
+ */
+size_t osConvertVirtToPhysBatch(u32* out, const void* const* vaddrs, size_t count);
+
+/// Maximum number of mappings registered with \ref osRegisterPhysMapping.
+#define OS_MAX_PHYS_MAPPINGS 8
+
+/**
+ * @brief Registers a virtual to physical mapping used by \ref osConvertVirtToPhys, e.g. for mappable or shared memory backed by known physical memory.
+ * @param vaddr Virtual address of the mapping.
+ * @param paddr Physical address of the mapping.
+ * @param size Size of the mapping.
+ * The mapping must not overlap the fixed memory regions or another registered mapping.
+ */
+Result osRegisterPhysMapping(const void* vaddr, u32 paddr, u32 size);
+
+/**
+ * @brief Unregisters a mapping registered with \ref osRegisterPhysMapping.
+ * @param vaddr Virtual address of the mapping.
+ */
+Result osUnregisterPhysMapping(const void* vaddr);
+
 /**
  * @brief Converts 0x14* vmem to 0x30*.
  * @param vaddr Input virtual address.
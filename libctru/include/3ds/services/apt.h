@@ -227,6 +227,42 @@ void aptSetMessageCallback(aptMessageCb callback, void* user);
  */
 void aptLaunchLibraryApplet(NS_APPID appId, void* buf, size_t bufsize, Handle handle);
 
+/// Library applet launched with \ref aptLaunchLibraryAppletAsync.
+typedef struct
+{
+	NS_APPID appId; ///< ID of the applet.
+	void* buf;      ///< Buffer receiving the result data.
+	size_t bufsize; ///< Size of the buffer.
+	bool sleep;     ///< Sleep setting to restore once the applet exits.
+	bool running;   ///< Whether the applet is still running.
+} aptLibraryApplet;
+
+/**
+ * @brief Launches a library applet without waiting for it to exit.
+ * @param applet Applet state, filled in by this function.
+ * @param appId ID of the applet to launch.
+ * @param buf Input/output buffer that contains launch parameters on entry and result data once the applet exits. Must stay valid until then.
+ * @param bufsize Size of the buffer.
+ * @param handle Handle to pass to the library applet.
+ * The calling thread (and any other thread) keeps running while the applet is up, but the GPU and the screens belong to the applet:
+ * nothing must be rendered until \ref aptLibraryAppletPoll or \ref aptLibraryAppletWait report that the applet exited.
+ */
+void aptLaunchLibraryAppletAsync(aptLibraryApplet* applet, NS_APPID appId, void* buf, size_t bufsize, Handle handle);
+
+/**
+ * @brief Checks whether a library applet launched with \ref aptLaunchLibraryAppletAsync exited, without blocking.
+ * @param applet Applet state.
+ * @return true if the applet exited (the result data was copied to its buffer) or isn't running, false otherwise.
+ * This must be called from the thread which launched the applet, as it processes the APT parameters (e.g. applet messages).
+ */
+bool aptLibraryAppletPoll(aptLibraryApplet* applet);
+
+/**
+ * @brief Waits for a library applet launched with \ref aptLaunchLibraryAppletAsync to exit.
+ * @param applet Applet state.
+ */
+void aptLibraryAppletWait(aptLibraryApplet* applet);
+
 /// Clears the chainloader state.
 void aptClearChainloader(void);
 
@@ -4,6 +4,9 @@
  */
 #pragma once
 
+#include <3ds/types.h>
+#include <3ds/synchronization.h>
+
 /// BOSS context.
 typedef struct
 {
@@ -178,3 +181,103 @@ void bossSetupContextDefault(bossContext *ctx, u32 seconds_interval, const char
  */
 Result bossSendContextConfig(bossContext *ctx);
 
+/// Scheduled task state.
+typedef enum {
+	BOSSSCHEDSTATE_PENDING = 0, ///< Waiting to be registered and started.
+	BOSSSCHEDSTATE_RUNNING,     ///< Started, its state is polled until it completes.
+	BOSSSCHEDSTATE_READING,     ///< Completed, its NsData is streamed to the callback.
+	BOSSSCHEDSTATE_DONE,        ///< Finished successfully.
+	BOSSSCHEDSTATE_FAILED,      ///< Failed or cancelled, see the result field.
+	BOSSSCHEDSTATE_TIMEDOUT,    ///< Never seen running or completed by the time the poll interval reached its maximum.
+} bossScheduledTaskState;
+
+typedef struct bossScheduledTask_s bossScheduledTask;
+
+/**
+ * @brief NsData callback, called from the scheduler thread.
+ * @param task Scheduled task.
+ * @param offset Offset of the data in the content.
+ * @param data Content data.
+ * @param size Size of the data.
+ * @return false to stop reading the content.
+ */
+typedef bool (*bossNsDataCallback)(bossScheduledTask *task, u64 offset, const void *data, u32 size);
+
+/// Task handled by the BOSS scheduler.
+struct bossScheduledTask_s
+{
+	char taskID[8];                         ///< BOSS taskID.
+	bossContext *ctx;                       ///< Context sent before registering the task, or NULL when the task is already registered.
+	u32 NsDataId;                           ///< NsDataId of the content to stream once the task completes, or 0 for none.
+	bossNsDataCallback callback;            ///< NsData callback.
+	void *user;                             ///< User data.
+	volatile bossScheduledTaskState state;  ///< Current state.
+	Result result;                          ///< Result of the failed operation, when state is BOSSSCHEDSTATE_FAILED or BOSSSCHEDSTATE_TIMEDOUT.
+	u64 size;                               ///< Content size, when known.
+	u64 offset;                             ///< Amount of content data passed to the callback so far.
+	u64 nextTick;                           ///< System tick of the next state poll (internal).
+	u32 pollMs;                             ///< Current poll interval (internal).
+	bool seenStarted;                       ///< Whether the task was seen running (internal).
+	u8 startStatus;                         ///< Task status before it was started, 0xFF if unknown (internal).
+	LightEvent done;                        ///< Signaled when the task is done or failed.
+	bossScheduledTask *next;                ///< Next scheduled task.
+};
+
+/// BOSS scheduler configuration.
+typedef struct
+{
+	u32 minPollMs;       ///< Initial task state poll interval, doubled after every poll of a running task.
+	u32 maxPollMs;       ///< Maximum task state poll interval.
+	u32 chunkSize;       ///< Size of the NsData reads passed to the callbacks.
+	u32 bytesPerSecond;  ///< NsData streaming budget in bytes per second, 0 for unlimited.
+	s32 priority;        ///< Scheduler thread priority, or -1 to use a priority just below the calling thread.
+} bossSchedulerConfig;
+
+/**
+ * @brief Fills a scheduler configuration with the default values (250ms to 8s polling, 64KB chunks, unlimited bandwidth).
+ * @param config Scheduler configuration.
+ */
+void bossSchedulerConfigDefault(bossSchedulerConfig *config);
+
+/**
+ * @brief Starts the BOSS scheduler thread. BOSS must be initialized.
+ * @param config Scheduler configuration, or NULL for the defaults.
+ */
+Result bossSchedulerInit(const bossSchedulerConfig *config);
+
+/// Stops the BOSS scheduler thread. Tasks which didn't complete are removed and signaled as failed, with a cancelled result.
+void bossSchedulerExit(void);
+
+/**
+ * @brief Adds a task to the BOSS scheduler. The task is registered (when a context is given), started, polled with exponential backoff until it completes, then its content is streamed to the callback.
+ * @param task Scheduled task, must remain valid until it is done or removed.
+ * @param taskID BOSS taskID.
+ * @param ctx Context sent before registering the task, or NULL when the task is already registered.
+ * @param NsDataId NsDataId of the content to stream, or 0 for none.
+ * @param callback NsData callback, can be NULL when NsDataId is 0.
+ * @param user User data.
+ * @return An invalid state error if the task is already scheduled.
+ */
+Result bossSchedulerAdd(bossScheduledTask *task, const char *taskID, bossContext *ctx, u32 NsDataId, bossNsDataCallback callback, void *user);
+
+/**
+ * @brief Removes a task from the BOSS scheduler. The BOSS task itself isn't cancelled.
+ * @param task Scheduled task. If it wasn't finished yet, it fails with a cancelled result (releasing its waiters).
+ */
+void bossSchedulerRemove(bossScheduledTask *task);
+
+/**
+ * @brief Waits for a scheduled task to be done, to fail or to time out.
+ * @param task Scheduled task.
+ * @param timeout_ns Timeout in nanoseconds, or -1 for no timeout.
+ * @return false if the timeout expired, true otherwise.
+ */
+static inline bool bossScheduledTaskWait(bossScheduledTask *task, s64 timeout_ns)
+{
+	if (timeout_ns < 0)
+	{
+		LightEvent_Wait(&task->done);
+		return true;
+	}
+	return LightEvent_WaitTimeout(&task->done, timeout_ns) == 0;
+}
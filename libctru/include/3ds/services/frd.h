@@ -4,6 +4,7 @@
  */
 #pragma once
 #include <3ds/mii.h>
+#include <3ds/synchronization.h>
 
 #define FRIEND_SCREEN_NAME_SIZE 0xB   ///< 11-byte UTF-16 screen name
 #define FRIEND_COMMENT_SIZE 0x21      ///< 33-byte UTF-16 comment
@@ -70,6 +71,27 @@ typedef enum
 	FRIEND_SENT_INVITATION    ///< Friend Sent invitation
 } NotificationTypes;
 
+/// Attributes fetched by roster snapshots
+enum
+{
+	FRIEND_ROSTER_PROFILE = BIT(0), ///< Fetch the friend profiles.
+	FRIEND_ROSTER_MII     = BIT(1), ///< Fetch the friend Miis.
+	FRIEND_ROSTER_PLAYING = BIT(2), ///< Fetch the games the friends are playing.
+	FRIEND_ROSTER_ALL     = FRIEND_ROSTER_PROFILE | FRIEND_ROSTER_MII | FRIEND_ROSTER_PLAYING,
+};
+
+/// Friend roster snapshot. All the arrays are indexed like the key list and live in a single allocation.
+typedef struct
+{
+	u32 count;                 ///< Number of friends.
+	u32 attributes;            ///< Fetched attributes (FRIEND_ROSTER_* flags).
+	FriendKey *keys;           ///< Friend keys.
+	FriendProfile *profiles;   ///< Friend profiles (if fetched).
+	MiiData *miis;             ///< Friend Miis (if fetched).
+	GameDescription *playing;  ///< Games being played, with UTF-16 descriptions (if fetched).
+	void *arena;               ///< Allocation holding all the arrays.
+} FriendRoster;
+
 /// Initializes FRD service.
 Result frdInit(void);
 
@@ -259,3 +281,37 @@ Result FRD_AddFriendOnline(Handle event, u32 principalId);
  * @param localFriendCode LocalFriendCode of the friend code to remove.
  */
 Result FRD_RemoveFriend(u32 principalId, u64 localFriendCode);
+
+/**
+ * @brief Fetches the friend list and the attributes of every friend, using one request per attribute.
+ * @param roster Roster to fill. Must be freed with @ref FRD_FreeRoster.
+ * @param attributes Attributes to fetch (FRIEND_ROSTER_* flags).
+ * @note Descriptions are left in UTF-16, so that only the displayed ones need to be converted.
+ */
+Result FRD_GetRoster(FriendRoster *roster, u32 attributes);
+
+/**
+ * @brief Frees a friend roster snapshot.
+ * @param roster Roster to free.
+ */
+void FRD_FreeRoster(FriendRoster *roster);
+
+/**
+ * @brief Starts keeping a cached friend roster up to date from friend notifications.
+ * @param attributes Attributes to keep in the cache (FRIEND_ROSTER_* flags).
+ * @note This attaches an event with @ref FRD_AttachToEventNotification, so notifications can't be received by other means while the cache is active.
+ */
+Result frdRosterCacheInit(u32 attributes);
+
+/// Stops updating the cached friend roster and frees it.
+void frdRosterCacheExit(void);
+
+/**
+ * @brief Locks the cached friend roster for reading.
+ * @param generation Pointer to output the generation of the cache to, or NULL. It changes whenever the cache is updated.
+ * @return The cached roster, which must not be used after @ref frdRosterCacheUnlock.
+ */
+const FriendRoster* frdRosterCacheLock(u32 *generation);
+
+/// Unlocks the cached friend roster.
+void frdRosterCacheUnlock(void);
@@ -4,6 +4,11 @@
  */
 #pragma once
 
+#include <3ds/types.h>
+#include <3ds/thread.h>
+#include <3ds/synchronization.h>
+#include <3ds/services/fs.h>
+
 /// HTTP context.
 typedef struct {
 	Handle servhandle; ///< Service handle.
@@ -299,3 +304,78 @@ Result httpcDownloadData(httpcContext *context, u8* buffer, u32 size, u32 *downl
  */
 Result httpcSetKeepAlive(httpcContext *context, HTTPC_KeepAlive option);
 
+/// Maximum number of concurrent range requests of a download.
+#define HTTPC_DOWNLOAD_MAX_SEGMENTS 8
+
+/// Byte range of a download.
+typedef struct {
+	u64 start; ///< Offset of the first byte of the range.
+	u64 end;   ///< Offset right past the last byte of the range.
+	u64 done;  ///< Number of bytes of the range written to the file.
+} httpcDownloadSegment;
+
+typedef struct httpcDownload httpcDownload;
+
+/// Download thread arguments.
+typedef struct {
+	httpcDownload* dl; ///< Download.
+	u32 index;         ///< Index of the byte range downloaded by the thread.
+} httpcDownloadThreadArgs;
+
+/// Parallel ranged download into a file.
+struct httpcDownload {
+	const char* url;                                           ///< URL being downloaded.
+	u32 sslOpts;                                               ///< SSL options set on each request.
+	FS_Archive archive;                                        ///< Archive containing the file.
+	char path[0x100];                                          ///< Path of the file.
+	char etag[64];                                             ///< ETag of the resource, if any.
+	Handle file;                                               ///< Destination file.
+	Handle journal;                                            ///< Resume journal file.
+	u64 size;                                                  ///< Total size of the resource (0 until the end of the stream if it is unknown).
+	bool streaming;                                            ///< Whether the size is unknown, the resource then being downloaded with a single request until the end of the stream.
+	u32 numSegments;                                           ///< Number of byte ranges.
+	httpcDownloadSegment segments[HTTPC_DOWNLOAD_MAX_SEGMENTS]; ///< Byte ranges.
+	Thread threads[HTTPC_DOWNLOAD_MAX_SEGMENTS];               ///< Download threads.
+	httpcDownloadThreadArgs threadArgs[HTTPC_DOWNLOAD_MAX_SEGMENTS]; ///< Download thread arguments.
+	LightLock lock;                                            ///< Lock protecting the progress.
+	u64 sessionBytes;                                          ///< Bytes downloaded since the download was started.
+	u64 startTick;                                             ///< System tick at which the download was started.
+	Result result;                                             ///< First error encountered by a download thread.
+	volatile bool cancel;                                      ///< Whether the download is being cancelled.
+};
+
+/**
+ * @brief Starts (or resumes) downloading a resource into a file, using several concurrent range requests.
+ * @param dl Download structure (must remain valid until @ref httpcDownloadWait returns).
+ * @param url URL to download (must remain valid until @ref httpcDownloadWait returns).
+ * @param archive Archive to write the file to.
+ * @param path Path of the file. A resume journal is kept next to it (with a .dlj suffix) until the download completes.
+ * @param numSegments Number of concurrent range requests (at most @ref HTTPC_DOWNLOAD_MAX_SEGMENTS). Servers without range support use a single request.
+ * @param sslOpts SSL options to set on each request (see @ref httpcSetSSLOpt), or 0.
+ * @note If a journal matching the size and ETag of the resource exists, the download resumes where it stopped.
+ * @note Resources of unknown size (without Content-Length, e.g. chunked responses) are streamed with a single request
+ *       and can't be resumed.
+ */
+Result httpcDownloadStart(httpcDownload* dl, const char* url, FS_Archive archive, const char* path, u32 numSegments, u32 sslOpts);
+
+/**
+ * @brief Waits for a download to complete (or to be cancelled) and closes its files.
+ * @param dl Download to wait for.
+ * @return The result of the download. The journal is deleted if it succeeded.
+ */
+Result httpcDownloadWait(httpcDownload* dl);
+
+/**
+ * @brief Cancels a download. The journal is kept, so the download can be resumed later.
+ * @param dl Download to cancel. @ref httpcDownloadWait still needs to be called.
+ */
+void httpcDownloadCancel(httpcDownload* dl);
+
+/**
+ * @brief Gets the progress of a download.
+ * @param dl Download to use.
+ * @param downloaded Pointer to output the number of bytes written to the file (including resumed ones) to, or NULL.
+ * @param total Pointer to output the total size to (0 while it is unknown), or NULL.
+ * @return The average throughput since the download was started, in bytes per second.
+ */
+u32 httpcDownloadGetProgress(httpcDownload* dl, u64* downloaded, u64* total);
@@ -94,6 +94,26 @@ typedef struct {
 	u8 unused_xb[0x15];
 } NFC_AppDataWriteStruct;
 
+/// Tag record read by the tag reader, see nfcTagReaderStart().
+typedef struct {
+	NFC_TagInfo info;/// TagInfo of the tag, used as the cache key.
+	Result result;/// Result of reading the TagInfo, loading the amiibo data and reading the AmiiboConfig. The fields below are only valid when this succeeded.
+	NFC_AmiiboConfig config;/// AmiiboConfig.
+	Result settingsResult;/// Result of nfcGetAmiiboSettings(), NFC_ERR_AMIIBO_NOTSETUP when the amiibo wasn't setup.
+	NFC_AmiiboSettings settings;/// AmiiboSettings, valid when settingsResult succeeded.
+	Result appDataResult;/// Result of opening and reading the appdata, or -1 when no amiibo AppID was given to the reader.
+	u8 appData[0xD8];/// Appdata, valid when appDataResult succeeded.
+	bool cached;/// Whether the record came from the UID cache instead of being read from the tag. The amiibo data is not loaded then, nfcLoadAmiiboData() must be used before accessing the tag.
+} NFC_TagRecord;
+
+/**
+ * @brief Tag reader callback, called from the tag reader thread.
+ * @param record Tag record, only valid during the callback.
+ * @param removed false when the tag was placed and read, true when the same tag was then removed.
+ * @param user User data given to nfcTagReaderStart().
+ */
+typedef void (*nfcTagReaderCallback)(const NFC_TagRecord *record, bool removed, void *user);
+
 /**
  * @brief Initializes NFC.
  * @param type See the NFC_OpType enum.
@@ -218,3 +238,23 @@ Result nfcCmd21(void);
  */
 Result nfcCmd22(void);
 
+/**
+ * @brief Starts the tag reader. A background thread scans for tags, waiting on the NFC tag events instead of polling the tag state. Once a tag has stayed in range for the debounce delay, its TagInfo, amiibo data, AmiiboConfig, AmiiboSettings and optionally appdata are read in one pass, and the record is passed to the callback. Records are cached by tag UID so that placing the same tag again doesn't reload it.
+ * @param inval Same as nfcStartScanning() input.
+ * @param amiibo_appid Amiibo AppID of the appdata to read, or 0 to not read the appdata.
+ * @param debounce_ms Time in milliseconds a tag must stay in range before being read.
+ * @param callback Callback receiving the tag records.
+ * @param user User data for the callback.
+ * @note NFC must be initialized with NFC_OpType_NFCTag. Scanning is managed by the reader, nfcStartScanning()/nfcStopScanning() must not be used meanwhile.
+ */
+Result nfcTagReaderStart(u16 inval, u32 amiibo_appid, u32 debounce_ms, nfcTagReaderCallback callback, void *user);
+
+/**
+ * @brief Stops the tag reader and stops scanning.
+ */
+void nfcTagReaderStop(void);
+
+/**
+ * @brief Flushes the tag reader UID cache. This is done automatically when amiibo data is written with this library.
+ */
+void nfcTagReaderFlushCache(void);
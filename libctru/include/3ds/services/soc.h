@@ -7,6 +7,8 @@
 #pragma once
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <3ds/types.h>
+#include <3ds/synchronization.h>
 
 /// The config level to be used with @ref SOCU_GetNetworkOpt
 #define SOL_CONFIG 0xfffe
@@ -96,6 +98,50 @@ typedef struct
 } SOCU_DNSTableEntry;
 
 
+/// Maximum number of addresses returned by a host name lookup.
+#define SOCU_MAX_HOST_ADDRS 16
+
+typedef struct SOCU_HostLookup SOCU_HostLookup;
+
+/// Completion callback of an asynchronous host name lookup.
+typedef void (*SOCU_HostLookupCallback)(SOCU_HostLookup *lookup);
+
+/// Asynchronous host name lookup.
+struct SOCU_HostLookup
+{
+	int error;                                 ///< 0 on success, otherwise an h_errno value (e.g. HOST_NOT_FOUND).
+	u32 num_addrs;                             ///< Number of resolved IPv4 addresses.
+	struct in_addr addrs[SOCU_MAX_HOST_ADDRS]; ///< Resolved IPv4 addresses.
+	char canonname[256];                       ///< Canonical name of the host.
+	SOCU_HostLookupCallback callback;          ///< Optional completion callback.
+	void *user;                                ///< User data.
+	LightEvent done;                           ///< Signaled once the lookup has completed.
+	SOCU_HostLookup *next;                     ///< Next lookup waiting for the same host (internal).
+};
+
+/// Pool of page-aligned socket I/O buffers.
+typedef struct
+{
+	u8 *base;        ///< Page-aligned memory backing the pool.
+	u32 buf_size;    ///< Size of each buffer (multiple of 0x1000).
+	u32 num_bufs;    ///< Number of buffers.
+	u32 num_free;    ///< Number of free buffers.
+	void *free_list; ///< First free buffer.
+	LightLock lock;  ///< Lock protecting the free list.
+	bool owned;      ///< Whether the memory was allocated by the pool.
+} SOCU_BufferPool;
+
+/// Options for @ref SOCU_ConnectHost and @ref SOCU_ConnectAddrs.
+typedef struct
+{
+	s32 timeout_ms;   ///< Deadline (in milliseconds) for the whole connection, or -1 for no timeout.
+	u32 stagger_ms;   ///< Delay (in milliseconds) before an attempt to the next address is started in parallel.
+	int sndbuf;       ///< Send buffer size (SO_SNDBUF), or 0 to keep the default.
+	int rcvbuf;       ///< Receive buffer size (SO_RCVBUF), or 0 to keep the default.
+	bool nodelay;     ///< Whether to set TCP_NODELAY.
+	bool nonblocking; ///< Whether to leave the connected socket in non-blocking mode.
+} SOCU_ConnectOptions;
+
 /**
  * @brief Initializes the SOC service.
  * @param context_addr Address of a page-aligned (0x1000) buffer to be used.
@@ -146,3 +192,127 @@ int SOCU_GetIPInfo(struct in_addr *ip, struct in_addr *netmask, struct in_addr *
  * @return error
  */
 int SOCU_AddGlobalSocket(int sockfd);
+
+/**
+ * @brief Starts an asynchronous host name lookup.
+ * @param lookup   Lookup structure (must remain valid until the lookup completes).
+ * @param name     Host name to resolve.
+ * @param callback Optional completion callback, or NULL.
+ * @param user     User data.
+ * @return 0 if successful. -1 if failed, and errno will be set accordingly.
+ * @note Results are cached, and concurrent lookups of the same host share a single request.
+ * @note The callback is called from the resolver thread (or from the calling thread if the result was cached) before the lookup is marked as done.
+ */
+int SOCU_ResolveHostAsync(SOCU_HostLookup *lookup, const char *name, SOCU_HostLookupCallback callback, void *user);
+
+/**
+ * @brief Checks whether an asynchronous host name lookup has completed.
+ * @param lookup Lookup structure.
+ * @return true if the lookup has completed, false otherwise.
+ */
+static inline bool SOCU_HostLookupDone(SOCU_HostLookup *lookup)
+{
+	return LightEvent_TryWait(&lookup->done) != 0;
+}
+
+/**
+ * @brief Waits for an asynchronous host name lookup to complete.
+ * @param lookup  Lookup structure.
+ * @param timeout Timeout (in nanoseconds) to wait (specify -1 for no timeout).
+ * @return false if the timeout expired, true otherwise.
+ */
+static inline bool SOCU_WaitHostLookup(SOCU_HostLookup *lookup, s64 timeout)
+{
+	if (timeout < 0)
+	{
+		LightEvent_Wait(&lookup->done);
+		return true;
+	}
+	return LightEvent_WaitTimeout(&lookup->done, timeout) == 0;
+}
+
+/**
+ * @brief Sets how long resolved host names are cached.
+ * @param positive_ms Time (in milliseconds) during which successful lookups are cached.
+ * @param negative_ms Time (in milliseconds) during which failed lookups are cached.
+ * @note SOCU doesn't report record TTLs. Defaults are 5 minutes and 30 seconds.
+ */
+void SOCU_SetResolverTTL(u32 positive_ms, u32 negative_ms);
+
+/// Discards all cached host name lookups.
+void SOCU_FlushResolverCache(void);
+
+/**
+ * @brief Initializes a pool of socket I/O buffers.
+ * @param pool     Pool to initialize.
+ * @param mem      Page-aligned memory of at least buf_size*num_bufs bytes to use, or NULL to allocate it.
+ * @param buf_size Size of each buffer (rounded up to 0x1000 bytes).
+ * @param num_bufs Number of buffers.
+ * @return 0 if successful. -1 if failed, and errno will be set accordingly.
+ * @note Buffers are whole pages, so they can be mapped by the kernel for IPC without copying partial pages.
+ */
+int SOCU_BufferPoolInit(SOCU_BufferPool *pool, void *mem, u32 buf_size, u32 num_bufs);
+
+/**
+ * @brief Frees a pool of socket I/O buffers.
+ * @param pool Pool to free.
+ */
+void SOCU_BufferPoolExit(SOCU_BufferPool *pool);
+
+/**
+ * @brief Allocates a buffer from a socket I/O buffer pool.
+ * @param pool Pool to allocate from.
+ * @return The buffer, or NULL if none is free.
+ */
+void* SOCU_BufferAlloc(SOCU_BufferPool *pool);
+
+/**
+ * @brief Returns a buffer to a socket I/O buffer pool.
+ * @param pool Pool the buffer was allocated from.
+ * @param buf  Buffer to free.
+ */
+void SOCU_BufferFree(SOCU_BufferPool *pool, void *buf);
+
+/**
+ * @brief Sends data from a page-aligned buffer, without copying it through a static buffer. Similar to sendto().
+ * @param sockfd    The socket fd.
+ * @param buf       Data to send (ideally allocated with @ref SOCU_BufferAlloc).
+ * @param len       Length of the data.
+ * @param flags     Send flags.
+ * @param dest_addr Destination address, or NULL.
+ * @param addrlen   Length of the destination address.
+ * @return The number of bytes sent. -1 if failed, and errno will be set accordingly.
+ */
+ssize_t SOCU_SendBuffer(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
+
+/**
+ * @brief Receives data into a page-aligned buffer, without copying it through a static buffer. Similar to recvfrom().
+ * @param sockfd   The socket fd.
+ * @param buf      Buffer receiving the data (ideally allocated with @ref SOCU_BufferAlloc).
+ * @param len      Size of the buffer.
+ * @param flags    Receive flags.
+ * @param src_addr Source address output, or NULL.
+ * @param addrlen  Size of the source address output, updated with the length of the address.
+ * @return The number of bytes received. -1 if failed, and errno will be set accordingly.
+ */
+ssize_t SOCU_RecvBuffer(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen);
+
+/**
+ * @brief Connects a TCP socket to one of several IPv4 addresses.
+ * @param addrs     Addresses to try, in order of preference.
+ * @param num_addrs Number of addresses (at most @ref SOCU_MAX_HOST_ADDRS are used).
+ * @param port      Port to connect to.
+ * @param opts      Connection options, or NULL to use the defaults (no timeout, 250ms stagger).
+ * @return The connected socket fd. -1 if failed, and errno will be set accordingly (ETIMEDOUT if the deadline expired).
+ * @note Attempts are started one after the other every stagger_ms (or as soon as the previous ones have all failed), and the first one to complete wins.
+ */
+int SOCU_ConnectAddrs(const struct in_addr *addrs, u32 num_addrs, u16 port, const SOCU_ConnectOptions *opts);
+
+/**
+ * @brief Resolves a host name and connects a TCP socket to it. See @ref SOCU_ConnectAddrs.
+ * @param host Host name to connect to.
+ * @param port Port to connect to.
+ * @param opts Connection options, or NULL to use the defaults.
+ * @return The connected socket fd. -1 if failed, and errno will be set accordingly (EHOSTUNREACH if the lookup failed, with h_errno set).
+ */
+int SOCU_ConnectHost(const char *host, u16 port, const SOCU_ConnectOptions *opts);
@@ -137,6 +137,32 @@ typedef struct {
 	udsNodeInfo nodes[UDS_MAXNODES];
 } udsNetworkScanInfo;
 
+/// Maximum number of networks kept in a udsBeaconCache.
+#define UDS_BEACONCACHE_MAXENTRIES 16
+
+/// Beacon cache entry.
+typedef struct {
+	udsNetworkScanInfo info;//Decoded network, with the NodeInfo of the nodes.
+	u32 networkID;//NetworkID of the network. The entry is keyed by host MAC address only: a host broadcasts a single network, a new one replaces it.
+	u32 beacon_hash;//Hash of the tagged parameters of the raw beacon (the fixed fields change with every beacon), unchanged beacons aren't decoded again.
+	u32 beacon_size;//Size of the tagged parameters of the raw beacon.
+	u64 lastSeen;//System tick of the last scan which received this beacon.
+	bool valid;//Whether this entry is used.
+} udsBeaconCacheEntry;
+
+/// Persistent list of the networks found by beacon-scanning, see udsBeaconCacheRefresh().
+typedef struct {
+	udsBeaconCacheEntry entries[UDS_BEACONCACHE_MAXENTRIES];
+	u32 generation;//Incremented whenever a network is added, changed or removed.
+	u32 maxAgeMs;//Networks which weren't seen for this long are removed.
+	u32 scanIntervalMs;//Minimum interval between scans.
+	u64 lastScan;//System tick of the last scan.
+	void *scanbuf;//Buffer used by the beacon-scanning command.
+	size_t scanbuf_size;
+	u32 wlancommID;
+	u8 id8;
+} udsBeaconCache;
+
 enum {
 	UDSNETATTR_DisableConnectSpectators = BIT(0), //When set new Spectators are not allowed to connect.
 	UDSNETATTR_DisableConnectClients = BIT(1), //When set new Clients are not allowed to connect.
@@ -206,6 +232,49 @@ void udsGenerateDefaultNetworkStruct(udsNetworkStruct *network, u32 wlancommID,
  */
 Result udsScanBeacons(void *outbuf, size_t maxsize, udsNetworkScanInfo **networks, size_t *total_networks, u32 wlancommID, u8 id8, const u8 *host_macaddress, bool connected);
 
+/**
+ * @brief Initializes a beacon cache.
+ * @param cache Beacon cache.
+ * @param scanbuf_size Size of the buffer allocated for the beacon-scanning command, see udsScanBeacons().
+ * @param wlancommID Unique local-WLAN communications ID for each application.
+ * @param id8 Additional ID that can be used by the application for different types of networks.
+ * @param maxAgeMs Networks which weren't seen by a scan for this many milliseconds are removed from the cache.
+ * @param scanIntervalMs Minimum interval in milliseconds between scans done by udsBeaconCacheRefresh(). Lobbies can use a short interval and refresh every frame.
+ */
+Result udsBeaconCacheInit(udsBeaconCache *cache, size_t scanbuf_size, u32 wlancommID, u8 id8, u32 maxAgeMs, u32 scanIntervalMs);
+
+/**
+ * @brief Frees a beacon cache.
+ * @param cache Beacon cache.
+ */
+void udsBeaconCacheExit(udsBeaconCache *cache);
+
+/**
+ * @brief Changes the minimum scan interval of a beacon cache, for example to scan more often while a lobby is displayed.
+ * @param cache Beacon cache.
+ * @param scanIntervalMs Minimum interval in milliseconds between scans.
+ */
+void udsBeaconCacheSetScanInterval(udsBeaconCache *cache, u32 scanIntervalMs);
+
+/**
+ * @brief Scans for networks and merges the result into a beacon cache. Only new or changed beacons are decoded, the others just have their age reset. Networks that weren't seen for the cache max age are removed. Check the generation field to know whether the list changed.
+ * Beacons are merged by host MAC address, so a host which created a new network (with a new networkID) replaces its previous entry.
+ * @param cache Beacon cache.
+ * @param host_macaddress When set, only the network from the specified host MAC address is scanned, and only that network can be removed from the cache.
+ * @param connected When not connected to a network this *must* be false. When connected to a network this *must* be true.
+ * @param force When false, nothing is done if the scan interval didn't elapse since the last scan.
+ */
+Result udsBeaconCacheRefresh(udsBeaconCache *cache, const u8 *host_macaddress, bool connected, bool force);
+
+/**
+ * @brief Looks up a network in a beacon cache.
+ * @param cache Beacon cache.
+ * @param host_macaddress Host MAC address.
+ * @param networkID NetworkID.
+ * @return The cached network, or NULL if it isn't in the cache (including when the host now broadcasts a different network). It remains valid until the next udsBeaconCacheRefresh().
+ */
+const udsNetworkScanInfo *udsBeaconCacheFind(const udsBeaconCache *cache, const u8 *host_macaddress, u32 networkID);
+
 /**
  * @brief This can be used by the host to set the appdata contained in the broadcasted beacons.
  * @param buf Appdata buffer.
@@ -68,9 +68,28 @@ int threadGetExitCode(Thread thread);
  * @brief Frees a finished libctru thread.
  * @param thread libctru thread handle
  * @remarks This function should not be called if the thread is detached, as it is freed automatically when it finishes.
+ * @note The memory of freed threads (control block, stack and TLS) is kept in a small pool and reused by threadCreate for threads with the same stack size.
  */
 void threadFree(Thread thread);
 
+/**
+ * @brief Releases the memory of the freed threads kept for reuse by threadCreate.
+ */
+void threadPoolTrim(void);
+
+/**
+ * @brief Enables or disables stack high-water mark measurement for the threads created afterwards.
+ * @param enable Whether to fill the stacks of new threads with a guard pattern (this costs a memset of the whole stack).
+ */
+void threadSetStackWatermark(bool enable);
+
+/**
+ * @brief Retrieves the peak stack usage of a libctru thread.
+ * @param thread libctru thread handle
+ * @return Peak stack usage in bytes, or 0 if the thread was created without stack watermark measurement.
+ */
+size_t threadGetStackUsage(Thread thread);
+
 /**
  * @brief Waits for a libctru thread to finish (or returns immediately if it is already finished).
  * @param thread libctru thread handle
@@ -0,0 +1,176 @@
+/**
+ * @file http.h
+ * @brief In-process HTTP/1.1 client.
+ *
+ * Unlike the HTTPC service, requests are performed directly over sockets (and SSLC contexts for
+ * HTTPS) in the calling thread. Connections are kept alive and pooled per host, chunked transfer
+ * encoding is decoded, and compressed bodies can be decoded by a pluggable content decoder.
+ * All network I/O goes through a transport, so the client can also run against a plain BSD socket
+ * shim on other platforms.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/// Maximum number of idle connections kept alive by a client.
+#define HTTP_MAX_IDLE_CONNECTIONS 8
+
+/// Size of the receive buffer of each connection.
+#define HTTP_CONNECTION_BUFFER_SIZE 4096
+
+/// HTTP client error codes.
+enum
+{
+  HTTP_ERR_URL      = -1, ///< Malformed or unsupported URL.
+  HTTP_ERR_CONNECT  = -2, ///< Could not connect to the server.
+  HTTP_ERR_IO       = -3, ///< Connection error while sending or receiving.
+  HTTP_ERR_PROTOCOL = -4, ///< Malformed response.
+  HTTP_ERR_MEMORY   = -5, ///< Out of memory.
+  HTTP_ERR_DECODE   = -6, ///< Content decoder error.
+  HTTP_ERR_ABORTED  = -7, ///< The data callback aborted the transfer.
+};
+
+/** @brief Body data callback
+ *  @param[in] user User data
+ *  @param[in] data Received (decoded) body data
+ *  @param[in] size Data size
+ *  @returns false to abort the transfer
+ */
+typedef bool (*http_data_callback_t)(void *user, const void *data, size_t size);
+
+/// Network transport used by an HTTP client.
+typedef struct
+{
+  /// Opens a connection, returns NULL on failure.
+  void*   (*connect)(void *user, const char *host, uint16_t port, bool tls);
+  /// Receives data, returns the number of bytes received (0 if the connection was closed) or a negative value on error.
+  ssize_t (*read)(void *conn, void *buf, size_t len);
+  /// Sends data, returns the number of bytes sent or a negative value on error.
+  ssize_t (*write)(void *conn, const void *buf, size_t len);
+  /// Closes a connection.
+  void    (*close)(void *conn);
+  /// Optional lock protecting the connection pool, for clients shared between threads.
+  void    (*lock)(void *user);
+  /// Optional unlock counterpart of lock.
+  void    (*unlock)(void *user);
+  void    *user; ///< User data.
+} http_transport_t;
+
+/// Content decoder (e.g. for gzip encoded bodies).
+typedef struct
+{
+  const char *name; ///< Content-Encoding token handled by the decoder (e.g. "gzip").
+  /// Creates a decoder state, returns NULL on failure.
+  void* (*create)(void);
+  /// Decodes input data, passing the output to the sink. Returns false on error or if the sink aborted.
+  bool  (*decode)(void *state, const void *in, size_t size, http_data_callback_t sink, void *user);
+  /// Destroys a decoder state.
+  void  (*destroy)(void *state);
+} http_decoder_t;
+
+/// Pooled connection.
+typedef struct
+{
+  void     *conn;                                 ///< Transport connection.
+  char     host[256];                             ///< Host name.
+  uint16_t port;                                  ///< Port.
+  bool     tls;                                   ///< Whether the connection uses TLS.
+  size_t   pos;                                   ///< Read position in the receive buffer.
+  size_t   len;                                   ///< Amount of data in the receive buffer.
+  uint8_t  buf[HTTP_CONNECTION_BUFFER_SIZE];      ///< Receive buffer.
+} http_connection_t;
+
+/// HTTP client.
+typedef struct
+{
+  http_transport_t      transport;                        ///< Network transport.
+  const http_decoder_t  *decoder;                         ///< Content decoder, or NULL.
+  const char            *user_agent;                      ///< User-Agent header value, or NULL.
+  http_connection_t     *idle[HTTP_MAX_IDLE_CONNECTIONS]; ///< Idle keep-alive connections.
+  uint32_t              num_idle;                         ///< Number of idle connections.
+} http_client_t;
+
+/// HTTP request.
+typedef struct
+{
+  const char           *method;      ///< Method, or NULL for GET.
+  const char           *url;         ///< URL (http:// or https://).
+  const char           *headers;     ///< Extra header lines, each terminated by CRLF, or NULL.
+  const void           *body;        ///< Request body, or NULL.
+  size_t               body_size;    ///< Request body size.
+  bool                 range;        ///< Whether to request a byte range.
+  uint64_t             range_start;  ///< First byte of the range.
+  uint64_t             range_end;    ///< Last byte of the range (inclusive), or UINT64_MAX for the rest of the resource.
+  http_data_callback_t on_data;      ///< Body data callback, or NULL to discard the body.
+  void                 *user;        ///< User data for the body data callback.
+} http_request_t;
+
+/// HTTP response.
+typedef struct
+{
+  int      status;             ///< Status code.
+  uint64_t content_length;     ///< Content-Length of the (encoded) body, or UINT64_MAX if unknown.
+  uint64_t range_total;        ///< Total resource size from Content-Range, or UINT64_MAX if unknown.
+  uint64_t received;           ///< Number of (encoded) body bytes received.
+  char     content_type[128];  ///< Content-Type.
+  char     location[512];      ///< Location (for redirects).
+  char     etag[128];          ///< ETag.
+} http_response_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes an HTTP client.
+ * @param client Pointer to the client.
+ * @param transport Network transport to use.
+ */
+void
+http_client_init(http_client_t          *client,
+                 const http_transport_t *transport);
+
+/**
+ * @brief Closes all idle connections of an HTTP client.
+ * @param client Pointer to the client.
+ */
+void
+http_client_exit(http_client_t *client);
+
+/**
+ * @brief Sets the content decoder of an HTTP client.
+ * @param client Pointer to the client.
+ * @param decoder Content decoder, or NULL. Its encoding is advertised in the Accept-Encoding header.
+ */
+void
+http_client_set_decoder(http_client_t        *client,
+                        const http_decoder_t *decoder);
+
+/**
+ * @brief Performs an HTTP request.
+ * @param client Pointer to the client.
+ * @param req Request to perform.
+ * @param resp Response output.
+ * @return 0 on success (whatever the status code is), or an HTTP_ERR_* code.
+ * @note The client can be shared between threads if its transport provides a lock. Each request uses its own connection.
+ */
+int
+http_perform(http_client_t        *client,
+             const http_request_t *req,
+             http_response_t      *resp);
+
+/**
+ * @brief Initializes a transport over SOC sockets and SSLC contexts.
+ * @param transport Pointer to the transport.
+ * @param sslc_opts SSLC options used for HTTPS connections (e.g. SSLCOPT_DisableVerify).
+ * @note SOC and SSLC must be initialized by the application.
+ */
+void
+http_transport_soc(http_transport_t *transport,
+                   uint32_t         sslc_opts);
+
+#ifdef __cplusplus
+}
+#endif
@@ -58,6 +58,9 @@ extern "C" {
 
 	extern int	h_errno;
 	struct hostent*	gethostbyname(const char *name);
+	int		gethostbyname_r(const char *name, struct hostent *ret,
+				char *buf, size_t buflen,
+				struct hostent **result, int *h_errnop);
 	struct hostent*	gethostbyaddr(const void *addr, socklen_t len, int type);
 	void		herror(const char *s);
 	const char*	hstrerror(int err);
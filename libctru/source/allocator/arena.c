@@ -0,0 +1,104 @@
+#include <stdlib.h>
+#include <3ds/types.h>
+#include <3ds/synchronization.h>
+#include <3ds/allocator/linear.h>
+#include <3ds/allocator/arena.h>
+#include <3ds/services/gspgpu.h>
+
+bool linearArenaInit(linearArena_s* arena, u32 frameSize, u32 numFrames)
+{
+	if (!arena || !frameSize || !numFrames)
+		return false;
+
+	frameSize = (frameSize + 0x7F) &~ 0x7F;
+	if (frameSize > UINT32_MAX / numFrames)
+		return false;
+
+	arena->frames = (linearArenaFrame_s*)calloc(numFrames, sizeof(linearArenaFrame_s));
+	if (!arena->frames)
+		return false;
+
+	arena->base = (u8*)linearMemAlign(frameSize*numFrames, 0x80);
+	if (!arena->base)
+	{
+		free(arena->frames);
+		arena->frames = NULL;
+		return false;
+	}
+
+	for (u32 i = 0; i < numFrames; i ++)
+		LightEvent_Init(&arena->frames[i].fence, RESET_STICKY);
+
+	arena->frameSize = frameSize;
+	arena->numFrames = numFrames;
+	arena->curFrame  = numFrames-1;
+	arena->offset    = frameSize; // No frame is begun yet
+	arena->peak      = 0;
+	return true;
+}
+
+void linearArenaExit(linearArena_s* arena)
+{
+	if (!arena->base)
+		return;
+
+	for (u32 i = 0; i < arena->numFrames; i ++)
+		if (arena->frames[i].pending)
+			LightEvent_Wait(&arena->frames[i].fence);
+
+	linearFree(arena->base);
+	free(arena->frames);
+	arena->base = NULL;
+	arena->frames = NULL;
+}
+
+bool linearArenaBeginFrame(linearArena_s* arena, s64 timeout)
+{
+	u32 next = arena->curFrame+1;
+	if (next == arena->numFrames)
+		next = 0;
+
+	linearArenaFrame_s* frame = &arena->frames[next];
+	if (frame->pending)
+	{
+		if (timeout < 0)
+			LightEvent_Wait(&frame->fence);
+		else if (LightEvent_WaitTimeout(&frame->fence, timeout))
+			return false;
+		frame->pending = false;
+	}
+
+	frame->used = 0;
+	arena->curFrame = next;
+	arena->offset = 0;
+	return true;
+}
+
+linearArenaFrame_s* linearArenaEndFrame(linearArena_s* arena)
+{
+	linearArenaFrame_s* frame = &arena->frames[arena->curFrame];
+	u32 used = arena->offset < arena->frameSize ? arena->offset : arena->frameSize;
+
+	frame->used = used;
+	if (used > arena->peak)
+		arena->peak = used;
+
+	LightEvent_Clear(&frame->fence);
+	frame->pending = true;
+	arena->offset = arena->frameSize; // Further allocations fail until the next frame is begun
+	return frame;
+}
+
+void linearArenaSignalFrame(void* frame)
+{
+	LightEvent_Signal(&((linearArenaFrame_s*)frame)->fence);
+}
+
+Result linearArenaFlush(linearArena_s* arena)
+{
+	linearArenaFrame_s* frame = &arena->frames[arena->curFrame];
+	u32 used = frame->pending ? frame->used : arena->offset;
+	if (!used)
+		return 0;
+	return GSPGPU_FlushDataCache(arena->base + arena->curFrame*arena->frameSize, used);
+}
@@ -0,0 +1,575 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/reent.h>
+#include <3ds/types.h>
+#include <3ds/os.h>
+#include <3ds/synchronization.h>
+#include <3ds/allocator/fastmalloc.h>
+
+#define FM_PAGE_SHIFT     12
+#define FM_PAGE_SIZE      (1U << FM_PAGE_SHIFT)
+#define FM_ALIGN          16
+#define FM_MAX_SMALL      32768
+#define FM_NUM_CLASSES    41 // Class 0 is used for large allocations
+#define FM_GROW_SIZE      (1U << 20)
+#define FM_META_CHUNK     (16U << 10)
+#define FM_LEAF_SHIFT     20 // The page map is a two-level radix tree with 1MB leaves
+#define FM_LEAF_PAGES     (1U << (FM_LEAF_SHIFT - FM_PAGE_SHIFT))
+#define FM_NUM_LEAVES     ((OS_HEAP_AREA_END - OS_HEAP_AREA_BEGIN) >> FM_LEAF_SHIFT)
+
+typedef struct fmSpan_s fmSpan;
+
+/// Run of pages, either free in the page heap, holding small objects of one class, or a large allocation.
+struct fmSpan_s
+{
+	u32 page;         ///< First page (address >> FM_PAGE_SHIFT).
+	u32 npages;       ///< Number of pages.
+	u8 sizeclass;     ///< Size class of the objects, 0 for a large allocation or a free run.
+	bool isFree;      ///< Whether the span is a free run of the page heap.
+	u16 inuse;        ///< Number of objects handed out (small object spans).
+	void* freelist;   ///< Free objects (small object spans).
+	fmSpan* prev;     ///< Previous span in its list.
+	fmSpan* next;     ///< Next span in its list.
+};
+
+/// Thread cache list of free objects of one class.
+typedef struct
+{
+	void* head;
+	u32 count;
+} fmCacheList;
+
+static LightLock fmInitLock = 1;
+static volatile bool fmReady;
+
+static u16 fmClassSize[FM_NUM_CLASSES];
+static u8 fmClassPages[FM_NUM_CLASSES];
+static u8 fmClassBatch[FM_NUM_CLASSES];
+static u8 fmSizeToClass[FM_MAX_SMALL / FM_ALIGN + 1];
+
+// Central lists of the spans with free objects, one lock per class
+static LightLock fmClassLock[FM_NUM_CLASSES];
+static fmSpan* fmClassSpans[FM_NUM_CLASSES];
+
+// Page heap, the lock also protects the metadata and the statistics
+static LightLock fmPageLock = 1;
+static fmSpan* fmFreeRuns;
+static fmSpan** fmPageMap[FM_NUM_LEAVES];
+static fmSpan* fmSpanFreeList;
+static u8* fmMetaPtr;
+static u32 fmMetaLeft;
+static fastMallocStats fmStats;
+
+static __thread fmCacheList fmCache[FM_NUM_CLASSES];
+static __thread u32 fmCacheBytes;
+
+static void* fmSbrk(u32 size)
+{
+	// Keep the break page aligned, in case something else moved it
+	u32 cur = (u32)sbrk(0);
+	u32 pad = (FM_PAGE_SIZE - (cur & (FM_PAGE_SIZE - 1))) & (FM_PAGE_SIZE - 1);
+	void* p = sbrk(pad + size);
+	if (p == (void*)-1)
+		return NULL;
+	fmStats.heapSize += pad + size;
+	return (u8*)p + pad;
+}
+
+static void* fmMetaAlloc(u32 size)
+{
+	size = (size + 7) &~ 7;
+	if (size > fmMetaLeft)
+	{
+		u8* p = (u8*)fmSbrk(FM_META_CHUNK);
+		if (!p)
+			return NULL;
+		fmMetaPtr = p;
+		fmMetaLeft = FM_META_CHUNK;
+		fmStats.metadata += FM_META_CHUNK;
+	}
+	void* ret = fmMetaPtr;
+	fmMetaPtr += size;
+	fmMetaLeft -= size;
+	return ret;
+}
+
+static fmSpan* fmSpanNew(u32 page, u32 npages)
+{
+	fmSpan* s = fmSpanFreeList;
+	if (s)
+		fmSpanFreeList = s->next;
+	else if (!(s = (fmSpan*)fmMetaAlloc(sizeof(fmSpan))))
+		return NULL;
+	memset(s, 0, sizeof(*s));
+	s->page = page;
+	s->npages = npages;
+	return s;
+}
+
+static void fmSpanDelete(fmSpan* s)
+{
+	s->next = fmSpanFreeList;
+	fmSpanFreeList = s;
+}
+
+static inline void fmListRemove(fmSpan** list, fmSpan* s)
+{
+	if (s->prev) s->prev->next = s->next;
+	else *list = s->next;
+	if (s->next) s->next->prev = s->prev;
+	s->prev = s->next = NULL;
+}
+
+static inline void fmListPush(fmSpan** list, fmSpan* s)
+{
+	s->prev = NULL;
+	s->next = *list;
+	if (*list) (*list)->prev = s;
+	*list = s;
+}
+
+static inline fmSpan* fmPageMapGet(u32 page)
+{
+	u32 addr = page << FM_PAGE_SHIFT;
+	if (addr < OS_HEAP_AREA_BEGIN || addr >= OS_HEAP_AREA_END)
+		return NULL;
+	fmSpan** leaf = fmPageMap[(addr - OS_HEAP_AREA_BEGIN) >> FM_LEAF_SHIFT];
+	return leaf ? leaf[page & (FM_LEAF_PAGES - 1)] : NULL;
+}
+
+// Returns the page map leaf of a page, allocating it if needed
+static fmSpan** fmPageMapLeaf(u32 page)
+{
+	u32 idx = (page << FM_PAGE_SHIFT) - OS_HEAP_AREA_BEGIN;
+	fmSpan*** leaf = &fmPageMap[idx >> FM_LEAF_SHIFT];
+	if (!*leaf)
+	{
+		*leaf = (fmSpan**)fmMetaAlloc(FM_LEAF_PAGES * sizeof(fmSpan*));
+		if (!*leaf) return NULL;
+		memset(*leaf, 0, FM_LEAF_PAGES * sizeof(fmSpan*));
+	}
+	return *leaf;
+}
+
+static bool fmPageMapSet(u32 page, u32 npages, fmSpan* s)
+{
+	for (u32 i = 0; i < npages; i ++)
+	{
+		fmSpan** leaf = fmPageMapLeaf(page + i);
+		if (!leaf) return false;
+		leaf[(page + i) & (FM_LEAF_PAGES - 1)] = s;
+	}
+	return true;
+}
+
+// Returns the span holding an allocated pointer. Only the first and last pages of the free runs are mapped, the other
+// entries may be stale, so pointers that aren't in the span they map to are rejected.
+static inline fmSpan* fmSpanOf(void* ptr)
+{
+	u32 page = (u32)ptr >> FM_PAGE_SHIFT;
+	fmSpan* s = fmPageMapGet(page);
+	if (!s || s->isFree || page < s->page || page >= s->page + s->npages)
+		return NULL;
+	return s;
+}
+
+// Adds a run of pages to the page heap, coalescing it with the neighbouring free runs. Page lock held.
+// Coalescing only looks at the pages around a run, so only the first and last pages of the free runs are mapped
+// (the allocated spans are mapped entirely). Returns false, leaving the run out of the page heap, if they can't be:
+// this only happens for pages that were never mapped, i.e. a new heap area.
+static bool fmPageFree(fmSpan* s)
+{
+	fmSpan* prev = s->page ? fmPageMapGet(s->page - 1) : NULL;
+	fmSpan* next = fmPageMapGet(s->page + s->npages);
+	if (prev && !prev->isFree) prev = NULL;
+	if (next && !next->isFree) next = NULL;
+
+	u32 first = prev ? prev->page : s->page;
+	u32 last = next ? next->page + next->npages - 1 : s->page + s->npages - 1;
+	if (!fmPageMapLeaf(first) || !fmPageMapLeaf(last))
+		return false;
+
+	s->sizeclass = 0;
+	s->isFree = true;
+	s->freelist = NULL;
+	s->inuse = 0;
+
+	if (prev)
+	{
+		fmListRemove(&fmFreeRuns, prev);
+		fmStats.pageHeapFree -= prev->npages << FM_PAGE_SHIFT;
+		s->page = prev->page;
+		s->npages += prev->npages;
+		fmSpanDelete(prev);
+	}
+	if (next)
+	{
+		fmListRemove(&fmFreeRuns, next);
+		fmStats.pageHeapFree -= next->npages << FM_PAGE_SHIFT;
+		s->npages += next->npages;
+		fmSpanDelete(next);
+	}
+
+	fmPageMapSet(first, 1, s);
+	fmPageMapSet(last, 1, s);
+	fmListPush(&fmFreeRuns, s);
+	fmStats.pageHeapFree += s->npages << FM_PAGE_SHIFT;
+	return true;
+}
+
+// Allocates a run of pages, aligned to a number of pages (power of two). Page lock held.
+static fmSpan* fmPageAlloc(u32 npages, u32 alignPages)
+{
+	for (int pass = 0; pass < 2; pass ++)
+	{
+		for (fmSpan* s = fmFreeRuns; s; s = s->next)
+		{
+			u32 start = (s->page + alignPages - 1) &~ (alignPages - 1);
+			u32 end = s->page + s->npages;
+			if (start + npages > end)
+				continue;
+
+			fmSpan* head = start > s->page ? fmSpanNew(s->page, start - s->page) : NULL;
+			if (start > s->page && !head)
+				return NULL;
+			// Without a span for the tail, the allocation keeps it
+			fmSpan* tail = start + npages < end ? fmSpanNew(start + npages, end - start - npages) : NULL;
+			u32 used = tail ? npages : end - start;
+
+			// The allocated pages are mapped before anything changes: the entries already set meanwhile are in the
+			// run, which stays free if that fails. The head and tail then find the allocation as their neighbour, and
+			// their new edges must be in existing leaves for them to make it back to the page heap.
+			if ((head && !fmPageMapLeaf(start - 1)) || (tail && !fmPageMapLeaf(start + used)) || !fmPageMapSet(start, used, s))
+			{
+				if (head) fmSpanDelete(head);
+				if (tail) fmSpanDelete(tail);
+				return NULL;
+			}
+
+			fmListRemove(&fmFreeRuns, s);
+			fmStats.pageHeapFree -= s->npages << FM_PAGE_SHIFT;
+			s->isFree = false;
+			s->page = start;
+			s->npages = used;
+
+			// Give the unused head and tail back to the page heap (this can't fail anymore)
+			if (head)
+				fmPageFree(head);
+			if (tail)
+				fmPageFree(tail);
+			return s;
+		}
+
+		// Nothing fits: grow the heap, the new pages get coalesced with a free run at the top of the heap
+		u32 size = (npages + alignPages) << FM_PAGE_SHIFT;
+		if (size < FM_GROW_SIZE) size = FM_GROW_SIZE;
+		u8* p = (u8*)fmSbrk(size);
+		if (!p)
+			return NULL;
+		fmSpan* s = fmSpanNew((u32)p >> FM_PAGE_SHIFT, size >> FM_PAGE_SHIFT);
+		if (!s)
+			return NULL;
+		if (!fmPageFree(s))
+		{
+			fmSpanDelete(s);
+			return NULL;
+		}
+	}
+	return NULL;
+}
+
+static void fmInit(void)
+{
+	LightLock_Lock(&fmInitLock);
+	if (!fmReady)
+	{
+		// 16-byte steps up to 128, then 4 classes per power of two up to 32KB
+		u32 c = 1, size = FM_ALIGN;
+		for (; size <= 128; size += FM_ALIGN)
+			fmClassSize[c++] = size;
+		for (u32 step = 32; c < FM_NUM_CLASSES; step <<= 1)
+			for (u32 i = 0; i < 4 && c < FM_NUM_CLASSES; i ++)
+				fmClassSize[c++] = (size += step) - FM_ALIGN;
+
+		for (c = 1; c < FM_NUM_CLASSES; c ++)
+		{
+			u32 bytes = fmClassSize[c] * 8;
+			if (bytes > 0x10000) bytes = fmClassSize[c] * 2;
+			fmClassPages[c] = (bytes + FM_PAGE_SIZE - 1) >> FM_PAGE_SHIFT;
+			u32 batch = FM_MAX_SMALL / fmClassSize[c];
+			fmClassBatch[c] = batch < 2 ? 2 : batch > 32 ? 32 : batch;
+			LightLock_Init(&fmClassLock[c]);
+		}
+
+		for (u32 i = 0, c = 1; i <= FM_MAX_SMALL / FM_ALIGN; i ++)
+		{
+			while (fmClassSize[c] < i * FM_ALIGN) c++;
+			fmSizeToClass[i] = c;
+		}
+
+		__dmb();
+		fmReady = true;
+	}
+	LightLock_Unlock(&fmInitLock);
+}
+
+// Returns the class of a request, or 0 when it must be served by the page heap
+static inline u32 fmClassOf(size_t size, size_t alignment)
+{
+	if (size > FM_MAX_SMALL || alignment > FM_PAGE_SIZE)
+		return 0;
+	u32 c = fmSizeToClass[(size + FM_ALIGN - 1) / FM_ALIGN];
+	if (!c) c = 1;
+	// Objects are laid out every class size from a page-aligned span start
+	while (alignment > FM_ALIGN && c < FM_NUM_CLASSES && (fmClassSize[c] & (alignment - 1)))
+		c++;
+	return c < FM_NUM_CLASSES ? c : 0;
+}
+
+// Moves up to count objects of a class to the thread cache. Returns false if none could be obtained.
+static bool fmRefill(u32 c, u32 count)
+{
+	fmCacheList* list = &fmCache[c];
+
+	LightLock_Lock(&fmClassLock[c]);
+	while (count)
+	{
+		fmSpan* s = fmClassSpans[c];
+		if (!s)
+		{
+			LightLock_Lock(&fmPageLock);
+			s = fmPageAlloc(fmClassPages[c], 1);
+			if (s)
+			{
+				// Thread the free list through the objects of the new span
+				u32 size = fmClassSize[c];
+				u32 num = (s->npages << FM_PAGE_SHIFT) / size;
+				u8* base = (u8*)(s->page << FM_PAGE_SHIFT);
+				s->sizeclass = c;
+				s->freelist = NULL;
+				for (u32 i = num; i --;)
+				{
+					*(void**)(base + i * size) = s->freelist;
+					s->freelist = base + i * size;
+				}
+				fmStats.smallSpans += s->npages << FM_PAGE_SHIFT;
+			}
+			LightLock_Unlock(&fmPageLock);
+			if (!s)
+				break;
+			fmListPush(&fmClassSpans[c], s);
+		}
+
+		while (count && s->freelist)
+		{
+			void* obj = s->freelist;
+			s->freelist = *(void**)obj;
+			s->inuse++;
+			*(void**)obj = list->head;
+			list->head = obj;
+			list->count++;
+			fmCacheBytes += fmClassSize[c];
+			count--;
+		}
+		if (!s->freelist)
+			fmListRemove(&fmClassSpans[c], s);
+	}
+	LightLock_Unlock(&fmClassLock[c]);
+
+	return list->head != NULL;
+}
+
+// Returns count objects of a class from the thread cache to their spans
+static void fmRelease(u32 c, u32 count)
+{
+	fmCacheList* list = &fmCache[c];
+
+	LightLock_Lock(&fmClassLock[c]);
+	while (count-- && list->head)
+	{
+		void* obj = list->head;
+		list->head = *(void**)obj;
+		list->count--;
+		fmCacheBytes -= fmClassSize[c];
+
+		fmSpan* s = fmPageMapGet((u32)obj >> FM_PAGE_SHIFT);
+		if (!s->freelist)
+			fmListPush(&fmClassSpans[c], s);
+		*(void**)obj = s->freelist;
+		s->freelist = obj;
+
+		// Give empty spans back to the page heap
+		if (!--s->inuse)
+		{
+			fmListRemove(&fmClassSpans[c], s);
+			LightLock_Lock(&fmPageLock);
+			fmStats.smallSpans -= s->npages << FM_PAGE_SHIFT;
+			fmPageFree(s);
+			LightLock_Unlock(&fmPageLock);
+		}
+	}
+	LightLock_Unlock(&fmClassLock[c]);
+}
+
+static void* fmAlloc(size_t size, size_t alignment)
+{
+	if (!fmReady)
+		fmInit();
+	if (alignment & (alignment - 1))
+		return NULL;
+	if (!size)
+		size = 1;
+
+	u32 c = fmClassOf(size, alignment);
+	if (c)
+	{
+		fmCacheList* list = &fmCache[c];
+		if (!list->head && !fmRefill(c, fmClassBatch[c]))
+			return NULL;
+		void* obj = list->head;
+		list->head = *(void**)obj;
+		list->count--;
+		fmCacheBytes -= fmClassSize[c];
+		return obj;
+	}
+
+	if (size > 0x7FFFFFFF)
+		return NULL;
+	u32 npages = (size + FM_PAGE_SIZE - 1) >> FM_PAGE_SHIFT;
+	u32 alignPages = alignment > FM_PAGE_SIZE ? alignment >> FM_PAGE_SHIFT : 1;
+
+	LightLock_Lock(&fmPageLock);
+	fmSpan* s = fmPageAlloc(npages, alignPages);
+	if (s)
+		fmStats.largeInUse += s->npages << FM_PAGE_SHIFT;
+	LightLock_Unlock(&fmPageLock);
+
+	return s ? (void*)(s->page << FM_PAGE_SHIFT) : NULL;
+}
+
+static void fmFree(void* ptr)
+{
+	if (!ptr)
+		return;
+
+	fmSpan* s = fmSpanOf(ptr);
+	if (!s)
+		return;
+
+	u32 c = s->sizeclass;
+	if (c)
+	{
+		fmCacheList* list = &fmCache[c];
+		*(void**)ptr = list->head;
+		list->head = ptr;
+		list->count++;
+		fmCacheBytes += fmClassSize[c];
+
+		// Keep at most two batches per class in the thread cache
+		if (list->count > 2 * fmClassBatch[c])
+			fmRelease(c, fmClassBatch[c]);
+		return;
+	}
+
+	LightLock_Lock(&fmPageLock);
+	fmStats.largeInUse -= s->npages << FM_PAGE_SHIFT;
+	fmPageFree(s);
+	LightLock_Unlock(&fmPageLock);
+}
+
+static size_t fmUsableSize(void* ptr)
+{
+	if (!ptr)
+		return 0;
+	fmSpan* s = fmSpanOf(ptr);
+	if (!s)
+		return 0;
+	return s->sizeclass ? fmClassSize[s->sizeclass] : s->npages << FM_PAGE_SHIFT;
+}
+
+void fastMallocFlushThreadCache(void)
+{
+	if (!fmReady)
+		return;
+	for (u32 c = 1; c < FM_NUM_CLASSES; c ++)
+		if (fmCache[c].count)
+			fmRelease(c, fmCache[c].count);
+}
+
+// Called by threadExit
+void __ctru_malloc_thread_exit(void)
+{
+	fastMallocFlushThreadCache();
+}
+
+void fastMallocGetStats(fastMallocStats* stats)
+{
+	LightLock_Lock(&fmPageLock);
+	*stats = fmStats;
+	LightLock_Unlock(&fmPageLock);
+	stats->threadCached = fmCacheBytes;
+}
+
+void* __wrap__malloc_r(struct _reent* r, size_t size)
+{
+	void* p = fmAlloc(size, FM_ALIGN);
+	if (!p) r->_errno = ENOMEM;
+	return p;
+}
+
+void __wrap__free_r(struct _reent* r, void* ptr)
+{
+	fmFree(ptr);
+}
+
+void* __wrap__calloc_r(struct _reent* r, size_t num, size_t size)
+{
+	if (size && num > (size_t)-1 / size)
+	{
+		r->_errno = ENOMEM;
+		return NULL;
+	}
+	void* p = fmAlloc(num * size, FM_ALIGN);
+	if (p)
+		memset(p, 0, num * size);
+	else
+		r->_errno = ENOMEM;
+	return p;
+}
+
+void* __wrap__memalign_r(struct _reent* r, size_t alignment, size_t size)
+{
+	void* p = fmAlloc(size, alignment < FM_ALIGN ? FM_ALIGN : alignment);
+	if (!p) r->_errno = ENOMEM;
+	return p;
+}
+
+void* __wrap__realloc_r(struct _reent* r, void* ptr, size_t size)
+{
+	if (!ptr)
+		return __wrap__malloc_r(r, size);
+	if (!size)
+	{
+		fmFree(ptr);
+		return NULL;
+	}
+
+	size_t old = fmUsableSize(ptr);
+	if (size <= old && size > old / 2)
+		return ptr;
+
+	void* p = __wrap__malloc_r(r, size);
+	if (p)
+	{
+		memcpy(p, ptr, size < old ? size : old);
+		fmFree(ptr);
+	}
+	return p;
+}
+
+size_t __wrap__malloc_usable_size_r(struct _reent* r, void* ptr)
+{
+	return fmUsableSize(ptr);
+}
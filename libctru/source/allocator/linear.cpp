@@ -1,6 +1,8 @@
 extern "C"
 {
 	#include <3ds/types.h>
+	#include <3ds/svc.h>
+	#include <3ds/result.h>
 	#include <3ds/allocator/linear.h>
 	#include <3ds/util/rbtree.h>
 }
@@ -8,11 +10,31 @@ extern "C"
 #include "mem_pool.h"
 #include "addrmap.h"
 
-extern u32 __ctru_linear_heap;
-extern u32 __ctru_linear_heap_size;
+extern "C"
+{
+	extern u32 __ctru_linear_heap;
+	extern u32 __ctru_linear_heap_size;
+	extern u32 __ctru_linear_heap_grown;
+	extern u32 __ctru_linear_heap_used;
+	extern u32 __ctru_linear_heap_peak;
+	extern u32 __ctru_linear_heap_grow_count;
+	extern u32 __ctru_linear_heap_grow_failures;
+	extern u32 __ctru_heap_pool_size;
+
+	bool __ctru_heap_pool_take(u32 size);
+	void __ctru_heap_pool_give(u32 size);
+	void __ctru_linear_heap_exit(void);
+}
+
+#define LINEAR_HEAP_GROW_STEP    (1 << 20) // 1MB
+#define LINEAR_HEAP_MAX_SEGMENTS 32
 
 static MemPool sLinearPool;
 
+// Linear memory committed on demand from the heap pool
+static MemChunk sSegments[LINEAR_HEAP_MAX_SEGMENTS];
+static u32 sNumSegments;
+
 static bool linearInit()
 {
 	auto blk = MemBlock::Create((u8*)__ctru_linear_heap, __ctru_linear_heap_size);
@@ -25,6 +47,42 @@ static bool linearInit()
 	return false;
 }
 
+static bool linearGrow(u32 size, size_t alignment)
+{
+	if (sNumSegments == LINEAR_HEAP_MAX_SEGMENTS)
+		return false;
+
+	// Segments are page aligned, larger alignments may need padding
+	size = (size + 0xFFF) &~ 0xFFF;
+	if (alignment > 0x1000)
+		size += alignment - 0x1000;
+
+	// Grow by at least a step so that small allocations don't each cost a segment
+	u32 growSize = size < LINEAR_HEAP_GROW_STEP ? LINEAR_HEAP_GROW_STEP : size;
+	if (!__ctru_heap_pool_take(growSize))
+	{
+		growSize = size;
+		if (!__ctru_heap_pool_take(growSize))
+			return false;
+	}
+
+	u32 addr = 0;
+	if (R_FAILED(svcControlMemory(&addr, 0x0, 0x0, growSize, MEMOP_ALLOC_LINEAR, (MemPerm)(MEMPERM_READ | MEMPERM_WRITE))))
+	{
+		__ctru_heap_pool_give(growSize);
+		return false;
+	}
+
+	MemChunk& seg = sSegments[sNumSegments++];
+	seg.addr = (u8*)addr;
+	seg.size = growSize;
+	sLinearPool.Deallocate(seg);
+
+	__ctru_linear_heap_grown += growSize;
+	__ctru_linear_heap_grow_count++;
+	return true;
+}
+
 void* linearMemAlign(size_t size, size_t alignment)
 {
 	// Convert alignment to shift
@@ -36,10 +94,16 @@ void* linearMemAlign(size_t size, size_t alignment)
 	if (!sLinearPool.Ready() && !linearInit())
 		return nullptr;
 
-	// Allocate the chunk
+	// Allocate the chunk, growing the heap if needed
 	MemChunk chunk;
 	if (!sLinearPool.Allocate(chunk, size, shift))
-		return nullptr;
+	{
+		if (!linearGrow(size, alignment) || !sLinearPool.Allocate(chunk, size, shift))
+		{
+			__ctru_linear_heap_grow_failures++;
+			return nullptr;
+		}
+	}
 
 	auto node = newNode(chunk);
 	if (!node)
@@ -48,6 +112,10 @@ void* linearMemAlign(size_t size, size_t alignment)
 		return nullptr;
 	}
 	if (rbtree_insert(&sAddrMap, &node->node));
+
+	__ctru_linear_heap_used += chunk.size;
+	if (__ctru_linear_heap_used > __ctru_linear_heap_peak)
+		__ctru_linear_heap_peak = __ctru_linear_heap_used;
 	return chunk.addr;
 }
 
@@ -74,6 +142,7 @@ void linearFree(void* mem)
 	if (!node) return;
 
 	// Free the chunk
+	__ctru_linear_heap_used -= node->chunk.size;
 	sLinearPool.Deallocate(node->chunk);
 
 	// Free the node
@@ -82,5 +151,42 @@ void linearFree(void* mem)
 
 u32 linearSpaceFree()
 {
-	return sLinearPool.GetFreeSpace();
+	if (!sLinearPool.Ready() && !linearInit())
+		return 0;
+
+	// Memory that isn't committed yet is still available, the linear heap grows into it on demand
+	u32 pool = sNumSegments < LINEAR_HEAP_MAX_SEGMENTS ? __ctru_heap_pool_size : 0;
+	return sLinearPool.GetFreeSpace() + pool;
+}
+
+u32 linearTrim()
+{
+	u32 total = 0;
+	for (u32 i = sNumSegments; i --;)
+	{
+		MemChunk seg = sSegments[i];
+		if (!sLinearPool.Reclaim(seg))
+			continue;
+
+		u32 tmp = 0;
+		if (R_FAILED(svcControlMemory(&tmp, (u32)seg.addr, 0x0, seg.size, MEMOP_FREE, (MemPerm)0)))
+		{
+			sLinearPool.Deallocate(seg);
+			continue;
+		}
+
+		sSegments[i] = sSegments[--sNumSegments];
+		__ctru_linear_heap_grown -= seg.size;
+		__ctru_heap_pool_give(seg.size);
+		total += seg.size;
+	}
+	return total;
+}
+
+void __ctru_linear_heap_exit(void)
+{
+	u32 tmp = 0;
+	for (u32 i = 0; i < sNumSegments; i ++)
+		svcControlMemory(&tmp, (u32)sSegments[i].addr, 0x0, sSegments[i].size, MEMOP_FREE, (MemPerm)0);
+	sNumSegments = 0;
 }
@@ -1,59 +1,249 @@
 #include <3ds/allocator/mappable.h>
 #include <3ds/svc.h>
+#include <3ds/os.h>
 #include <3ds/result.h>
+#include <3ds/synchronization.h>
 
-static u32 minAddr, maxAddr, currentAddr;
+// Reserved pages are tracked with bitmaps over the mappable area: one with the used pages, and one
+// with the last page of each allocation (so that frees know where an allocation ends).
+// Pages used by areas mapped without this allocator are also marked in a separate bitmap, so that they
+// can be checked again once they are needed. Pages which were last seen free by a memory query (or
+// freed by this allocator) are marked in another one, allocations made of such pages skip the query.
+#define MAPPABLE_MAX_PAGES ((OS_MAP_AREA_END - OS_MAP_AREA_BEGIN) >> 12)
+#define MAPPABLE_WORDS     (MAPPABLE_MAX_PAGES / 32)
+
+static u32 minAddr, numPages;
+static u32 usedMap[MAPPABLE_WORDS];
+static u32 endMap[MAPPABLE_WORDS];
+static u32 externalMap[MAPPABLE_WORDS];
+static u32 verifiedMap[MAPPABLE_WORDS];
+static LightLock mappableLock = 1;
+
+static Result mappableQueryDefault(MemInfo* info, u32 addr)
+{
+	PageInfo pgInfo;
+	return svcQueryMemory(info, &pgInfo, addr);
+}
+
+static mappableQueryFunc queryFunc = mappableQueryDefault;
+
+static inline bool pageUsed(u32 page)
+{
+	return (usedMap[page >> 5] >> (page & 31)) & 1;
+}
+
+static void markPages(u32* map, u32 page, u32 count, bool set)
+{
+	while (count)
+	{
+		u32 bit = page & 31;
+		u32 n = 32 - bit < count ? 32 - bit : count;
+		u32 mask = (n == 32 ? ~0U : ((1U << n) - 1)) << bit;
+		if (set)
+			map[page >> 5] |= mask;
+		else
+			map[page >> 5] &= ~mask;
+		page += n;
+		count -= n;
+	}
+}
+
+static bool pagesVerified(u32 page, u32 count)
+{
+	for (; count; page ++, count --)
+		if (!((verifiedMap[page >> 5] >> (page & 31)) & 1))
+			return false;
+	return true;
+}
 
 void mappableInit(u32 addrMin, u32 addrMax)
 {
+	LightLock_Lock(&mappableLock);
 	minAddr = addrMin;
-	maxAddr = addrMax;
-	currentAddr = minAddr;
+	numPages = (addrMax - addrMin) >> 12;
+	if (numPages > MAPPABLE_MAX_PAGES)
+		numPages = MAPPABLE_MAX_PAGES;
+	for (u32 i = 0; i < MAPPABLE_WORDS; i ++)
+		usedMap[i] = endMap[i] = externalMap[i] = verifiedMap[i] = 0;
+	LightLock_Unlock(&mappableLock);
 }
 
-static u32 mappableFindAddressWithin(u32 start, u32 end, u32 size)
+void mappableSetQueryFunc(mappableQueryFunc func)
 {
-	MemInfo info;
-	PageInfo pgInfo;
+	queryFunc = func ? func : mappableQueryDefault;
+}
 
-	u32 addr = start;
-	while (addr >= start && (addr + size) < end && (addr + size) >= addr)
-	{
-		if (R_FAILED(svcQueryMemory(&info, &pgInfo, addr)))
-			return 0;
+// Clamps a range of addresses to the pages of the mappable area
+static void mappableRangeToPages(u32 addr, u32 end, u32* first, u32* last)
+{
+	u32 areaEnd = minAddr + (numPages << 12);
+	if (end <= addr || end > areaEnd) // A block may end at the top of the address space
+		end = areaEnd;
+	if (addr < minAddr)
+		addr = minAddr;
+	if (end < addr)
+		end = addr;
+	*first = (addr - minAddr) >> 12;
+	*last = (end - minAddr + 0xFFF) >> 12;
+}
 
-		if (info.state == MEMSTATE_FREE)
+static void mappableReserveExternal(u32 addr, u32 end)
+{
+	u32 first, last;
+	mappableRangeToPages(addr, end, &first, &last);
+
+	// Pages of allocations (which their owner may have mapped) stay as they are
+	for (u32 page = first; page < last; page ++)
+	{
+		u32 mask = 1U << (page & 31);
+		if (!(usedMap[page >> 5] & mask))
 		{
-			u32 sz = info.size - (addr - info.base_addr); // a free block might cover all the memory, etc.
-			if (sz >= size)
-				return addr;
+			usedMap[page >> 5] |= mask;
+			externalMap[page >> 5] |= mask;
 		}
+	}
+	markPages(verifiedMap, first, last - first, false);
+}
 
-		addr = info.base_addr + info.size;
+// Forgets the areas mapped without this allocator (they are found again by the next queries), returns false if there were none
+static bool mappableReleaseExternal(void)
+{
+	bool any = false;
+	for (u32 i = 0; i < MAPPABLE_WORDS; i ++)
+	{
+		if (!externalMap[i])
+			continue;
+		usedMap[i] &= ~externalMap[i];
+		externalMap[i] = 0;
+		any = true;
 	}
+	return any;
+}
 
-	return 0;
+static void mappableVerifyFree(const MemInfo* info)
+{
+	u32 first, last;
+	mappableRangeToPages(info->base_addr, info->base_addr + info->size, &first, &last);
+	markPages(verifiedMap, first, last - first, true);
 }
 
-void* mappableAlloc(size_t size)
+// First-fit search of a free run of pages, skipping fully used words
+static s32 mappableFindPages(u32 count, u32 alignment)
+{
+	u32 page = 0;
+	while (page + count <= numPages)
+	{
+		u32 addr = (minAddr + (page << 12) + alignment - 1) &~ (alignment - 1);
+		page = (addr - minAddr) >> 12;
+		if (page + count > numPages)
+			break;
+
+		if (!(page & 31) && usedMap[page >> 5] == ~0U)
+		{
+			page += 32;
+			continue;
+		}
+
+		u32 i;
+		for (i = 0; i < count && !pageUsed(page + i); i ++);
+		if (i == count)
+			return page;
+		page += i + 1;
+	}
+	return -1;
+}
+
+void* mappableAllocAligned(size_t size, size_t alignment)
 {
 	// Round up, can only allocate in page units
-	size = (size + 0xFFF) & ~0xFFF;
+	size = (size + 0xFFF) &~ 0xFFF;
+	if (!size)
+		return NULL;
+	if (alignment < 0x1000)
+		alignment = 0x1000;
+	else if (alignment & (alignment - 1))
+		return NULL; // Not a power of two
 
-	u32 addr = mappableFindAddressWithin(currentAddr, maxAddr, size);
-	if (addr == 0)
+	u32 count = size >> 12;
+	void* ret = NULL;
+	bool released = false;
+
+	LightLock_Lock(&mappableLock);
+	for (;;)
 	{
-		// Need to rollover (maybe)
-		addr = mappableFindAddressWithin(minAddr, currentAddr, size);
-		if (addr == 0)
-			return NULL;
+		s32 page = mappableFindPages(count, alignment);
+		if (page < 0)
+		{
+			// The areas mapped by other means may have been unmapped since they were reserved
+			if (released || !mappableReleaseExternal())
+				break;
+			released = true;
+			continue;
+		}
+
+		// Areas mapped without going through this allocator are only discovered here: check the
+		// candidate with a single query (unless it was already seen free), and reserve the area in
+		// use that made it fail before retrying.
+		u32 addr = minAddr + ((u32)page << 12);
+		if (!pagesVerified(page, count))
+		{
+			MemInfo info;
+			if (R_FAILED(queryFunc(&info, addr)))
+				break;
+			if (info.state == MEMSTATE_FREE)
+				mappableVerifyFree(&info);
+			if (info.state == MEMSTATE_FREE && info.base_addr + info.size - addr < size)
+			{
+				addr = info.base_addr + info.size;
+				if (addr - minAddr >= (numPages << 12) || R_FAILED(queryFunc(&info, addr)) || info.state == MEMSTATE_FREE)
+					break;
+			}
+			if (info.state != MEMSTATE_FREE)
+			{
+				mappableReserveExternal(addr, info.base_addr + info.size);
+				continue;
+			}
+		}
+
+		markPages(usedMap, page, count, true);
+		markPages(verifiedMap, page, count, false);
+		endMap[(page + count - 1) >> 5] |= 1U << ((page + count - 1) & 31);
+		ret = (void*)addr;
+		break;
 	}
+	LightLock_Unlock(&mappableLock);
 
-	currentAddr = addr + size >= maxAddr ? minAddr : addr + size;
-	return (void *)addr;
+	return ret;
+}
+
+void* mappableAlloc(size_t size)
+{
+	return mappableAllocAligned(size, 0x1000);
 }
 
 void mappableFree(void* mem)
 {
-	(void)mem;
+	u32 addr = (u32)mem;
+	if (addr < minAddr || (addr & 0xFFF))
+		return;
+
+	u32 page = (addr - minAddr) >> 12;
+
+	LightLock_Lock(&mappableLock);
+	if (page < numPages && pageUsed(page))
+	{
+		// Release pages up to (and including) the last page of the allocation; neighbouring free
+		// runs are coalesced implicitly by the bitmap
+		u32 end = page;
+		while (end < numPages && !((endMap[end >> 5] >> (end & 31)) & 1))
+			end ++;
+		if (end < numPages)
+		{
+			// The owner of the area unmapped it before freeing it
+			endMap[end >> 5] &= ~(1U << (end & 31));
+			markPages(usedMap, page, end + 1 - page, false);
+			markPages(verifiedMap, page, end + 1 - page, true);
+		}
+	}
+	LightLock_Unlock(&mappableLock);
 }
@@ -57,7 +57,7 @@ bool MemPool::Allocate(MemChunk& chunk, u32 size, int align)
 	for (auto b = first; b; b = b->next)
 	{
 		auto addr = b->base;
-		u32 begWaste = (u32)addr & alignMask;
+		u32 begWaste = (uintptr_t)addr & alignMask;
 		if (begWaste > 0) begWaste = alignMask + 1 - begWaste;
 		if (begWaste > b->size) continue;
 		addr += begWaste;
@@ -136,6 +136,35 @@ void MemPool::Deallocate(const MemChunk& chunk)
 	}
 }
 
+bool MemPool::Reclaim(const MemChunk& chunk)
+{
+	// Remove a range from the pool, only if it is entirely free
+	for (auto b = first; b; b = b->next)
+	{
+		if (b->base > chunk.addr) break;
+		if ((b->base + b->size) < (chunk.addr + chunk.size)) continue;
+
+		auto headSize = chunk.addr - b->base;
+		auto tailSize = (b->base + b->size) - (chunk.addr + chunk.size);
+		if (headSize && tailSize)
+		{
+			auto n = MemBlock::Create(chunk.addr + chunk.size, tailSize);
+			if (!n) return false;
+			InsertAfter(b, n);
+			b->size = headSize;
+		} else if (headSize)
+			b->size = headSize;
+		else if (tailSize)
+		{
+			b->base += chunk.size;
+			b->size = tailSize;
+		} else
+			DelBlock(b);
+		return true;
+	}
+	return false;
+}
+
 /*
 void MemPool::Dump(const char* title)
 {
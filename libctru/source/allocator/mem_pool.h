@@ -81,6 +81,7 @@ struct MemPool
 
 	bool Allocate(MemChunk& chunk, u32 size, int align);
 	void Deallocate(const MemChunk& chunk);
+	bool Reclaim(const MemChunk& chunk);
 
 	void Destroy()
 	{
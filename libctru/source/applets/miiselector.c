@@ -33,6 +33,34 @@ void miiSelectorLaunch(const MiiSelectorConf *conf, MiiSelectorReturn *returnbuf
 		memcpy(returnbuf, &ctx.ret, sizeof(MiiSelectorReturn));
 }
 
+static union {
+	MiiSelectorConf config;
+	MiiSelectorReturn ret;
+} miiSelectorCtx;
+static aptLibraryApplet miiSelectorApplet;
+
+bool miiSelectorLaunchAsync(const MiiSelectorConf *conf)
+{
+	if (miiSelectorApplet.running)
+		return false;
+
+	memcpy(&miiSelectorCtx.config, conf, sizeof(MiiSelectorConf));
+	miiSelectorCtx.config.magic = MIISELECTOR_MAGIC;
+
+	aptLaunchLibraryAppletAsync(&miiSelectorApplet, APPID_APPLETED, &miiSelectorCtx.config, sizeof(MiiSelectorConf), 0);
+	return true;
+}
+
+bool miiSelectorPoll(MiiSelectorReturn *returnbuf)
+{
+	if (!miiSelectorApplet.running || !aptLibraryAppletPoll(&miiSelectorApplet))
+		return false;
+
+	if(returnbuf)
+		memcpy(returnbuf, &miiSelectorCtx.ret, sizeof(MiiSelectorReturn));
+	return true;
+}
+
 static void miiSelectorConvertToUTF8(char* out, const u16* in, int max)
 {
 	if (!in || !*in)
@@ -13,6 +13,9 @@
 
 static char* swkbdSharedMem;
 static Handle swkbdSharedMemHandle;
+static size_t swkbdSharedMemSize;
+static SwkbdExtra swkbdExtra;
+static aptLibraryApplet swkbdApplet;
 
 void swkbdInit(SwkbdState* swkbd, SwkbdType type, int numButtons, int maxTextLength)
 {
@@ -167,9 +170,52 @@ static void swkbdMessageCallback(void* user, NS_APPID sender, void* msg, size_t
 	APT_SendParameter(envGetAptAppId(), sender, APTCMD_MESSAGE, swkbd, sizeof(*swkbd), 0);
 }
 
-SwkbdButton swkbdInputText(SwkbdState* swkbd, char* buf, size_t bufsize)
+void swkbdFreeSharedMem(void)
+{
+	if (!swkbdSharedMem || swkbdApplet.running)
+		return;
+
+	svcCloseHandle(swkbdSharedMemHandle);
+	free(swkbdSharedMem);
+	swkbdSharedMem = NULL;
+	swkbdSharedMemSize = 0;
+}
+
+// The shared memory block is kept across invocations and only recreated when it is too small
+static bool swkbdAllocSharedMem(size_t size)
+{
+	if (swkbdSharedMem && swkbdSharedMemSize >= size)
+		return true;
+
+	swkbdFreeSharedMem();
+
+	// Allocate sharedmem
+	swkbdSharedMem = (char*)memalign(0x1000, size);
+	if (!swkbdSharedMem)
+		return false;
+
+	// Create sharedmem block
+	Result res = svcCreateMemoryBlock(&swkbdSharedMemHandle, (u32)swkbdSharedMem, size, MEMPERM_READ|MEMPERM_WRITE, MEMPERM_READ|MEMPERM_WRITE);
+	if (R_FAILED(res))
+	{
+		free(swkbdSharedMem);
+		swkbdSharedMem = NULL;
+		return false;
+	}
+
+	swkbdSharedMemSize = size;
+	return true;
+}
+
+bool swkbdInputTextAsync(SwkbdState* swkbd)
 {
-	SwkbdExtra extra = swkbd->extra; // Struct copy
+	if (swkbdApplet.running)
+	{
+		swkbd->result = SWKBD_INVALID_INPUT;
+		return false;
+	}
+
+	swkbdExtra = swkbd->extra; // Struct copy
 
 	// Calculate sharedmem size
 	size_t sharedMemSize = 0;
@@ -191,56 +237,49 @@ SwkbdButton swkbdInputText(SwkbdState* swkbd, char* buf, size_t bufsize)
 		sharedMemSize += sizeof(SwkbdLearningData);
 	}
 	sharedMemSize  = (sharedMemSize + 0xFFF) &~ 0xFFF;
-	swkbd->shared_memory_size = sharedMemSize;
 
-	// Allocate sharedmem
-	swkbdSharedMem = (char*)memalign(0x1000, sharedMemSize);
-	if (!swkbdSharedMem)
+	if (!swkbdAllocSharedMem(sharedMemSize))
 	{
 		swkbd->result = SWKBD_OUTOFMEM;
-		return SWKBD_BUTTON_NONE;
-	}
-
-	// Create sharedmem block
-	Result res = svcCreateMemoryBlock(&swkbdSharedMemHandle, (u32)swkbdSharedMem, sharedMemSize, MEMPERM_READ|MEMPERM_WRITE, MEMPERM_READ|MEMPERM_WRITE);
-	if (R_FAILED(res))
-	{
-		free(swkbdSharedMem);
-		swkbd->result = SWKBD_OUTOFMEM;
-		return SWKBD_BUTTON_NONE;
+		return false;
 	}
+	swkbd->shared_memory_size = swkbdSharedMemSize;
 
 	// Copy stuff to shared mem
-	if (extra.initial_text)
+	if (swkbdExtra.initial_text)
 	{
 		swkbd->initial_text_offset = 0;
-		swkbdConvertToUTF16((u16*)swkbdSharedMem, extra.initial_text, swkbd->max_text_len);
+		swkbdConvertToUTF16((u16*)swkbdSharedMem, swkbdExtra.initial_text, swkbd->max_text_len);
 	}
-	if (extra.dict)
+	if (swkbdExtra.dict)
 	{
 		swkbd->dict_offset = dictOff;
-		memcpy(swkbdSharedMem+dictOff, extra.dict, sizeof(SwkbdDictWord)*swkbd->dict_word_count);
+		memcpy(swkbdSharedMem+dictOff, swkbdExtra.dict, sizeof(SwkbdDictWord)*swkbd->dict_word_count);
 	}
 	if (swkbd->initial_status_offset >= 0)
 	{
 		swkbd->initial_status_offset = statusOff;
-		memcpy(swkbdSharedMem+statusOff, extra.status_data, sizeof(SwkbdStatusData));
+		memcpy(swkbdSharedMem+statusOff, swkbdExtra.status_data, sizeof(SwkbdStatusData));
 	}
 	if (swkbd->initial_learning_offset >= 0)
 	{
 		swkbd->initial_learning_offset = learningOff;
-		memcpy(swkbdSharedMem+learningOff, extra.learning_data, sizeof(SwkbdLearningData));
+		memcpy(swkbdSharedMem+learningOff, swkbdExtra.learning_data, sizeof(SwkbdLearningData));
 	}
 
-	if (extra.callback) swkbd->filter_flags |= SWKBD_FILTER_CALLBACK;
-	else                swkbd->filter_flags &= ~SWKBD_FILTER_CALLBACK;
+	if (swkbdExtra.callback) swkbd->filter_flags |= SWKBD_FILTER_CALLBACK;
+	else                     swkbd->filter_flags &= ~SWKBD_FILTER_CALLBACK;
 
 	// Launch swkbd
 	memset(swkbd->reserved, 0, sizeof(swkbd->reserved));
-	if (extra.callback) aptSetMessageCallback(swkbdMessageCallback, &extra);
-	aptLaunchLibraryApplet(APPID_SOFTWARE_KEYBOARD, swkbd, sizeof(*swkbd), swkbdSharedMemHandle);
-	if (extra.callback) aptSetMessageCallback(NULL, NULL);
-	svcCloseHandle(swkbdSharedMemHandle);
+	if (swkbdExtra.callback) aptSetMessageCallback(swkbdMessageCallback, &swkbdExtra);
+	aptLaunchLibraryAppletAsync(&swkbdApplet, APPID_SOFTWARE_KEYBOARD, swkbd, sizeof(*swkbd), swkbdSharedMemHandle);
+	return true;
+}
+
+static SwkbdButton swkbdFinish(SwkbdState* swkbd, char* buf, size_t bufsize)
+{
+	if (swkbdExtra.callback) aptSetMessageCallback(NULL, NULL);
 
 	SwkbdButton button = SWKBD_BUTTON_NONE;
 	switch (swkbd->result)
@@ -264,9 +303,27 @@ SwkbdButton swkbdInputText(SwkbdState* swkbd, char* buf, size_t bufsize)
 	u16* text16 = (u16*)(swkbdSharedMem+swkbd->text_offset);
 	text16[swkbd->text_length] = 0;
 	swkbdConvertToUTF8(buf, text16, bufsize-1);
-	if (swkbd->save_state_flags & BIT(0)) memcpy(extra.status_data, swkbdSharedMem+swkbd->status_offset, sizeof(SwkbdStatusData));
-	if (swkbd->save_state_flags & BIT(1)) memcpy(extra.learning_data, swkbdSharedMem+swkbd->learning_offset, sizeof(SwkbdLearningData));
+	if (swkbd->save_state_flags & BIT(0)) memcpy(swkbdExtra.status_data, swkbdSharedMem+swkbd->status_offset, sizeof(SwkbdStatusData));
+	if (swkbd->save_state_flags & BIT(1)) memcpy(swkbdExtra.learning_data, swkbdSharedMem+swkbd->learning_offset, sizeof(SwkbdLearningData));
 
-	free(swkbdSharedMem);
 	return button;
 }
+
+bool swkbdInputTextPoll(SwkbdState* swkbd, char* buf, size_t bufsize, SwkbdButton* button)
+{
+	// Nothing to report if no keyboard is up (the shared memory may not even exist)
+	if (!swkbdApplet.running || !aptLibraryAppletPoll(&swkbdApplet))
+		return false;
+
+	*button = swkbdFinish(swkbd, buf, bufsize);
+	return true;
+}
+
+SwkbdButton swkbdInputText(SwkbdState* swkbd, char* buf, size_t bufsize)
+{
+	if (!swkbdInputTextAsync(swkbd))
+		return SWKBD_BUTTON_NONE;
+
+	aptLibraryAppletWait(&swkbdApplet);
+	return swkbdFinish(swkbd, buf, bufsize);
+}
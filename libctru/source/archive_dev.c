@@ -10,6 +10,8 @@
 
 #include <3ds/types.h>
 #include <3ds/result.h>
+#include <3ds/os.h>
+#include <3ds/svc.h>
 #include <3ds/archive.h>
 #include <3ds/services/fs.h>
 #include <3ds/util/utf.h>
@@ -48,17 +50,17 @@ static int       archive_chmod(struct _reent *r, const char *path, mode_t mode);
 static int       archive_fchmod(struct _reent *r, void *fd, mode_t mode);
 static int       archive_rmdir(struct _reent *r, const char *name);
 
-/// Used for only the SD archive, about which information can actually be found
-static int       sdmc_statvfs(struct _reent *r, const char *path, struct statvfs *buf);
-
 /*! @cond INTERNAL */
 
 /*! Open file struct */
 typedef struct
 {
-  Handle fd;     /*! CTRU handle */
-  int    flags;  /*! Flags used in open(2) */
-  u64    offset; /*! Current file offset */
+  Handle fd;         /*! CTRU handle */
+  int    flags;      /*! Flags used in open(2) */
+  u64    offset;     /*! Current file offset */
+  s32    device;     /*! Index of the device the file was opened on */
+  bool   size_known; /*! Whether size is known */
+  u64    size;       /*! File size, tracked for the free space accounting */
 } archive_file_t;
 
 /*! archive devoptab */
@@ -94,11 +96,32 @@ archive_devoptab =
   .rmdir_r      = archive_rmdir,
 };
 
+/*! Cached free space of a device */
+typedef struct
+{
+  bool valid;          /*! Whether the cache is valid */
+  bool readonly;       /*! Whether the archive is read-only */
+  u32  cluster_size;   /*! Allocation unit */
+  u32  total_clusters; /*! Total clusters, 0 if unknown */
+  s64  free_clusters;  /*! Free clusters, decremented locally as files grow */
+  u64  tick;           /*! System tick of the last refresh */
+} archive_space_t;
+
+/*! Free space cache lifetime (ms) */
+#define ARCHIVE_SPACE_CACHE_MS 5000
+
 typedef struct
 {
     bool setup;
     bool is_extdata;
+    bool is_sdmc;
+    bool is_savedata;
     s32 id;
+    FS_ArchiveID archive_id;   /*! Archive ID and path, to reopen save data archives */
+    FS_PathType  path_type;
+    u32          path_size;
+    u8           path_data[0x20];
+    archive_space_t space;
     devoptab_t device;
     FS_Archive archive;
     char* cwd;
@@ -111,6 +134,8 @@ static archive_fsdevice archive_devices[8];
 
 /*! @endcond */
 
+static void archive_space_resize(archive_file_t *file, u64 size, bool truncated);
+
 static archive_fsdevice *archiveFindDevice(const char *name)
 {
   u32 i;
@@ -296,6 +321,9 @@ static int _archiveMountDevice(FS_Archive       archive,
     goto _fail;
 
   device->archive = archive;
+  device->is_sdmc = false;
+  device->is_savedata = false;
+  device->space.valid = false;
   memset(device->name, 0, sizeof(device->name));
   strncpy(device->name, deviceName, sizeof(device->name)-1);
 
@@ -343,6 +371,18 @@ Result archiveMount(FS_ArchiveID archiveID,
       {
         device->is_extdata = true;
       }
+
+      /* Uncommitted save data changes are discarded by reopening the archive (see archiveTransactionCommit) */
+      if ((archiveID == ARCHIVE_SAVEDATA || archiveID == ARCHIVE_SYSTEM_SAVEDATA || archiveID == ARCHIVE_SYSTEM_SAVEDATA2
+        || archiveID == ARCHIVE_GAMECARD_SAVEDATA || archiveID == ARCHIVE_USER_SAVEDATA || archiveID == ARCHIVE_DEMO_SAVEDATA)
+        && archivePath.size <= sizeof(device->path_data))
+      {
+        device->is_savedata = true;
+        device->archive_id  = archiveID;
+        device->path_type   = archivePath.type;
+        device->path_size   = archivePath.size;
+        memcpy(device->path_data, archivePath.data, archivePath.size);
+      }
     }
   }
   return rc;
@@ -371,7 +411,7 @@ Result archiveMountSdmc(void)
     {
       if (device)
       {
-        device->device.statvfs_r = sdmc_statvfs; // set SDMC's statvfs to the device
+        device->is_sdmc = true; // the SD card reports its clusters
       }
       if(__system_argc != 0 && __system_argv[0] != NULL)
       {
@@ -577,11 +617,24 @@ archive_open(struct _reent *r,
         r->_errno = archive_translate_error(rc);
         return -1;
       }
+      device->space.valid = false;
     }
 
-    file->fd     = fd;
-    file->flags  = (flags & (O_ACCMODE|O_APPEND|O_SYNC));
-    file->offset = 0;
+    file->fd         = fd;
+    file->flags      = (flags & (O_ACCMODE|O_APPEND|O_SYNC));
+    file->offset     = 0;
+    file->device     = device->id;
+
+    /* track the size of writable files for the free space accounting */
+    if((flags & O_ACCMODE) == O_RDONLY)
+    {
+      file->size       = 0;
+      file->size_known = false;
+      return 0;
+    }
+
+    file->size       = 0;
+    file->size_known = (flags & O_TRUNC) || R_SUCCEEDED(FSFILE_GetSize(fd, &file->size));
     return 0;
   }
 
@@ -668,6 +721,7 @@ archive_write(struct _reent *r,
   }
 
   file->offset += bytes;
+  archive_space_resize(file, file->offset, false);
 
   return bytes;
 }
@@ -894,7 +948,10 @@ archive_unlink(struct _reent *r,
 
   rc = FSUSER_DeleteFile(device->archive, fs_path);
   if(R_SUCCEEDED(rc))
+  {
+    device->space.valid = false;
     return 0;
+  }
 
   r->_errno = archive_translate_error(rc);
   return -1;
@@ -987,6 +1044,7 @@ archive_rename(struct _reent *r,
       r->_errno = archive_translate_error(rc);
       return -1;
     }
+    sourceDevice->space.valid = false;
     rc = FSUSER_RenameFile(sourceDevice->archive, fs_path_old, sourceDevice->archive, fs_path_new);
     if(R_SUCCEEDED(rc)) return 0;
   } else if(R_SUCCEEDED(rc)) return 0;
@@ -1224,62 +1282,98 @@ archive_dirclose(struct _reent *r,
   return -1;
 }
 
-/*! Get filesystem statistics for an archive
+/*! Refresh the free space cache of a device if needed
  *
- *  @param[in,out] r    newlib reentrancy struct
- *  @param[in]     path Path to filesystem to get statistics of
- *  @param[out]    buf  Buffer to fill
+ *  @param[in] device Device
  *
  *  @returns 0 for success
- *  @returns -1 for error
+ *  @returns FS error otherwise
  */
-static int
-archive_statvfs(struct _reent  *r,
-                const char     *path,
-                struct statvfs *buf)
+static Result
+archive_space_refresh(archive_fsdevice *device)
 {
-  // Result rc;
-  // u32 totalSize, directories, files;
-  // bool duplicateData;
+  Result             rc;
+  FS_ArchiveResource resource;
+  u64                free_bytes;
+  bool               writable = false;
+  archive_space_t    *space = &device->space;
+  u64                now = svcGetSystemTick();
 
-  // rc = FSUSER_GetFormatInfo(&totalSize, &directories, &files, &duplicateData, )
+  if(space->valid && now - space->tick < (u64)ARCHIVE_SPACE_CACHE_MS*CPU_TICKS_PER_MSEC)
+    return 0;
 
-  r->_errno = ENOSYS;
+  if(device->is_sdmc)
+  {
+    rc = FSUSER_GetSdmcArchiveResource(&resource);
+    if(R_FAILED(rc))
+      return rc;
 
-  return -1;
+    space->cluster_size   = resource.clusterSize;
+    space->total_clusters = resource.totalClusters;
+    space->free_clusters  = resource.freeClusters;
+
+    rc = FSUSER_IsSdmcWritable(&writable);
+    space->readonly = R_FAILED(rc) || !writable;
+  }
+  else
+  {
+    /* other archives only report their free bytes; count them in sectors */
+    rc = FSUSER_GetFreeBytes(&free_bytes, device->archive);
+    if(R_FAILED(rc))
+      return rc;
+
+    space->cluster_size   = 0x200;
+    space->total_clusters = 0;
+    space->free_clusters  = free_bytes / space->cluster_size;
+    space->readonly       = device->is_extdata;
+  }
 
-  // Result rc;
-  // FS_ArchiveResource resource;
-  // bool writable = false;
-
-  // rc = FSUSER_GetArchiveResource(&resource);
-
-  // if(R_SUCCEEDED(rc))
-  // {
-  //   buf->f_bsize   = resource.clusterSize;
-  //   buf->f_frsize  = resource.clusterSize;
-  //   buf->f_blocks  = resource.totalClusters;
-  //   buf->f_bfree   = resource.freeClusters;
-  //   buf->f_bavail  = resource.freeClusters;
-  //   buf->f_files   = 0; //??? how to get
-  //   buf->f_ffree   = resource.freeClusters;
-  //   buf->f_favail  = resource.freeClusters;
-  //   buf->f_fsid    = 0; //??? how to get
-  //   buf->f_flag    = ST_NOSUID;
-  //   buf->f_namemax = 0; //??? how to get
-
-  //   rc = FSUSER_IsarchiveWritable(&writable);
-  //   if(R_FAILED(rc) || !writable)
-  //     buf->f_flag |= ST_RDONLY;
-
-  //   return 0;
-  // }
-
-  // r->_errno = archive_translate_error(rc);
-  // return -1;
+  space->tick  = now;
+  space->valid = true;
+  return 0;
+}
+
+/*! Account for the new size of a file in the free space cache
+ *
+ *  @param[in,out] file      Open file
+ *  @param[in]     size      New size, or the end of the last write
+ *  @param[in]     truncated Whether the size was set (rather than extended by a write)
+ */
+static void
+archive_space_resize(archive_file_t *file,
+                     u64            size,
+                     bool           truncated)
+{
+  archive_space_t *space = &archive_devices[file->device].space;
+
+  if(!file->size_known)
+  {
+    space->valid = false;
+    return;
+  }
+
+  if(size == file->size || (!truncated && size < file->size))
+    return;
+
+  /* space was freed: refresh on the next query */
+  if(size < file->size)
+    space->valid = false;
+  else if(space->valid)
+  {
+    u64 cs = space->cluster_size;
+    space->free_clusters -= (size + cs - 1)/cs - (file->size + cs - 1)/cs;
+    if(space->free_clusters < 0)
+      space->free_clusters = 0;
+  }
+
+  file->size = size;
 }
 
-/*! Get filesystem statistics for the SD card
+/*! Get filesystem statistics
+ *
+ *  Free space is cached per device and decremented locally as files grow, so
+ *  repeated calls don't need IPC. The cache is refreshed when files are deleted
+ *  or shrunk and after ARCHIVE_SPACE_CACHE_MS.
  *
  *  @param[in,out] r    newlib reentrancy struct
  *  @param[in]     path Path to filesystem to get statistics of
@@ -1289,39 +1383,58 @@ archive_statvfs(struct _reent  *r,
  *  @returns -1 for error
  */
 static int
-sdmc_statvfs(struct _reent  *r,
-             const char     *path,
-             struct statvfs *buf)
+archive_statvfs(struct _reent  *r,
+                const char     *path,
+                struct statvfs *buf)
 {
   Result rc;
-  FS_ArchiveResource resource;
-  bool writable = false;
+  archive_fsdevice *device = r->deviceData;
 
-  rc = FSUSER_GetSdmcArchiveResource(&resource);
+  if(archive_fixpath(r, path, &device) == NULL)
+    return -1;
 
-  if(R_SUCCEEDED(rc))
+  rc = archive_space_refresh(device);
+  if(R_FAILED(rc))
   {
-    buf->f_bsize   = resource.clusterSize;
-    buf->f_frsize  = resource.clusterSize;
-    buf->f_blocks  = resource.totalClusters;
-    buf->f_bfree   = resource.freeClusters;
-    buf->f_bavail  = resource.freeClusters;
-    buf->f_files   = 0; //??? how to get
-    buf->f_ffree   = resource.freeClusters;
-    buf->f_favail  = resource.freeClusters;
-    buf->f_fsid    = 0; //??? how to get
-    buf->f_flag    = ST_NOSUID;
-    buf->f_namemax = 0; //??? how to get
+    r->_errno = archive_translate_error(rc);
+    return -1;
+  }
 
-    rc = FSUSER_IsSdmcWritable(&writable);
-    if(R_FAILED(rc) || !writable)
-      buf->f_flag |= ST_RDONLY;
+  const archive_space_t *space = &device->space;
 
-    return 0;
-  }
+  buf->f_bsize   = space->cluster_size;
+  buf->f_frsize  = space->cluster_size;
+  buf->f_blocks  = space->total_clusters ? space->total_clusters : (fsblkcnt_t)space->free_clusters;
+  buf->f_bfree   = space->free_clusters;
+  buf->f_bavail  = space->free_clusters;
+  buf->f_files   = 0; //??? how to get
+  buf->f_ffree   = space->free_clusters;
+  buf->f_favail  = space->free_clusters;
+  buf->f_fsid    = device->id;
+  buf->f_flag    = ST_NOSUID;
+  buf->f_namemax = 0; //??? how to get
 
-  r->_errno = archive_translate_error(rc);
-  return -1;
+  if(space->readonly)
+    buf->f_flag |= ST_RDONLY;
+
+  return 0;
+}
+
+Result
+archiveGetFreeBytes(const char *deviceName,
+                    u64        *freeBytes)
+{
+  Result           rc;
+  archive_fsdevice *device = archiveFindDevice(deviceName);
+
+  if(device == NULL)
+    return -1;
+
+  rc = archive_space_refresh(device);
+  if(R_SUCCEEDED(rc))
+    *freeBytes = (u64)device->space.free_clusters * device->space.cluster_size;
+
+  return rc;
 }
 
 /*! Truncate an open file
@@ -1353,7 +1466,10 @@ archive_ftruncate(struct _reent *r,
   /* set the new file size */
   rc = FSFILE_SetSize(file->fd, len);
   if(R_SUCCEEDED(rc))
+  {
+    archive_space_resize(file, len, true);
     return 0;
+  }
 
   r->_errno = archive_translate_error(rc);
   return -1;
@@ -1449,7 +1565,10 @@ archive_rmdir(struct _reent *r,
 
   rc = FSUSER_DeleteDirectory(device->archive, fs_path);
   if(R_SUCCEEDED(rc))
+  {
+    device->space.valid = false;
     return 0;
+  }
 
   r->_errno = archive_translate_error(rc);
   return -1;
@@ -1487,6 +1606,496 @@ archive_getmtime(const char *name,
   return rc;
 }
 
+/*! @cond INTERNAL */
+
+#define ARCHIVE_TXN_BLOCK_SIZE 0x1000
+#define ARCHIVE_TXN_RUN_BLOCKS 16
+
+/*! Staged block of a file */
+typedef struct archive_txn_block
+{
+  struct archive_txn_block *next;  /*! Next block, sorted by index */
+  u64                      index;  /*! Block index in the file */
+  u32                      lo, hi; /*! Dirty range within the block */
+  u8                       data[ARCHIVE_TXN_BLOCK_SIZE];
+} archive_txn_block_t;
+
+/*! File touched by a transaction */
+typedef struct archive_txn_file
+{
+  struct archive_txn_file *next;
+  char                    *path;      /*! Absolute path within the archive */
+  Handle                  fd;         /*! Read handle, 0 if the file wasn't opened (yet) */
+  bool                    exists;     /*! Whether the file exists in the archive */
+  bool                    resized;    /*! Whether the size must be set at commit */
+  u64                     size;       /*! Staged file size */
+  u64                     orig_size;  /*! Size of the file in the archive */
+  u64                     disk_size;  /*! Size of the archive contents still valid for this file */
+  archive_txn_block_t     *blocks;    /*! Staged blocks */
+  archive_txn_block_t     *last;      /*! Last block looked up, for sequential access */
+} archive_txn_file_t;
+
+struct archiveTransaction
+{
+  archive_fsdevice   *device;
+  archive_txn_file_t *files;
+  size_t             staged; /*! Memory used by the staged blocks */
+};
+
+/*! @endcond */
+
+static void
+archive_txn_free(archiveTransaction *txn)
+{
+  archive_txn_file_t *file, *next_file;
+  archive_txn_block_t *block, *next_block;
+
+  for(file = txn->files; file != NULL; file = next_file)
+  {
+    next_file = file->next;
+    for(block = file->blocks; block != NULL; block = next_block)
+    {
+      next_block = block->next;
+      free(block);
+    }
+    if(file->fd)
+      FSFILE_Close(file->fd);
+    free(file->path);
+    free(file);
+  }
+  free(txn);
+}
+
+/*! Find or add a file to a transaction
+ *
+ *  @param[in] txn  Transaction
+ *  @param[in] path Path of the file
+ *
+ *  @returns the file, or NULL on failure (errno is set)
+ */
+static archive_txn_file_t*
+archive_txn_file(archiveTransaction *txn,
+                 const char         *path)
+{
+  struct _reent      r;
+  archive_txn_file_t *file;
+  archive_fsdevice   *device = txn->device;
+  FS_Path            fs_path;
+
+  r._errno = 0;
+  path = archive_fixpath(&r, path, &device);
+  if(path == NULL)
+  {
+    errno = r._errno;
+    return NULL;
+  }
+
+  for(file = txn->files; file != NULL; file = file->next)
+  {
+    if(strcmp(file->path, path) == 0)
+      return file;
+  }
+
+  file = (archive_txn_file_t*)calloc(1, sizeof(archive_txn_file_t));
+  if(file == NULL || (file->path = strdup(path)) == NULL)
+  {
+    free(file);
+    errno = ENOMEM;
+    return NULL;
+  }
+
+  /* get the current size, the file doesn't have to exist */
+  fs_path = archive_utf16path(&r, file->path, &device);
+  if(fs_path.data != NULL
+  && R_SUCCEEDED(FSUSER_OpenFile(&file->fd, device->archive, fs_path, FS_OPEN_READ, 0)))
+  {
+    file->exists = true;
+    if(R_FAILED(FSFILE_GetSize(file->fd, &file->size)))
+      file->size = 0;
+  }
+  else
+    file->fd = 0;
+
+  file->orig_size = file->disk_size = file->size;
+  file->next = txn->files;
+  txn->files = file;
+  return file;
+}
+
+/*! Read the archive contents of a file, zero-filling what isn't backed by the archive */
+static Result
+archive_txn_read_disk(archive_txn_file_t *file,
+                      u64                offset,
+                      u8                 *buf,
+                      u32                size)
+{
+  u32    bytes = 0;
+  Result rc = 0;
+
+  if(offset < file->disk_size && file->fd)
+  {
+    u32 avail = (u32)MIN((u64)size, file->disk_size - offset);
+    rc = FSFILE_Read(file->fd, &bytes, offset, buf, avail);
+    if(R_FAILED(rc))
+      bytes = 0;
+  }
+
+  memset(buf + bytes, 0, size - bytes);
+  return rc;
+}
+
+/*! Find a staged block, optionally creating it */
+static archive_txn_block_t*
+archive_txn_block(archiveTransaction *txn,
+                  archive_txn_file_t *file,
+                  u64                index,
+                  bool               create)
+{
+  archive_txn_block_t **link = &file->blocks, *block;
+
+  /* blocks are usually accessed in order, so start from the last one if possible */
+  if(file->last != NULL && file->last->index <= index)
+    link = &file->last->next;
+  if(file->last != NULL && file->last->index == index)
+    return file->last;
+
+  while(*link != NULL && (*link)->index < index)
+    link = &(*link)->next;
+
+  if(*link != NULL && (*link)->index == index)
+    return file->last = *link;
+  if(!create)
+    return NULL;
+
+  block = (archive_txn_block_t*)malloc(sizeof(archive_txn_block_t));
+  if(block == NULL)
+    return NULL;
+
+  block->index = index;
+  block->lo = block->hi = 0;
+  block->next = *link;
+  *link = block;
+  txn->staged += sizeof(archive_txn_block_t);
+  return file->last = block;
+}
+
+Result
+archiveTransactionBegin(archiveTransaction **txn,
+                        const char         *deviceName)
+{
+  archive_fsdevice *device = archiveFindDevice(deviceName);
+  if(device == NULL)
+    return -1;
+
+  /* Only save data can be written atomically, and have its pending changes discarded when a commit fails */
+  if(!device->is_savedata)
+  {
+    errno = ENOTSUP;
+    return -1;
+  }
+
+  *txn = (archiveTransaction*)calloc(1, sizeof(archiveTransaction));
+  if(*txn == NULL)
+    return MAKERESULT(RL_FATAL, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+  (*txn)->device = device;
+  return 0;
+}
+
+Result
+archiveTransactionWrite(archiveTransaction *txn,
+                        const char         *path,
+                        u64                offset,
+                        const void         *data,
+                        u32                size)
+{
+  archive_txn_file_t  *file = archive_txn_file(txn, path);
+  archive_txn_block_t *block;
+  const u8            *src = (const u8*)data;
+
+  if(file == NULL)
+    return -1;
+
+  /* like pwrite, writing nothing doesn't extend the file */
+  if(size == 0)
+    return 0;
+
+  while(size > 0)
+  {
+    u64 index = offset / ARCHIVE_TXN_BLOCK_SIZE;
+    u32 lo    = (u32)(offset % ARCHIVE_TXN_BLOCK_SIZE);
+    u32 hi    = MIN(lo + size, ARCHIVE_TXN_BLOCK_SIZE);
+
+    block = archive_txn_block(txn, file, index, true);
+    if(block == NULL)
+      return MAKERESULT(RL_FATAL, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+    if(block->lo == block->hi)
+    {
+      block->lo = lo;
+      block->hi = hi;
+    }
+    else if(hi < block->lo || lo > block->hi)
+    {
+      /* the dirty range must stay contiguous: fill the gap with the current contents */
+      u32 gap_lo = hi < block->lo ? hi : block->hi;
+      u32 gap_hi = hi < block->lo ? block->lo : lo;
+      Result rc = archive_txn_read_disk(file, index*ARCHIVE_TXN_BLOCK_SIZE + gap_lo, block->data + gap_lo, gap_hi - gap_lo);
+      if(R_FAILED(rc))
+        return rc;
+    }
+    block->lo = MIN(block->lo, lo);
+    block->hi = MAX(block->hi, hi);
+
+    memcpy(block->data + lo, src, hi - lo);
+    src    += hi - lo;
+    offset += hi - lo;
+    size   -= hi - lo;
+  }
+
+  if(offset > file->size)
+    file->size = offset;
+
+  return 0;
+}
+
+Result
+archiveTransactionSetSize(archiveTransaction *txn,
+                          const char         *path,
+                          u64                size)
+{
+  archive_txn_file_t  *file = archive_txn_file(txn, path);
+  archive_txn_block_t **link, *block;
+
+  if(file == NULL)
+    return -1;
+
+  /* drop the staged data past the new end of file */
+  link = &file->blocks;
+  while((block = *link) != NULL)
+  {
+    u64 start = block->index*ARCHIVE_TXN_BLOCK_SIZE;
+    if(start + block->hi <= size)
+    {
+      link = &block->next;
+      continue;
+    }
+
+    if(start + block->lo < size)
+    {
+      block->hi = (u32)(size - start);
+      link = &block->next;
+      continue;
+    }
+
+    *link = block->next;
+    txn->staged -= sizeof(archive_txn_block_t);
+    free(block);
+  }
+
+  file->last      = NULL;
+  file->size      = size;
+  file->disk_size = MIN(file->disk_size, size);
+  file->resized   = true;
+  return 0;
+}
+
+Result
+archiveTransactionRead(archiveTransaction *txn,
+                       const char         *path,
+                       u64                offset,
+                       void               *buffer,
+                       u32                size,
+                       u32                *bytesRead)
+{
+  archive_txn_file_t  *file = archive_txn_file(txn, path);
+  archive_txn_block_t *block;
+  u8                  *dst = (u8*)buffer;
+  Result              rc;
+
+  if(file == NULL)
+    return -1;
+
+  if(offset >= file->size)
+    size = 0;
+  else
+    size = (u32)MIN((u64)size, file->size - offset);
+
+  rc = archive_txn_read_disk(file, offset, dst, size);
+  if(R_FAILED(rc))
+    return rc;
+
+  /* overlay the staged data */
+  for(block = file->blocks; block != NULL; block = block->next)
+  {
+    u64 lo = block->index*ARCHIVE_TXN_BLOCK_SIZE + block->lo;
+    u64 hi = block->index*ARCHIVE_TXN_BLOCK_SIZE + block->hi;
+    if(hi <= offset)
+      continue;
+    if(lo >= offset + size)
+      break;
+
+    lo = MAX(lo, offset);
+    hi = MIN(hi, offset + size);
+    memcpy(dst + (lo - offset), block->data + (lo % ARCHIVE_TXN_BLOCK_SIZE), hi - lo);
+  }
+
+  if(bytesRead != NULL)
+    *bytesRead = size;
+  return 0;
+}
+
+size_t
+archiveTransactionGetStagedSize(archiveTransaction *txn)
+{
+  return txn->staged;
+}
+
+/*! Write the staged data of a file
+ *
+ *  Consecutive dirty ranges are written with a single request through a bounce buffer.
+ */
+static Result
+archive_txn_flush_file(archive_fsdevice   *device,
+                       archive_txn_file_t *file,
+                       u8                 *run)
+{
+  struct _reent       r;
+  Handle              fd;
+  FS_Path             fs_path;
+  Result              rc;
+  u32                 bytes;
+  archive_txn_block_t *block = file->blocks;
+
+  r._errno = 0;
+  fs_path = archive_utf16path(&r, file->path, &device);
+  if(fs_path.data == NULL)
+  {
+    errno = r._errno;
+    return -1;
+  }
+
+  if(file->fd)
+  {
+    FSFILE_Close(file->fd);
+    file->fd = 0;
+  }
+
+  rc = FSUSER_OpenFile(&fd, device->archive, fs_path, FS_OPEN_WRITE | FS_OPEN_CREATE, 0);
+  if(R_FAILED(rc))
+    return rc;
+
+  /* truncate first if the contents past the staged end of file were dropped */
+  if(file->disk_size < file->orig_size)
+    rc = FSFILE_SetSize(fd, file->disk_size);
+  if(R_SUCCEEDED(rc) && (file->resized || !file->exists))
+    rc = FSFILE_SetSize(fd, file->size);
+
+  while(R_SUCCEEDED(rc) && block != NULL)
+  {
+    u64 offset = block->index*ARCHIVE_TXN_BLOCK_SIZE + block->lo;
+    u32 len    = block->hi - block->lo;
+    const u8 *src = block->data + block->lo;
+
+    /* gather the following blocks if the dirty ranges are contiguous */
+    u32 count = 1;
+    while(block->next != NULL && count < ARCHIVE_TXN_RUN_BLOCKS
+       && block->hi == ARCHIVE_TXN_BLOCK_SIZE
+       && block->next->index == block->index + 1 && block->next->lo == 0)
+    {
+      if(count++ == 1)
+      {
+        memcpy(run, src, len);
+        src = run;
+      }
+      block = block->next;
+      memcpy(run + len, block->data, block->hi);
+      len += block->hi;
+    }
+
+    rc = FSFILE_Write(fd, &bytes, offset, src, len, 0);
+    block = block->next;
+  }
+
+  FSFILE_Close(fd);
+  return rc;
+}
+
+/*! Discard the uncommitted changes of a save data archive by closing and reopening it
+ *
+ *  @param[in] device Device of the archive
+ *
+ *  @returns 0 for success
+ *  @returns The error of the close or the reopen, the device is unmounted then
+ */
+static Result
+archive_txn_discard(archive_fsdevice *device)
+{
+  FS_Path path = { device->path_type, device->path_size, device->path_data };
+  Result  rc   = FSUSER_CloseArchive(device->archive);
+
+  if(R_SUCCEEDED(rc))
+  {
+    rc = FSUSER_OpenArchive(&device->archive, device->archive_id, path);
+    if(R_FAILED(rc))
+      device->archive = 0;
+  }
+
+  /* a device left without its archive would fail every call without telling why, and an archive
+   * which couldn't be closed still holds the changes for the next commit to make visible */
+  if(R_FAILED(rc))
+    _archiveUnmountDeviceStruct(device);
+  return rc;
+}
+
+Result
+archiveTransactionCommit(archiveTransaction *txn)
+{
+  archive_txn_file_t *file;
+  Result             rc = 0;
+  u8                 *run = (u8*)malloc(ARCHIVE_TXN_BLOCK_SIZE*ARCHIVE_TXN_RUN_BLOCKS);
+
+  if(run == NULL)
+    rc = MAKERESULT(RL_FATAL, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+  for(file = txn->files; R_SUCCEEDED(rc) && file != NULL; file = file->next)
+    rc = archive_txn_flush_file(txn->device, file, run);
+
+  /* a single commit makes all the writes visible at once */
+  if(R_SUCCEEDED(rc))
+    rc = FSUSER_ControlArchive(txn->device->archive, ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
+
+  /* don't leave a partially written batch for the next commit to make visible */
+  if(R_FAILED(rc))
+  {
+    Result discard_rc;
+
+    for(file = txn->files; file != NULL; file = file->next)
+    {
+      if(file->fd)
+      {
+        FSFILE_Close(file->fd);
+        file->fd = 0;
+      }
+    }
+
+    discard_rc = archive_txn_discard(txn->device);
+    if(R_FAILED(discard_rc))
+      rc = discard_rc;
+  }
+  txn->device->space.valid = false;
+
+  free(run);
+  archive_txn_free(txn);
+  return rc;
+}
+
+void
+archiveTransactionAbort(archiveTransaction *txn)
+{
+  archive_txn_free(txn);
+}
+
 /*! Error map */
 typedef struct
 {
@@ -736,8 +736,8 @@ static void newRow() {
 		int i,j;
 
 		for (i=0; i<currentConsole->windowWidth*8; i++) {
-			u32 *from = (u32*)((int)src & ~3);
-			u32 *to = (u32*)((int)dst & ~3);
+			u32 *from = (u32*)((uintptr_t)src & ~3);
+			u32 *to = (u32*)((uintptr_t)dst & ~3);
 			for (j=0;j<(((currentConsole->windowHeight-1)*8)/2);j++) *(to--) = *(from--);
 			dst += 240;
 			src += 240;
@@ -0,0 +1,565 @@
+#include <string.h>
+#include <3ds/types.h>
+#include <3ds/gpu/registers.h>
+#include <3ds/gpu/cmddecode.h>
+
+// Every named register of registers.h, in the same order (the host tests check that they match)
+#define REGNAME(x) [GPUREG_##x] = #x
+
+static const char* const gpuRegNames[GPUREG_COUNT] =
+{
+	REGNAME(FINALIZE),
+	REGNAME(FACECULLING_CONFIG),
+	REGNAME(VIEWPORT_WIDTH),
+	REGNAME(VIEWPORT_INVW),
+	REGNAME(VIEWPORT_HEIGHT),
+	REGNAME(VIEWPORT_INVH),
+	REGNAME(FRAGOP_CLIP),
+	REGNAME(FRAGOP_CLIP_DATA0),
+	REGNAME(FRAGOP_CLIP_DATA1),
+	REGNAME(FRAGOP_CLIP_DATA2),
+	REGNAME(FRAGOP_CLIP_DATA3),
+	REGNAME(DEPTHMAP_SCALE),
+	REGNAME(DEPTHMAP_OFFSET),
+	REGNAME(SH_OUTMAP_TOTAL),
+	REGNAME(SH_OUTMAP_O0),
+	REGNAME(SH_OUTMAP_O1),
+	REGNAME(SH_OUTMAP_O2),
+	REGNAME(SH_OUTMAP_O3),
+	REGNAME(SH_OUTMAP_O4),
+	REGNAME(SH_OUTMAP_O5),
+	REGNAME(SH_OUTMAP_O6),
+	REGNAME(EARLYDEPTH_FUNC),
+	REGNAME(EARLYDEPTH_TEST1),
+	REGNAME(EARLYDEPTH_CLEAR),
+	REGNAME(SH_OUTATTR_MODE),
+	REGNAME(SCISSORTEST_MODE),
+	REGNAME(SCISSORTEST_POS),
+	REGNAME(SCISSORTEST_DIM),
+	REGNAME(VIEWPORT_XY),
+	REGNAME(EARLYDEPTH_DATA),
+	REGNAME(DEPTHMAP_ENABLE),
+	REGNAME(RENDERBUF_DIM),
+	REGNAME(SH_OUTATTR_CLOCK),
+	REGNAME(TEXUNIT_CONFIG),
+	REGNAME(TEXUNIT0_BORDER_COLOR),
+	REGNAME(TEXUNIT0_DIM),
+	REGNAME(TEXUNIT0_PARAM),
+	REGNAME(TEXUNIT0_LOD),
+	REGNAME(TEXUNIT0_ADDR1),
+	REGNAME(TEXUNIT0_ADDR2),
+	REGNAME(TEXUNIT0_ADDR3),
+	REGNAME(TEXUNIT0_ADDR4),
+	REGNAME(TEXUNIT0_ADDR5),
+	REGNAME(TEXUNIT0_ADDR6),
+	REGNAME(TEXUNIT0_SHADOW),
+	REGNAME(TEXUNIT0_TYPE),
+	REGNAME(LIGHTING_ENABLE0),
+	REGNAME(TEXUNIT1_BORDER_COLOR),
+	REGNAME(TEXUNIT1_DIM),
+	REGNAME(TEXUNIT1_PARAM),
+	REGNAME(TEXUNIT1_LOD),
+	REGNAME(TEXUNIT1_ADDR),
+	REGNAME(TEXUNIT1_TYPE),
+	REGNAME(TEXUNIT2_BORDER_COLOR),
+	REGNAME(TEXUNIT2_DIM),
+	REGNAME(TEXUNIT2_PARAM),
+	REGNAME(TEXUNIT2_LOD),
+	REGNAME(TEXUNIT2_ADDR),
+	REGNAME(TEXUNIT2_TYPE),
+	REGNAME(TEXUNIT3_PROCTEX0),
+	REGNAME(TEXUNIT3_PROCTEX1),
+	REGNAME(TEXUNIT3_PROCTEX2),
+	REGNAME(TEXUNIT3_PROCTEX3),
+	REGNAME(TEXUNIT3_PROCTEX4),
+	REGNAME(TEXUNIT3_PROCTEX5),
+	REGNAME(PROCTEX_LUT),
+	REGNAME(PROCTEX_LUT_DATA0),
+	REGNAME(PROCTEX_LUT_DATA1),
+	REGNAME(PROCTEX_LUT_DATA2),
+	REGNAME(PROCTEX_LUT_DATA3),
+	REGNAME(PROCTEX_LUT_DATA4),
+	REGNAME(PROCTEX_LUT_DATA5),
+	REGNAME(PROCTEX_LUT_DATA6),
+	REGNAME(PROCTEX_LUT_DATA7),
+	REGNAME(TEXENV0_SOURCE),
+	REGNAME(TEXENV0_OPERAND),
+	REGNAME(TEXENV0_COMBINER),
+	REGNAME(TEXENV0_COLOR),
+	REGNAME(TEXENV0_SCALE),
+	REGNAME(TEXENV1_SOURCE),
+	REGNAME(TEXENV1_OPERAND),
+	REGNAME(TEXENV1_COMBINER),
+	REGNAME(TEXENV1_COLOR),
+	REGNAME(TEXENV1_SCALE),
+	REGNAME(TEXENV2_SOURCE),
+	REGNAME(TEXENV2_OPERAND),
+	REGNAME(TEXENV2_COMBINER),
+	REGNAME(TEXENV2_COLOR),
+	REGNAME(TEXENV2_SCALE),
+	REGNAME(TEXENV3_SOURCE),
+	REGNAME(TEXENV3_OPERAND),
+	REGNAME(TEXENV3_COMBINER),
+	REGNAME(TEXENV3_COLOR),
+	REGNAME(TEXENV3_SCALE),
+	REGNAME(TEXENV_UPDATE_BUFFER),
+	REGNAME(FOG_COLOR),
+	REGNAME(GAS_ATTENUATION),
+	REGNAME(GAS_ACCMAX),
+	REGNAME(FOG_LUT_INDEX),
+	REGNAME(FOG_LUT_DATA0),
+	REGNAME(FOG_LUT_DATA1),
+	REGNAME(FOG_LUT_DATA2),
+	REGNAME(FOG_LUT_DATA3),
+	REGNAME(FOG_LUT_DATA4),
+	REGNAME(FOG_LUT_DATA5),
+	REGNAME(FOG_LUT_DATA6),
+	REGNAME(FOG_LUT_DATA7),
+	REGNAME(TEXENV4_SOURCE),
+	REGNAME(TEXENV4_OPERAND),
+	REGNAME(TEXENV4_COMBINER),
+	REGNAME(TEXENV4_COLOR),
+	REGNAME(TEXENV4_SCALE),
+	REGNAME(TEXENV5_SOURCE),
+	REGNAME(TEXENV5_OPERAND),
+	REGNAME(TEXENV5_COMBINER),
+	REGNAME(TEXENV5_COLOR),
+	REGNAME(TEXENV5_SCALE),
+	REGNAME(TEXENV_BUFFER_COLOR),
+	REGNAME(COLOR_OPERATION),
+	REGNAME(BLEND_FUNC),
+	REGNAME(LOGIC_OP),
+	REGNAME(BLEND_COLOR),
+	REGNAME(FRAGOP_ALPHA_TEST),
+	REGNAME(STENCIL_TEST),
+	REGNAME(STENCIL_OP),
+	REGNAME(DEPTH_COLOR_MASK),
+	REGNAME(FRAMEBUFFER_INVALIDATE),
+	REGNAME(FRAMEBUFFER_FLUSH),
+	REGNAME(COLORBUFFER_READ),
+	REGNAME(COLORBUFFER_WRITE),
+	REGNAME(DEPTHBUFFER_READ),
+	REGNAME(DEPTHBUFFER_WRITE),
+	REGNAME(DEPTHBUFFER_FORMAT),
+	REGNAME(COLORBUFFER_FORMAT),
+	REGNAME(EARLYDEPTH_TEST2),
+	REGNAME(FRAMEBUFFER_BLOCK32),
+	REGNAME(DEPTHBUFFER_LOC),
+	REGNAME(COLORBUFFER_LOC),
+	REGNAME(FRAMEBUFFER_DIM),
+	REGNAME(GAS_LIGHT_XY),
+	REGNAME(GAS_LIGHT_Z),
+	REGNAME(GAS_LIGHT_Z_COLOR),
+	REGNAME(GAS_LUT_INDEX),
+	REGNAME(GAS_LUT_DATA),
+	REGNAME(GAS_ACCMAX_FEEDBACK),
+	REGNAME(GAS_DELTAZ_DEPTH),
+	REGNAME(FRAGOP_SHADOW),
+	REGNAME(LIGHT0_SPECULAR0),
+	REGNAME(LIGHT0_SPECULAR1),
+	REGNAME(LIGHT0_DIFFUSE),
+	REGNAME(LIGHT0_AMBIENT),
+	REGNAME(LIGHT0_XY),
+	REGNAME(LIGHT0_Z),
+	REGNAME(LIGHT0_SPOTDIR_XY),
+	REGNAME(LIGHT0_SPOTDIR_Z),
+	REGNAME(LIGHT0_CONFIG),
+	REGNAME(LIGHT0_ATTENUATION_BIAS),
+	REGNAME(LIGHT0_ATTENUATION_SCALE),
+	REGNAME(LIGHT1_SPECULAR0),
+	REGNAME(LIGHT1_SPECULAR1),
+	REGNAME(LIGHT1_DIFFUSE),
+	REGNAME(LIGHT1_AMBIENT),
+	REGNAME(LIGHT1_XY),
+	REGNAME(LIGHT1_Z),
+	REGNAME(LIGHT1_SPOTDIR_XY),
+	REGNAME(LIGHT1_SPOTDIR_Z),
+	REGNAME(LIGHT1_CONFIG),
+	REGNAME(LIGHT1_ATTENUATION_BIAS),
+	REGNAME(LIGHT1_ATTENUATION_SCALE),
+	REGNAME(LIGHT2_SPECULAR0),
+	REGNAME(LIGHT2_SPECULAR1),
+	REGNAME(LIGHT2_DIFFUSE),
+	REGNAME(LIGHT2_AMBIENT),
+	REGNAME(LIGHT2_XY),
+	REGNAME(LIGHT2_Z),
+	REGNAME(LIGHT2_SPOTDIR_XY),
+	REGNAME(LIGHT2_SPOTDIR_Z),
+	REGNAME(LIGHT2_CONFIG),
+	REGNAME(LIGHT2_ATTENUATION_BIAS),
+	REGNAME(LIGHT2_ATTENUATION_SCALE),
+	REGNAME(LIGHT3_SPECULAR0),
+	REGNAME(LIGHT3_SPECULAR1),
+	REGNAME(LIGHT3_DIFFUSE),
+	REGNAME(LIGHT3_AMBIENT),
+	REGNAME(LIGHT3_XY),
+	REGNAME(LIGHT3_Z),
+	REGNAME(LIGHT3_SPOTDIR_XY),
+	REGNAME(LIGHT3_SPOTDIR_Z),
+	REGNAME(LIGHT3_CONFIG),
+	REGNAME(LIGHT3_ATTENUATION_BIAS),
+	REGNAME(LIGHT3_ATTENUATION_SCALE),
+	REGNAME(LIGHT4_SPECULAR0),
+	REGNAME(LIGHT4_SPECULAR1),
+	REGNAME(LIGHT4_DIFFUSE),
+	REGNAME(LIGHT4_AMBIENT),
+	REGNAME(LIGHT4_XY),
+	REGNAME(LIGHT4_Z),
+	REGNAME(LIGHT4_SPOTDIR_XY),
+	REGNAME(LIGHT4_SPOTDIR_Z),
+	REGNAME(LIGHT4_CONFIG),
+	REGNAME(LIGHT4_ATTENUATION_BIAS),
+	REGNAME(LIGHT4_ATTENUATION_SCALE),
+	REGNAME(LIGHT5_SPECULAR0),
+	REGNAME(LIGHT5_SPECULAR1),
+	REGNAME(LIGHT5_DIFFUSE),
+	REGNAME(LIGHT5_AMBIENT),
+	REGNAME(LIGHT5_XY),
+	REGNAME(LIGHT5_Z),
+	REGNAME(LIGHT5_SPOTDIR_XY),
+	REGNAME(LIGHT5_SPOTDIR_Z),
+	REGNAME(LIGHT5_CONFIG),
+	REGNAME(LIGHT5_ATTENUATION_BIAS),
+	REGNAME(LIGHT5_ATTENUATION_SCALE),
+	REGNAME(LIGHT6_SPECULAR0),
+	REGNAME(LIGHT6_SPECULAR1),
+	REGNAME(LIGHT6_DIFFUSE),
+	REGNAME(LIGHT6_AMBIENT),
+	REGNAME(LIGHT6_XY),
+	REGNAME(LIGHT6_Z),
+	REGNAME(LIGHT6_SPOTDIR_XY),
+	REGNAME(LIGHT6_SPOTDIR_Z),
+	REGNAME(LIGHT6_CONFIG),
+	REGNAME(LIGHT6_ATTENUATION_BIAS),
+	REGNAME(LIGHT6_ATTENUATION_SCALE),
+	REGNAME(LIGHT7_SPECULAR0),
+	REGNAME(LIGHT7_SPECULAR1),
+	REGNAME(LIGHT7_DIFFUSE),
+	REGNAME(LIGHT7_AMBIENT),
+	REGNAME(LIGHT7_XY),
+	REGNAME(LIGHT7_Z),
+	REGNAME(LIGHT7_SPOTDIR_XY),
+	REGNAME(LIGHT7_SPOTDIR_Z),
+	REGNAME(LIGHT7_CONFIG),
+	REGNAME(LIGHT7_ATTENUATION_BIAS),
+	REGNAME(LIGHT7_ATTENUATION_SCALE),
+	REGNAME(LIGHTING_AMBIENT),
+	REGNAME(LIGHTING_NUM_LIGHTS),
+	REGNAME(LIGHTING_CONFIG0),
+	REGNAME(LIGHTING_CONFIG1),
+	REGNAME(LIGHTING_LUT_INDEX),
+	REGNAME(LIGHTING_ENABLE1),
+	REGNAME(LIGHTING_LUT_DATA0),
+	REGNAME(LIGHTING_LUT_DATA1),
+	REGNAME(LIGHTING_LUT_DATA2),
+	REGNAME(LIGHTING_LUT_DATA3),
+	REGNAME(LIGHTING_LUT_DATA4),
+	REGNAME(LIGHTING_LUT_DATA5),
+	REGNAME(LIGHTING_LUT_DATA6),
+	REGNAME(LIGHTING_LUT_DATA7),
+	REGNAME(LIGHTING_LUTINPUT_ABS),
+	REGNAME(LIGHTING_LUTINPUT_SELECT),
+	REGNAME(LIGHTING_LUTINPUT_SCALE),
+	REGNAME(LIGHTING_LIGHT_PERMUTATION),
+	REGNAME(ATTRIBBUFFERS_LOC),
+	REGNAME(ATTRIBBUFFERS_FORMAT_LOW),
+	REGNAME(ATTRIBBUFFERS_FORMAT_HIGH),
+	REGNAME(ATTRIBBUFFER0_OFFSET),
+	REGNAME(ATTRIBBUFFER0_CONFIG1),
+	REGNAME(ATTRIBBUFFER0_CONFIG2),
+	REGNAME(ATTRIBBUFFER1_OFFSET),
+	REGNAME(ATTRIBBUFFER1_CONFIG1),
+	REGNAME(ATTRIBBUFFER1_CONFIG2),
+	REGNAME(ATTRIBBUFFER2_OFFSET),
+	REGNAME(ATTRIBBUFFER2_CONFIG1),
+	REGNAME(ATTRIBBUFFER2_CONFIG2),
+	REGNAME(ATTRIBBUFFER3_OFFSET),
+	REGNAME(ATTRIBBUFFER3_CONFIG1),
+	REGNAME(ATTRIBBUFFER3_CONFIG2),
+	REGNAME(ATTRIBBUFFER4_OFFSET),
+	REGNAME(ATTRIBBUFFER4_CONFIG1),
+	REGNAME(ATTRIBBUFFER4_CONFIG2),
+	REGNAME(ATTRIBBUFFER5_OFFSET),
+	REGNAME(ATTRIBBUFFER5_CONFIG1),
+	REGNAME(ATTRIBBUFFER5_CONFIG2),
+	REGNAME(ATTRIBBUFFER6_OFFSET),
+	REGNAME(ATTRIBBUFFER6_CONFIG1),
+	REGNAME(ATTRIBBUFFER6_CONFIG2),
+	REGNAME(ATTRIBBUFFER7_OFFSET),
+	REGNAME(ATTRIBBUFFER7_CONFIG1),
+	REGNAME(ATTRIBBUFFER7_CONFIG2),
+	REGNAME(ATTRIBBUFFER8_OFFSET),
+	REGNAME(ATTRIBBUFFER8_CONFIG1),
+	REGNAME(ATTRIBBUFFER8_CONFIG2),
+	REGNAME(ATTRIBBUFFER9_OFFSET),
+	REGNAME(ATTRIBBUFFER9_CONFIG1),
+	REGNAME(ATTRIBBUFFER9_CONFIG2),
+	REGNAME(ATTRIBBUFFERA_OFFSET),
+	REGNAME(ATTRIBBUFFERA_CONFIG1),
+	REGNAME(ATTRIBBUFFERA_CONFIG2),
+	REGNAME(ATTRIBBUFFERB_OFFSET),
+	REGNAME(ATTRIBBUFFERB_CONFIG1),
+	REGNAME(ATTRIBBUFFERB_CONFIG2),
+	REGNAME(INDEXBUFFER_CONFIG),
+	REGNAME(NUMVERTICES),
+	REGNAME(GEOSTAGE_CONFIG),
+	REGNAME(VERTEX_OFFSET),
+	REGNAME(POST_VERTEX_CACHE_NUM),
+	REGNAME(DRAWARRAYS),
+	REGNAME(DRAWELEMENTS),
+	REGNAME(VTX_FUNC),
+	REGNAME(FIXEDATTRIB_INDEX),
+	REGNAME(FIXEDATTRIB_DATA0),
+	REGNAME(FIXEDATTRIB_DATA1),
+	REGNAME(FIXEDATTRIB_DATA2),
+	REGNAME(CMDBUF_SIZE0),
+	REGNAME(CMDBUF_SIZE1),
+	REGNAME(CMDBUF_ADDR0),
+	REGNAME(CMDBUF_ADDR1),
+	REGNAME(CMDBUF_JUMP0),
+	REGNAME(CMDBUF_JUMP1),
+	REGNAME(VSH_NUM_ATTR),
+	REGNAME(VSH_COM_MODE),
+	REGNAME(START_DRAW_FUNC0),
+	REGNAME(VSH_OUTMAP_TOTAL1),
+	REGNAME(VSH_OUTMAP_TOTAL2),
+	REGNAME(GSH_MISC0),
+	REGNAME(GEOSTAGE_CONFIG2),
+	REGNAME(GSH_MISC1),
+	REGNAME(PRIMITIVE_CONFIG),
+	REGNAME(RESTART_PRIMITIVE),
+	REGNAME(GSH_BOOLUNIFORM),
+	REGNAME(GSH_INTUNIFORM_I0),
+	REGNAME(GSH_INTUNIFORM_I1),
+	REGNAME(GSH_INTUNIFORM_I2),
+	REGNAME(GSH_INTUNIFORM_I3),
+	REGNAME(GSH_INPUTBUFFER_CONFIG),
+	REGNAME(GSH_ENTRYPOINT),
+	REGNAME(GSH_ATTRIBUTES_PERMUTATION_LOW),
+	REGNAME(GSH_ATTRIBUTES_PERMUTATION_HIGH),
+	REGNAME(GSH_OUTMAP_MASK),
+	REGNAME(GSH_CODETRANSFER_END),
+	REGNAME(GSH_FLOATUNIFORM_CONFIG),
+	REGNAME(GSH_FLOATUNIFORM_DATA),
+	REGNAME(GSH_CODETRANSFER_CONFIG),
+	REGNAME(GSH_CODETRANSFER_DATA),
+	REGNAME(GSH_OPDESCS_CONFIG),
+	REGNAME(GSH_OPDESCS_DATA),
+	REGNAME(VSH_BOOLUNIFORM),
+	REGNAME(VSH_INTUNIFORM_I0),
+	REGNAME(VSH_INTUNIFORM_I1),
+	REGNAME(VSH_INTUNIFORM_I2),
+	REGNAME(VSH_INTUNIFORM_I3),
+	REGNAME(VSH_INPUTBUFFER_CONFIG),
+	REGNAME(VSH_ENTRYPOINT),
+	REGNAME(VSH_ATTRIBUTES_PERMUTATION_LOW),
+	REGNAME(VSH_ATTRIBUTES_PERMUTATION_HIGH),
+	REGNAME(VSH_OUTMAP_MASK),
+	REGNAME(VSH_CODETRANSFER_END),
+	REGNAME(VSH_FLOATUNIFORM_CONFIG),
+	REGNAME(VSH_FLOATUNIFORM_DATA),
+	REGNAME(VSH_CODETRANSFER_CONFIG),
+	REGNAME(VSH_CODETRANSFER_DATA),
+	REGNAME(VSH_OPDESCS_CONFIG),
+	REGNAME(VSH_OPDESCS_DATA),
+};
+
+#undef REGNAME
+
+static const char* const gpuIssueNames[GPUCMD_ISSUE_MAX] =
+{
+	[GPUCMD_ISSUE_TRUNCATED]      = "truncated command",
+	[GPUCMD_ISSUE_RESERVED_BITS]  = "reserved header bits set",
+	[GPUCMD_ISSUE_REG_OVERFLOW]   = "incremental write past last register",
+	[GPUCMD_ISSUE_ZERO_MASK]      = "write with empty mask",
+	[GPUCMD_ISSUE_REDUNDANT]      = "redundant write",
+	[GPUCMD_ISSUE_OVERWRITTEN]    = "value overwritten before use",
+	[GPUCMD_ISSUE_UNALIGNED_SIZE] = "buffer size not 16-byte aligned",
+};
+
+enum
+{
+	REG_STATE   = 0, // Plain state register
+	REG_PORT    = 1, // Data port or index register, writes are never redundant
+	REG_TRIGGER = 2, // Trigger register, consumes the current state
+};
+
+static int gpuCmdRegType(u16 reg)
+{
+	switch (reg)
+	{
+		case GPUREG_FINALIZE:
+		case GPUREG_EARLYDEPTH_CLEAR:
+		case GPUREG_FRAMEBUFFER_INVALIDATE:
+		case GPUREG_FRAMEBUFFER_FLUSH:
+		case GPUREG_DRAWARRAYS:
+		case GPUREG_DRAWELEMENTS:
+		case GPUREG_FIXEDATTRIB_DATA0:
+		case GPUREG_FIXEDATTRIB_DATA1:
+		case GPUREG_FIXEDATTRIB_DATA2:
+		case GPUREG_CMDBUF_JUMP0:
+		case GPUREG_CMDBUF_JUMP1:
+		case GPUREG_GSH_CODETRANSFER_END:
+		case GPUREG_VSH_CODETRANSFER_END:
+			return REG_TRIGGER;
+
+		case GPUREG_PROCTEX_LUT:
+		case GPUREG_FOG_LUT_INDEX:
+		case GPUREG_GAS_LUT_INDEX:
+		case GPUREG_GAS_LUT_DATA:
+		case GPUREG_LIGHTING_LUT_INDEX:
+		case GPUREG_FIXEDATTRIB_INDEX:
+		case GPUREG_VTX_FUNC:
+		case GPUREG_START_DRAW_FUNC0:
+		case GPUREG_RESTART_PRIMITIVE:
+		case GPUREG_GSH_FLOATUNIFORM_CONFIG:
+		case GPUREG_GSH_CODETRANSFER_CONFIG:
+		case GPUREG_GSH_OPDESCS_CONFIG:
+		case GPUREG_VSH_FLOATUNIFORM_CONFIG:
+		case GPUREG_VSH_CODETRANSFER_CONFIG:
+		case GPUREG_VSH_OPDESCS_CONFIG:
+			return REG_PORT;
+	}
+
+	// LUT and shader data ports (each of them is mirrored over 8 registers)
+	if ((reg >= GPUREG_PROCTEX_LUT_DATA0 && reg <= GPUREG_PROCTEX_LUT_DATA7) ||
+		(reg >= GPUREG_FOG_LUT_DATA0 && reg <= GPUREG_FOG_LUT_DATA7) ||
+		(reg >= GPUREG_LIGHTING_LUT_DATA0 && reg <= GPUREG_LIGHTING_LUT_DATA7) ||
+		(reg >= GPUREG_GSH_FLOATUNIFORM_DATA && reg < GPUREG_GSH_FLOATUNIFORM_DATA+8) ||
+		(reg >= GPUREG_GSH_CODETRANSFER_DATA && reg < GPUREG_GSH_CODETRANSFER_DATA+8) ||
+		(reg >= GPUREG_GSH_OPDESCS_DATA && reg < GPUREG_GSH_OPDESCS_DATA+8) ||
+		(reg >= GPUREG_VSH_FLOATUNIFORM_DATA && reg < GPUREG_VSH_FLOATUNIFORM_DATA+8) ||
+		(reg >= GPUREG_VSH_CODETRANSFER_DATA && reg < GPUREG_VSH_CODETRANSFER_DATA+8) ||
+		(reg >= GPUREG_VSH_OPDESCS_DATA && reg < GPUREG_VSH_OPDESCS_DATA+8))
+		return REG_PORT;
+
+	return REG_STATE;
+}
+
+static inline bool testBit(const u32* bitmap, u16 bit)
+{
+	return (bitmap[bit >> 5] >> (bit & 31)) & 1;
+}
+
+static inline void setBit(u32* bitmap, u16 bit)
+{
+	bitmap[bit >> 5] |= 1U << (bit & 31);
+}
+
+static void gpuCmdReport(gpuCmdDecoder_s* dec, GPUCMD_ISSUE type, u32 offset, u16 reg, u32 value)
+{
+	dec->numIssues[type]++;
+	if (dec->callback)
+	{
+		gpuCmdIssue_s issue = { type, offset, reg, value };
+		dec->callback(&issue, dec->user);
+	}
+}
+
+static void gpuCmdWrite(gpuCmdDecoder_s* dec, u32 offset, u16 reg, u32 mask, u32 value)
+{
+	dec->numWrites++;
+	dec->writeCounts[reg]++;
+
+	if (!mask)
+	{
+		gpuCmdReport(dec, GPUCMD_ISSUE_ZERO_MASK, offset, reg, value);
+		return;
+	}
+
+	// Expand the byte mask into a bit mask
+	u32 bitmask = 0;
+	for (int i = 0; i < 4; i ++)
+		if (mask & BIT(i))
+			bitmask |= 0xFFU << (i*8);
+
+	u32 newValue = (dec->values[reg] &~ bitmask) | (value & bitmask);
+	int type = gpuCmdRegType(reg);
+	if (type != REG_STATE)
+	{
+		dec->values[reg] = newValue;
+		if (type == REG_TRIGGER)
+			memset(dec->pending, 0, sizeof(dec->pending));
+		return;
+	}
+
+	if (testBit(dec->known, reg) && newValue == dec->values[reg])
+		gpuCmdReport(dec, GPUCMD_ISSUE_REDUNDANT, offset, reg, value);
+	else if (mask == 0xF && testBit(dec->pending, reg))
+		gpuCmdReport(dec, GPUCMD_ISSUE_OVERWRITTEN, offset, reg, value);
+
+	dec->values[reg] = newValue;
+	if (mask == 0xF)
+		setBit(dec->known, reg);
+	setBit(dec->pending, reg);
+}
+
+void gpuCmdDecoderInit(gpuCmdDecoder_s* dec)
+{
+	memset(dec, 0, sizeof(*dec));
+}
+
+bool gpuCmdDecode(gpuCmdDecoder_s* dec, const u32* buf, u32 size)
+{
+	bool ok = true;
+	if (size & 3)
+		gpuCmdReport(dec, GPUCMD_ISSUE_UNALIGNED_SIZE, size, 0, 0);
+
+	u32 offset = 0;
+	while (offset < size)
+	{
+		if (offset + 2 > size)
+		{
+			gpuCmdReport(dec, GPUCMD_ISSUE_TRUNCATED, offset, 0, buf[offset]);
+			return false;
+		}
+
+		u32 header = buf[offset+1];
+		u32 numParams = ((header >> 20) & 0xFF) + 1;
+		u32 mask = (header >> 16) & 0xF;
+		u16 reg = header & 0x3FF;
+		bool incremental = (header >> 31) != 0;
+
+		// First parameter, header, other parameters, then padding to 8 bytes
+		u32 cmdSize = numParams + 1 + ((numParams - 1) & 1);
+		if (cmdSize > size - offset)
+		{
+			gpuCmdReport(dec, GPUCMD_ISSUE_TRUNCATED, offset, reg, header);
+			return false;
+		}
+
+		dec->numCommands++;
+		if (header & 0x7000FC00)
+		{
+			gpuCmdReport(dec, GPUCMD_ISSUE_RESERVED_BITS, offset, reg, header);
+			ok = false;
+		}
+
+		for (u32 i = 0; i < numParams; i ++)
+		{
+			u32 curReg = incremental ? reg + i : reg;
+			u32 value = i ? buf[offset + 1 + i] : buf[offset];
+			if (curReg >= GPUREG_COUNT)
+			{
+				gpuCmdReport(dec, GPUCMD_ISSUE_REG_OVERFLOW, offset, reg, value);
+				ok = false;
+				break;
+			}
+			gpuCmdWrite(dec, offset, curReg, mask, value);
+		}
+
+		offset += cmdSize;
+	}
+
+	return ok;
+}
+
+const char* gpuCmdGetRegName(u16 reg)
+{
+	return reg < GPUREG_COUNT ? gpuRegNames[reg] : NULL;
+}
+
+const char* gpuCmdGetIssueName(GPUCMD_ISSUE type)
+{
+	return (unsigned)type < GPUCMD_ISSUE_MAX ? gpuIssueNames[type] : "unknown issue";
+}
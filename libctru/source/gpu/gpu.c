@@ -79,35 +79,43 @@ static inline u32 floatrawbits(float f)
 	return s.i;
 }
 
-// f16 has:
-//  - 1 sign bit
-//  - 5 exponent bits
-//  - 10 mantissa bits
-u32 f32tof16(float f)
+// Converts the raw bits of a 32-bit float to a smaller float format with the given
+// amount of exponent and mantissa bits. The mantissa is truncated, underflows are
+// flushed to zero and overflows (including infinities and NaNs) saturate to infinity.
+static inline u32 f32tofmt(u32 i, unsigned expBits, unsigned mantBits)
 {
-	u32 i = floatrawbits(f);
-
 	u32 mantissa = (i << 9) >>  9;
 	s32 exponent = (i << 1) >> 24;
 	u32 sign     = (i << 0) >> 31;
+	s32 expMax   = (1 << expBits) - 1;
 
 	// Truncate mantissa
-	mantissa >>= 13;
+	mantissa >>= 23 - mantBits;
 
 	// Re-bias exponent
-	exponent = exponent - 127 + 15;
+	exponent = exponent - 127 + (expMax >> 1);
+	sign <<= expBits + mantBits;
 	if (exponent < 0)
 	{
 		// Underflow: flush to zero
-		return sign << 15;
+		return sign;
 	}
-	else if (exponent > 0x1F)
+	else if (exponent > expMax)
 	{
 		// Overflow: saturate to infinity
-		return sign << 15 | 0x1F << 10;
+		return sign | expMax << mantBits;
 	}
 
-	return sign << 15 | exponent << 10 | mantissa;
+	return sign | exponent << mantBits | mantissa;
+}
+
+// f16 has:
+//  - 1 sign bit
+//  - 5 exponent bits
+//  - 10 mantissa bits
+u32 f32tof16(float f)
+{
+	return f32tofmt(floatrawbits(f), 5, 10);
 }
 
 // f20 has:
@@ -116,29 +124,7 @@ u32 f32tof16(float f)
 //  - 12 mantissa bits
 u32 f32tof20(float f)
 {
-	u32 i = floatrawbits(f);
-
-	u32 mantissa = (i << 9) >>  9;
-	s32 exponent = (i << 1) >> 24;
-	u32 sign     = (i << 0) >> 31;
-
-	// Truncate mantissa
-	mantissa >>= 11;
-
-	// Re-bias exponent
-	exponent = exponent - 127 + 63;
-	if (exponent < 0)
-	{
-		// Underflow: flush to zero
-		return sign << 19;
-	}
-	else if (exponent > 0x7F)
-	{
-		// Overflow: saturate to infinity
-		return sign << 19 | 0x7F << 12;
-	}
-
-	return sign << 19 | exponent << 12 | mantissa;
+	return f32tofmt(floatrawbits(f), 7, 12);
 }
 
 // f24 has:
@@ -147,29 +133,7 @@ u32 f32tof20(float f)
 //  - 16 mantissa bits
 u32 f32tof24(float f)
 {
-	u32 i = floatrawbits(f);
-
-	u32 mantissa = (i << 9) >>  9;
-	s32 exponent = (i << 1) >> 24;
-	u32 sign     = (i << 0) >> 31;
-
-	// Truncate mantissa
-	mantissa >>= 7;
-
-	// Re-bias exponent
-	exponent = exponent - 127 + 63;
-	if (exponent < 0)
-	{
-		// Underflow: flush to zero
-		return sign << 23;
-	}
-	else if (exponent > 0x7F)
-	{
-		// Overflow: saturate to infinity
-		return sign << 23 | 0x7F << 16;
-	}
-
-	return sign << 23 | exponent << 16 | mantissa;
+	return f32tofmt(floatrawbits(f), 7, 16);
 }
 
 // f31 has:
@@ -178,24 +142,50 @@ u32 f32tof24(float f)
 //  - 23 mantissa bits
 u32 f32tof31(float f)
 {
-	u32 i = floatrawbits(f);
-
-	u32 mantissa = (i << 9) >>  9;
-	s32 exponent = (i << 1) >> 24;
-	u32 sign     = (i << 0) >> 31;
+	return f32tofmt(floatrawbits(f), 7, 23);
+}
 
-	// Re-bias exponent
-	exponent = exponent - 127 + 63;
-	if (exponent < 0)
+void f32tof24Array(u32* out, const float* in, u32 count)
+{
+	for (; count >= 4; count -= 4, in += 4, out += 4)
 	{
-		// Underflow: flush to zero
-		return sign << 30;
+		out[0] = f32tofmt(floatrawbits(in[0]), 7, 16);
+		out[1] = f32tofmt(floatrawbits(in[1]), 7, 16);
+		out[2] = f32tofmt(floatrawbits(in[2]), 7, 16);
+		out[3] = f32tofmt(floatrawbits(in[3]), 7, 16);
 	}
-	else if (exponent > 0x7F)
+	while (count--)
+		*out++ = f32tofmt(floatrawbits(*in++), 7, 16);
+}
+
+void f32tof24Vec4Pack(u32* out, const float* in, u32 numVec4)
+{
+	for (; numVec4; numVec4 --, in += 4, out += 3)
 	{
-		// Overflow: saturate to infinity
-		return sign << 30 | 0x7F << 23;
+		u32 x = f32tofmt(floatrawbits(in[0]), 7, 16);
+		u32 y = f32tofmt(floatrawbits(in[1]), 7, 16);
+		u32 z = f32tofmt(floatrawbits(in[2]), 7, 16);
+		u32 w = f32tofmt(floatrawbits(in[3]), 7, 16);
+
+		// The PICA expects the components in reverse order, packed into three words
+		out[0] = w << 8  | z >> 16;
+		out[1] = z << 16 | y >> 8;
+		out[2] = y << 24 | x;
 	}
+}
 
-	return sign << 30 | exponent << 23 | mantissa;
+void GPUCMD_AddFloatUniforms(GPU_SHADER_TYPE type, u32 startreg, const float* data, u32 numVec4)
+{
+	u32 regOffset = type == GPU_GEOMETRY_SHADER ? (-0x30) : 0;
+	u32 buf[0x60];
+
+	GPUCMD_AddWrite(GPUREG_VSH_FLOATUNIFORM_CONFIG+regOffset, startreg & 0xFF);
+	while (numVec4)
+	{
+		u32 num = numVec4 > 0x20 ? 0x20 : numVec4;
+		f32tof24Vec4Pack(buf, data, num);
+		GPUCMD_AddWrites(GPUREG_VSH_FLOATUNIFORM_DATA+regOffset, buf, num*3);
+		data += num*4;
+		numVec4 -= num;
+	}
 }
@@ -21,6 +21,11 @@ void GX_BindQueue(gxCmdQueue_s* queue)
 	boundQueue = queue;
 }
 
+gxCmdQueue_s* GX_GetBoundQueue(void)
+{
+	return boundQueue;
+}
+
 static Result submitGxCommand(u32 gxCommand[0x8])
 {
 	if (boundQueue)
@@ -74,20 +74,23 @@ void gxCmdQueueAdd(gxCmdQueue_s* queue, const gxCmdEntry_s* entry)
 	LightLock_Unlock(&queueLock);
 }
 
-void gxCmdQueueRun(gxCmdQueue_s* queue)
+bool gxCmdQueueRun(gxCmdQueue_s* queue)
 {
+	LightLock_Lock(&queueLock);
 	if (isRunning)
-		return;
+	{
+		LightLock_Unlock(&queueLock);
+		return queue == curQueue;
+	}
 	curQueue = queue;
 	isActive = true;
 	if (queue->lastEntry < queue->numEntries)
 	{
 		isRunning = true;
-		LightLock_Lock(&queueLock);
 		gxCmdQueueDoCommands();
-		LightLock_Unlock(&queueLock);
-	} else
-		isRunning = false;
+	}
+	LightLock_Unlock(&queueLock);
+	return true;
 }
 
 void gxCmdQueueStop(gxCmdQueue_s* queue)
@@ -95,6 +98,12 @@ void gxCmdQueueStop(gxCmdQueue_s* queue)
 	if (!curQueue)
 		return;
 	LightLock_Lock(&queueLock);
+	// Another queue may have been run since (e.g. a texture upload batch), it isn't this one's to stop
+	if (queue != curQueue)
+	{
+		LightLock_Unlock(&queueLock);
+		return;
+	}
 	if (!isRunning)
 	{
 		curQueue = NULL;
@@ -104,6 +113,16 @@ void gxCmdQueueStop(gxCmdQueue_s* queue)
 	LightLock_Unlock(&queueLock);
 }
 
+gxCmdQueue_s* gxCmdQueueGetCurrent(bool* running)
+{
+	LightLock_Lock(&queueLock);
+	gxCmdQueue_s* queue = isActive ? curQueue : NULL;
+	if (running)
+		*running = isRunning;
+	LightLock_Unlock(&queueLock);
+	return queue;
+}
+
 bool gxCmdQueueWait(gxCmdQueue_s* queue, s64 timeout)
 {
 	u64 deadline = U64_MAX;
@@ -329,22 +329,40 @@ Result shaderProgramConfigure(shaderProgram_s* sp, bool sendVshCode, bool sendGs
 	return 0;
 }
 
+static void shaderInstanceUploadFloat24(const shaderInstance_s* si, GPU_SHADER_TYPE type)
+{
+	int regOffset=(type==GPU_GEOMETRY_SHADER)?(-0x30):(0x0);
+	u32 buf[0x60];
+	int i = 0;
+
+	// The constants are already in f24, runs of consecutive registers are sent with a single write
+	// (the uniform index autoincrements after each vector)
+	while (i < si->numFloat24Uniforms)
+	{
+		u32 id = si->float24Uniforms[i].id;
+		u32 num = 0;
+		while (i < si->numFloat24Uniforms && num < 0x20 && si->float24Uniforms[i].id == id+num)
+			memcpy(&buf[3*num++], si->float24Uniforms[i++].data, 3*sizeof(u32));
+
+		GPUCMD_AddWrite(GPUREG_VSH_FLOATUNIFORM_CONFIG+regOffset, id);
+		GPUCMD_AddWrites(GPUREG_VSH_FLOATUNIFORM_DATA+regOffset, buf, 3*num);
+	}
+}
+
 Result shaderProgramUse(shaderProgram_s* sp)
 {
 	Result rc = shaderProgramConfigure(sp, true, true);
 	if (R_FAILED(rc)) return rc;
 
-	int i;
-
 	// Set up uniforms
 	GPUCMD_AddWrite(GPUREG_VSH_BOOLUNIFORM, 0x7FFF0000|sp->vertexShader->boolUniforms);
 	GPUCMD_AddIncrementalWrites(GPUREG_VSH_INTUNIFORM_I0, sp->vertexShader->intUniforms, 4);
-	for(i=0; i<sp->vertexShader->numFloat24Uniforms; i++) GPUCMD_AddIncrementalWrites(GPUREG_VSH_FLOATUNIFORM_CONFIG, (u32*)&sp->vertexShader->float24Uniforms[i], 4);
+	shaderInstanceUploadFloat24(sp->vertexShader, GPU_VERTEX_SHADER);
 	if (sp->geometryShader)
 	{
 		GPUCMD_AddWrite(GPUREG_GSH_BOOLUNIFORM, 0x7FFF0000|sp->geometryShader->boolUniforms);
 		GPUCMD_AddIncrementalWrites(GPUREG_GSH_INTUNIFORM_I0, sp->geometryShader->intUniforms, 4);
-		for(i=0; i<sp->geometryShader->numFloat24Uniforms; i++) GPUCMD_AddIncrementalWrites(GPUREG_GSH_FLOATUNIFORM_CONFIG, (u32*)&sp->geometryShader->float24Uniforms[i], 4);
+		shaderInstanceUploadFloat24(sp->geometryShader, GPU_GEOMETRY_SHADER);
 	}
 
 	return 0;
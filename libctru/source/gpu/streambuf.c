@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <3ds/types.h>
+#include <3ds/result.h>
+#include <3ds/os.h>
+#include <3ds/synchronization.h>
+#include <3ds/allocator/linear.h>
+#include <3ds/services/gspgpu.h>
+#include <3ds/gpu/gpu.h>
+#include <3ds/gpu/streambuf.h>
+
+bool gpuStreamBufInit(gpuStreamBuf_s* sb, u32 size, u16 maxFences)
+{
+	if (!sb || !size || !maxFences)
+		return false;
+
+	size = (size + 0x7F) &~ 0x7F;
+	sb->fences = (gpuStreamBufFence_s*)calloc(maxFences, sizeof(gpuStreamBufFence_s));
+	if (!sb->fences)
+		return false;
+
+	sb->base = (u8*)linearMemAlign(size, 0x80);
+	if (!sb->base)
+	{
+		free(sb->fences);
+		sb->fences = NULL;
+		return false;
+	}
+
+	for (u16 i = 0; i < maxFences; i ++)
+		LightEvent_Init(&sb->fences[i].fence, RESET_STICKY);
+
+	sb->size       = size;
+	sb->head       = 0;
+	sb->tail       = 0;
+	sb->batch      = 0;
+	sb->flushed    = 0;
+	sb->wrap       = size;
+	sb->maxFences  = maxFences;
+	sb->firstFence = 0;
+	sb->numFences  = 0;
+	return true;
+}
+
+// Retires the oldest pending batch, returns false if there is none (or it is still in use and wait is false)
+static bool gpuStreamBufRetire(gpuStreamBuf_s* sb, bool wait)
+{
+	if (!sb->numFences)
+		return false;
+
+	gpuStreamBufFence_s* f = &sb->fences[sb->firstFence];
+	if (wait)
+		LightEvent_Wait(&f->fence);
+	else if (!LightEvent_TryWait(&f->fence))
+		return false;
+
+	sb->tail = f->end;
+	if (++sb->firstFence == sb->maxFences)
+		sb->firstFence = 0;
+	sb->numFences--;
+	return true;
+}
+
+void gpuStreamBufExit(gpuStreamBuf_s* sb)
+{
+	if (!sb->base)
+		return;
+
+	while (gpuStreamBufRetire(sb, true));
+
+	linearFree(sb->base);
+	free(sb->fences);
+	sb->base = NULL;
+	sb->fences = NULL;
+}
+
+void* gpuStreamBufAlloc(gpuStreamBuf_s* sb, u32 size, u32 alignment)
+{
+	if (size > sb->size)
+		return NULL;
+
+	// Opportunistically retire batches the GPU is already done with
+	while (gpuStreamBufRetire(sb, false));
+
+	u32 start;
+	for (;;)
+	{
+		// Rewind the ring if nothing is in use, maximizing the contiguous free space
+		if (!sb->numFences && sb->head == sb->batch)
+			sb->head = sb->tail = sb->batch = sb->flushed = 0;
+
+		start = (sb->head + alignment - 1) &~ (alignment - 1);
+		if (sb->head >= sb->tail)
+		{
+			// Free space is [head, size) and [0, tail)
+			if (start <= sb->size && size <= sb->size - start)
+				break;
+			if (size < sb->tail)
+			{
+				sb->wrap = sb->head;
+				start = 0;
+				break;
+			}
+		}
+		else
+		{
+			// Free space is [head, tail)
+			if (start < sb->tail && size < sb->tail - start)
+				break;
+		}
+
+		// Not enough space, wait for the oldest batch to be retired
+		if (!gpuStreamBufRetire(sb, true))
+			return NULL;
+	}
+
+	sb->head = start + size;
+	return sb->base + start;
+}
+
+Result gpuStreamBufFlush(gpuStreamBuf_s* sb)
+{
+	Result res = 0;
+	if (sb->head >= sb->flushed)
+	{
+		if (sb->head != sb->flushed)
+			res = GSPGPU_FlushDataCache(sb->base + sb->flushed, sb->head - sb->flushed);
+	} else
+	{
+		// The ring wrapped around since the last flush
+		if (sb->wrap > sb->flushed)
+			res = GSPGPU_FlushDataCache(sb->base + sb->flushed, sb->wrap - sb->flushed);
+		if (R_SUCCEEDED(res) && sb->head)
+			res = GSPGPU_FlushDataCache(sb->base, sb->head);
+	}
+
+	if (R_SUCCEEDED(res))
+		sb->flushed = sb->head;
+	return res;
+}
+
+gpuStreamBufFence_s* gpuStreamBufFence(gpuStreamBuf_s* sb)
+{
+	gpuStreamBufFlush(sb);
+
+	if (sb->numFences == sb->maxFences)
+		gpuStreamBufRetire(sb, true);
+
+	u32 id = sb->firstFence + sb->numFences;
+	if (id >= sb->maxFences)
+		id -= sb->maxFences;
+
+	gpuStreamBufFence_s* f = &sb->fences[id];
+	LightEvent_Clear(&f->fence);
+	f->end = sb->head;
+	sb->numFences++;
+	sb->batch = sb->head;
+	return f;
+}
+
+void gpuStreamBufSignal(void* fence)
+{
+	LightEvent_Signal(&((gpuStreamBufFence_s*)fence)->fence);
+}
+
+void GPUCMD_AddStreamBufLocation(const gpuStreamBuf_s* sb)
+{
+	GPUCMD_AddWrite(GPUREG_ATTRIBBUFFERS_LOC, osConvertVirtToPhys(sb->base) >> 3);
+}
+
+void GPUCMD_AddStreamBufAttribBuffer(const gpuStreamBuf_s* sb, u32 id, const void* data)
+{
+	if (id >= 12)
+		return;
+	GPUCMD_AddWrite(GPUREG_ATTRIBBUFFER0_OFFSET + id*3, (const u8*)data - sb->base);
+}
+
+void GPUCMD_AddStreamBufIndexBuffer(const gpuStreamBuf_s* sb, const void* data, bool shortIndices)
+{
+	GPUCMD_AddWrite(GPUREG_INDEXBUFFER_CONFIG, ((const u8*)data - sb->base) | (shortIndices ? BIT(31) : 0));
+}
@@ -0,0 +1,298 @@
+#include <stdlib.h>
+#include <3ds/types.h>
+#include <3ds/result.h>
+#include <3ds/synchronization.h>
+#include <3ds/services/gspgpu.h>
+#include <3ds/gpu/gx.h>
+#include <3ds/gpu/texupload.h>
+
+#define MAX_FLUSH_RANGES 8
+#define FLUSH_MERGE_GAP  0x1000
+
+typedef struct
+{
+	u32 start, end;
+} flushRange_s;
+
+static const u8 gxFormatBpp[] = { 4, 3, 2, 2, 2 };
+
+static void gxTexUploaderQueueCallback(gxCmdQueue_s* queue)
+{
+	gxTexUploader_s* up = (gxTexUploader_s*)queue->user;
+
+	// Leave GX idle: the queue that was current before the batch may only be run again by its owner,
+	// which may be recording commands into it on purpose
+	gxCmdQueueStop(queue);
+	LightEvent_Signal(&up->idle);
+}
+
+bool gxTexUploaderInit(gxTexUploader_s* up, u16 maxCmds)
+{
+	if (!up || !maxCmds)
+		return false;
+
+	up->queue.entries = (gxCmdEntry_s*)malloc(maxCmds*sizeof(gxCmdEntry_s));
+	if (!up->queue.entries)
+		return false;
+
+	up->queue.maxEntries = maxCmds;
+	gxCmdQueueClear(&up->queue);
+	gxCmdQueueSetCallback(&up->queue, gxTexUploaderQueueCallback, up);
+
+	up->first = up->last = NULL;
+	up->firstPending = up->lastPending = NULL;
+	LightEvent_Init(&up->idle, RESET_STICKY);
+	LightEvent_Signal(&up->idle);
+	return true;
+}
+
+void gxTexUploaderExit(gxTexUploader_s* up)
+{
+	if (!up->queue.entries)
+		return;
+
+	gxTexUploaderWait(up, -1);
+	free(up->queue.entries);
+	up->queue.entries = NULL;
+	up->firstPending = up->lastPending = NULL;
+}
+
+static void gxTexUploaderRecord(gxTexUploader_s* up, gxTexUpload_s* upload)
+{
+	upload->done = false;
+	upload->lastCmd = 0;
+	upload->callback = NULL;
+	upload->user = NULL;
+	upload->next = NULL;
+
+	if (up->lastPending)
+		up->lastPending->next = upload;
+	else
+		up->firstPending = upload;
+	up->lastPending = upload;
+}
+
+bool gxTexUploadImage(gxTexUploader_s* up, gxTexUpload_s* upload, const void* src, void* dst, u16 width, u16 height,
+	GX_TRANSFER_FORMAT inFmt, GX_TRANSFER_FORMAT outFmt, u8 numLevels, bool flip)
+{
+	if (!up || !upload || !src || !dst)
+		return false;
+	if (width < 8 || height < 8 || (width & 7) || (height & 7))
+		return false;
+	if (inFmt > GX_TRANSFER_FMT_RGBA4 || outFmt > GX_TRANSFER_FMT_RGBA4)
+		return false;
+
+	// Only keep the levels the hardware is able to transfer (at least 8x8)
+	u8 maxLevels = 1;
+	while ((width >> maxLevels) >= 8 && (height >> maxLevels) >= 8 && !((width >> maxLevels) & 7) && !((height >> maxLevels) & 7))
+		maxLevels++;
+	if (!numLevels)
+		numLevels = 1;
+	if (numLevels > maxLevels)
+		numLevels = maxLevels;
+
+	upload->src       = src;
+	upload->dst       = dst;
+	upload->width     = width;
+	upload->height    = height;
+	upload->numLevels = numLevels;
+	upload->size      = 0;
+	upload->flags     =
+		GX_TRANSFER_FLIP_VERT(flip ? 1 : 0) | GX_TRANSFER_OUT_TILED(1) | GX_TRANSFER_RAW_COPY(0) |
+		GX_TRANSFER_IN_FORMAT(inFmt) | GX_TRANSFER_OUT_FORMAT(outFmt) | GX_TRANSFER_SCALING(GX_TRANSFER_SCALE_NO);
+
+	gxTexUploaderRecord(up, upload);
+	return true;
+}
+
+bool gxTexUploadRaw(gxTexUploader_s* up, gxTexUpload_s* upload, const void* src, void* dst, u32 size)
+{
+	if (!up || !upload || !src || !dst || !size || (size & 0xF))
+		return false;
+
+	upload->src       = src;
+	upload->dst       = dst;
+	upload->size      = size;
+	upload->numLevels = 0; // Raw copy
+	upload->width     = 0;
+	upload->height    = 0;
+	upload->flags     = GX_TRANSFER_RAW_COPY(1);
+
+	gxTexUploaderRecord(up, upload);
+	return true;
+}
+
+static inline u32 gxTexUploadNumCmds(const gxTexUpload_s* upload)
+{
+	return upload->numLevels ? upload->numLevels : 1;
+}
+
+static u32 gxTexUploadSrcSize(const gxTexUpload_s* upload)
+{
+	if (!upload->numLevels)
+		return upload->size;
+
+	u32 bpp = gxFormatBpp[(upload->flags >> 8) & 7];
+	u32 size = 0;
+	for (u32 i = 0; i < upload->numLevels; i ++)
+		size += (upload->width >> i) * (upload->height >> i) * bpp;
+	return size;
+}
+
+static void gxTexUploadAddRange(flushRange_s* ranges, u32* numRanges, u32 start, u32 end)
+{
+	u32 i, best = 0, bestCost = UINT32_MAX;
+	for (i = 0; i < *numRanges; i ++)
+	{
+		flushRange_s* r = &ranges[i];
+		if (start <= r->end + FLUSH_MERGE_GAP && end + FLUSH_MERGE_GAP >= r->start)
+		{
+			// Overlapping or close enough, merge
+			if (start < r->start) r->start = start;
+			if (end > r->end) r->end = end;
+			return;
+		}
+
+		u32 cost = start > r->end ? start - r->end : r->start - end;
+		if (cost < bestCost)
+		{
+			best = i;
+			bestCost = cost;
+		}
+	}
+
+	if (*numRanges < MAX_FLUSH_RANGES)
+	{
+		ranges[*numRanges].start = start;
+		ranges[*numRanges].end = end;
+		(*numRanges)++;
+		return;
+	}
+
+	// Out of ranges: extend the closest one
+	if (start < ranges[best].start) ranges[best].start = start;
+	if (end > ranges[best].end) ranges[best].end = end;
+}
+
+static void gxTexUploadIssue(gxTexUpload_s* upload)
+{
+	if (!upload->numLevels)
+	{
+		GX_TextureCopy((u32*)upload->src, 0, (u32*)upload->dst, 0, upload->size, upload->flags);
+		return;
+	}
+
+	const u8* src = (const u8*)upload->src;
+	u8* dst = (u8*)upload->dst;
+	u32 inBpp = gxFormatBpp[(upload->flags >> 8) & 7];
+	u32 outBpp = gxFormatBpp[(upload->flags >> 12) & 7];
+	for (u32 i = 0; i < upload->numLevels; i ++)
+	{
+		u32 w = upload->width >> i, h = upload->height >> i;
+		u32 dim = GX_BUFFER_DIM(w, h);
+		GX_DisplayTransfer((u32*)src, dim, (u32*)dst, dim, upload->flags);
+		src += w*h*inBpp;
+		dst += w*h*outBpp;
+	}
+}
+
+Result gxTexUploaderSubmit(gxTexUploader_s* up)
+{
+	if (!up->firstPending)
+		return 0;
+
+	// Wait for the previous batch and retire it
+	LightEvent_Wait(&up->idle);
+	gxTexUploaderPoll(up);
+
+	// GX only runs one command queue at a time: don't preempt another one that is processing commands
+	bool running;
+	if (gxCmdQueueGetCurrent(&running) && running)
+		return MAKERESULT(RL_TEMPORARY, RS_WOULDBLOCK, RM_APPLICATION, RD_BUSY);
+
+	// Select as many uploads as fit in the command queue
+	gxTexUpload_s* upload = up->firstPending;
+	gxTexUpload_s* lastSel = NULL;
+	flushRange_s ranges[MAX_FLUSH_RANGES];
+	u32 numRanges = 0, numCmds = 0;
+	for (; upload; upload = upload->next)
+	{
+		u32 cmds = gxTexUploadNumCmds(upload);
+		if (numCmds + cmds > up->queue.maxEntries)
+			break;
+		numCmds += cmds;
+		lastSel = upload;
+
+		u32 start = (u32)upload->src;
+		gxTexUploadAddRange(ranges, &numRanges, start, start + gxTexUploadSrcSize(upload));
+	}
+
+	if (!lastSel)
+		return MAKERESULT(RL_USAGE, RS_OUTOFRESOURCE, RM_APPLICATION, RD_TOO_LARGE);
+
+	// Flush the merged source ranges
+	for (u32 i = 0; i < numRanges; i ++)
+	{
+		Result res = GSPGPU_FlushDataCache((const void*)ranges[i].start, ranges[i].end - ranges[i].start);
+		if (R_FAILED(res))
+			return res;
+	}
+
+	// Record the transfers into the command queue
+	gxCmdQueueClear(&up->queue);
+	gxCmdQueue_s* boundQueue = GX_GetBoundQueue();
+	GX_BindQueue(&up->queue);
+	for (upload = up->firstPending;; upload = upload->next)
+	{
+		gxTexUploadIssue(upload);
+		upload->lastCmd = up->queue.numEntries;
+		if (upload == lastSel)
+			break;
+	}
+	GX_BindQueue(boundQueue);
+
+	LightEvent_Clear(&up->idle);
+	if (!gxCmdQueueRun(&up->queue))
+	{
+		// Another queue started in the meantime, the batch stays pending
+		LightEvent_Signal(&up->idle);
+		return MAKERESULT(RL_TEMPORARY, RS_WOULDBLOCK, RM_APPLICATION, RD_BUSY);
+	}
+
+	// Move the selected uploads to the in-flight list
+	up->first = up->firstPending;
+	up->last = lastSel;
+	up->firstPending = lastSel->next;
+	if (!up->firstPending)
+		up->lastPending = NULL;
+	lastSel->next = NULL;
+	return 0;
+}
+
+void gxTexUploaderPoll(gxTexUploader_s* up)
+{
+	u16 completed = *(volatile u16*)&up->queue.lastEntry;
+	while (up->first && up->first->lastCmd <= completed)
+	{
+		gxTexUpload_s* upload = up->first;
+		up->first = upload->next;
+		if (!up->first)
+			up->last = NULL;
+
+		upload->next = NULL;
+		upload->done = true;
+		if (upload->callback)
+			upload->callback(upload);
+	}
+}
+
+bool gxTexUploaderWait(gxTexUploader_s* up, s64 timeout)
+{
+	if (timeout < 0)
+		LightEvent_Wait(&up->idle);
+	else if (LightEvent_WaitTimeout(&up->idle, timeout))
+		return false;
+
+	gxTexUploaderPoll(up);
+	return true;
+}
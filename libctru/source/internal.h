@@ -38,8 +38,12 @@ struct Thread_tag
 	void* arg;
 	int rc;
 	bool detached, finished;
+	bool watermark; // Whether the stack was filled with the guard pattern
 	struct _reent reent;
 	void* stacktop;
+	size_t allocsize; // Size of the block without TLS, used to match pooled blocks
+	__FILE* stdfiles[3]; // Standard files inherited from the creating thread
+	struct Thread_tag* next; // Next block in the thread pool
 };
 
 static inline ThreadVars* getThreadVars(void)
@@ -48,3 +52,6 @@ static inline ThreadVars* getThreadVars(void)
 }
 
 void initThreadVars(struct Thread_tag *thread);
+
+// Whether srvGetServiceHandle is non-blocking for the current thread, see srvSetBlockingPolicy
+bool srvGetBlockingPolicy(void);
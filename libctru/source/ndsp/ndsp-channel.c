@@ -1,4 +1,5 @@
 #include "ndsp-internal.h"
+#include <math.h>
 #include <3ds/ndsp/channel.h>
 
 enum
@@ -15,6 +16,42 @@ enum
 	CFLAG_IIRBIQUAD     = BIT(9),
 };
 
+// Automated parameters sharing the same channel setting use the same slot
+enum
+{
+	AUTO_SLOT_VOLUME,
+	AUTO_SLOT_RATE,
+	AUTO_SLOT_IIRMONO,
+	AUTO_SLOT_IIRBIQUAD,
+
+	AUTO_SLOT_COUNT,
+};
+
+static const u8 autoSlots[] =
+{
+	[NDSP_AUTO_VOLUME]         = AUTO_SLOT_VOLUME,
+	[NDSP_AUTO_RATE]           = AUTO_SLOT_RATE,
+	[NDSP_AUTO_IIR_MONO_LPF]   = AUTO_SLOT_IIRMONO,
+	[NDSP_AUTO_IIR_MONO_HPF]   = AUTO_SLOT_IIRMONO,
+	[NDSP_AUTO_IIR_BIQUAD_LPF] = AUTO_SLOT_IIRBIQUAD,
+	[NDSP_AUTO_IIR_BIQUAD_HPF] = AUTO_SLOT_IIRBIQUAD,
+};
+
+#define AUTO_CURVE_TABLE   (NDSP_CURVE_EXPONENTIAL+1)
+#define AUTO_TABLE_MAX     0x8000
+
+typedef struct
+{
+	u8 param, curve;
+	bool loop;
+	u32 frame, frames;
+	float value, step, end;
+
+	const float* table;
+	u32 tableCount;
+	u32 tablePos, tableStep; // 16.16 fixed point
+} ndspAutoSt;
+
 typedef struct
 {
 	u32 flags;
@@ -41,6 +78,11 @@ typedef struct
 
 	u16 adpcmCoefs[16];
 
+	float gain;
+	float autoQ;
+	u8 autoActive;
+	ndspAutoSt autos[AUTO_SLOT_COUNT];
+
 } ndspChnSt;
 
 static ndspChnSt ndspChn[24];
@@ -69,6 +111,9 @@ void ndspChnReset(int id)
 	chn->rate = 1.0f;
 	chn->mix[0] = chn->mix[1] = 1.0f;
 	memset(&chn->mix[2], 0, 14*sizeof(float));
+	chn->gain = 1.0f;
+	chn->autoQ = M_SQRT1_2;
+	chn->autoActive = 0;
 	LightLock_Unlock(&chn->lock);
 }
 
@@ -239,12 +284,29 @@ static s16 iirParamClamp(float param, float scale_factor, bool* success)
 	return result;
 }
 
-bool ndspChnIirMonoSetParamsCustomFilter(int id, float a0, float a1, float b0)
+static bool iirMonoParams(s16 params[2], float a0, float a1, float b0)
 {
 	bool success = true;
-	s16 params[2];
 	params[0] = iirParamClamp(+b0 / a0, (float)(1 << 15), &success);
 	params[1] = iirParamClamp(-a1 / a0, (float)(1 << 15), &success);
+	return success;
+}
+
+static bool iirBiquadParams(s16 params[5], float a0, float a1, float a2, float b0, float b1, float b2)
+{
+	bool success = true;
+	params[0] = iirParamClamp(-a2 / a0, (float)(1 << 14), &success);
+	params[1] = iirParamClamp(-a1 / a0, (float)(1 << 14), &success);
+	params[2] = iirParamClamp(+b2 / a0, (float)(1 << 14), &success);
+	params[3] = iirParamClamp(+b1 / a0, (float)(1 << 14), &success);
+	params[4] = iirParamClamp(+b0 / a0, (float)(1 << 14), &success);
+	return success;
+}
+
+bool ndspChnIirMonoSetParamsCustomFilter(int id, float a0, float a1, float b0)
+{
+	s16 params[2];
+	bool success = iirMonoParams(params, a0, a1, b0);
 
 	ndspChnSt* chn = &ndspChn[id];
 	LightLock_Lock(&chn->lock);
@@ -261,13 +323,8 @@ bool ndspChnIirMonoSetParamsCustomFilter(int id, float a0, float a1, float b0)
 
 bool ndspChnIirBiquadSetParamsCustomFilter(int id, float a0, float a1, float a2, float b0, float b1, float b2)
 {
-	bool success = true;
 	s16 params[5];
-	params[0] = iirParamClamp(-a2 / a0, (float)(1 << 14), &success);
-	params[1] = iirParamClamp(-a1 / a0, (float)(1 << 14), &success);
-	params[2] = iirParamClamp(+b2 / a0, (float)(1 << 14), &success);
-	params[3] = iirParamClamp(+b1 / a0, (float)(1 << 14), &success);
-	params[4] = iirParamClamp(+b0 / a0, (float)(1 << 14), &success);
+	bool success = iirBiquadParams(params, a0, a1, a2, b0, b1, b2);
 
 	ndspChnSt* chn = &ndspChn[id];
 	LightLock_Lock(&chn->lock);
@@ -282,6 +339,186 @@ bool ndspChnIirBiquadSetParamsCustomFilter(int id, float a0, float a1, float a2,
 	return success;
 }
 
+static bool autoStart(int id, ndspAutoParam param, const ndspAutoSt* a)
+{
+	if ((unsigned)param >= sizeof(autoSlots))
+		return false;
+
+	int slot = autoSlots[param];
+	if (slot == AUTO_SLOT_IIRMONO || slot == AUTO_SLOT_IIRBIQUAD)
+		ndspiFilterTablesInit();
+
+	ndspChnSt* chn = &ndspChn[id];
+	LightLock_Lock(&chn->lock);
+
+	chn->autos[slot] = *a;
+	chn->autos[slot].param = param;
+	chn->autoActive |= BIT(slot);
+
+	if (slot == AUTO_SLOT_IIRMONO)
+	{
+		chn->iirFilterType |= BIT(0);
+		chn->flags |= CFLAG_IIRFILTERTYPE;
+	} else if (slot == AUTO_SLOT_IIRBIQUAD)
+	{
+		chn->iirFilterType |= BIT(1);
+		chn->flags |= CFLAG_IIRFILTERTYPE;
+	}
+
+	LightLock_Unlock(&chn->lock);
+	return true;
+}
+
+bool ndspChnAutomate(int id, ndspAutoParam param, ndspCurveType curve, float start, float end, u32 frames)
+{
+	ndspAutoSt a = { .curve = curve, .frames = frames, .value = start, .end = end };
+
+	switch (curve)
+	{
+		case NDSP_CURVE_LINEAR:
+			a.step = frames ? (end - start) / frames : 0.0f;
+			break;
+		case NDSP_CURVE_EXPONENTIAL:
+			if (!(start > 0.0f && end > 0.0f))
+				return false;
+			a.step = frames ? powf(end / start, 1.0f / frames) : 1.0f;
+			break;
+		default:
+			return false;
+	}
+
+	return autoStart(id, param, &a);
+}
+
+bool ndspChnAutomateTable(int id, ndspAutoParam param, const float* table, u32 count, u32 frames, bool loop)
+{
+	if (!table || count < 2 || count > AUTO_TABLE_MAX || (loop && !frames))
+		return false;
+
+	ndspAutoSt a = { .curve = AUTO_CURVE_TABLE, .loop = loop, .frames = frames, .end = table[count-1] };
+	a.table = table;
+	a.tableCount = count;
+
+	// A looping table also interpolates from its last value back to its first one
+	u32 segments = loop ? count : count-1;
+	if (frames)
+		a.tableStep = ((u64)segments << 16) / frames;
+
+	return autoStart(id, param, &a);
+}
+
+void ndspChnAutomationSetQ(int id, float Q)
+{
+	ndspChnSt* chn = &ndspChn[id];
+	LightLock_Lock(&chn->lock);
+	chn->autoQ = Q;
+	LightLock_Unlock(&chn->lock);
+}
+
+bool ndspChnIsAutomating(int id, ndspAutoParam param)
+{
+	if ((unsigned)param >= sizeof(autoSlots))
+		return false;
+
+	ndspChnSt* chn = &ndspChn[id];
+	int slot = autoSlots[param];
+	return (chn->autoActive & BIT(slot)) && chn->autos[slot].param == param;
+}
+
+void ndspChnAutomationStop(int id, ndspAutoParam param)
+{
+	if ((unsigned)param >= sizeof(autoSlots))
+		return;
+
+	ndspChnSt* chn = &ndspChn[id];
+	int slot = autoSlots[param];
+	LightLock_Lock(&chn->lock);
+	if (chn->autos[slot].param == param)
+		chn->autoActive &= ~BIT(slot);
+	LightLock_Unlock(&chn->lock);
+}
+
+// Returns the value of an automated parameter for the current frame and advances its automation
+static float autoAdvance(ndspChnSt* chn, int slot)
+{
+	ndspAutoSt* a = &chn->autos[slot];
+	float value;
+
+	if (!a->loop)
+	{
+		if (a->frame >= a->frames)
+		{
+			chn->autoActive &= ~BIT(slot);
+			return a->end;
+		}
+		a->frame++;
+	}
+
+	switch (a->curve)
+	{
+		case NDSP_CURVE_LINEAR:
+			value = a->value;
+			a->value += a->step;
+			break;
+		case NDSP_CURVE_EXPONENTIAL:
+			value = a->value;
+			a->value *= a->step;
+			break;
+		default:
+		{
+			u32 i = a->tablePos >> 16;
+			u32 j = i+1 < a->tableCount ? i+1 : 0;
+			float t = (a->tablePos & 0xFFFF) * (1.0f / 0x10000);
+			value = a->table[i] + (a->table[j] - a->table[i]) * t;
+
+			a->tablePos += a->tableStep;
+			if (a->loop && a->tablePos >= (a->tableCount << 16))
+				a->tablePos -= a->tableCount << 16;
+			break;
+		}
+	}
+
+	return value;
+}
+
+static u32 ndspiUpdateAutomation(ndspChnSt* chn)
+{
+	u32 flags = 0;
+	u8 active = chn->autoActive;
+
+	if (active & BIT(AUTO_SLOT_VOLUME))
+	{
+		chn->gain = autoAdvance(chn, AUTO_SLOT_VOLUME);
+		flags |= CFLAG_MIX;
+	}
+
+	if (active & BIT(AUTO_SLOT_RATE))
+	{
+		chn->rate = autoAdvance(chn, AUTO_SLOT_RATE) * (float)(1.0 / NDSP_SAMPLE_RATE);
+		flags |= CFLAG_RATE;
+	}
+
+	if (active & BIT(AUTO_SLOT_IIRMONO))
+	{
+		float c[3];
+		bool highPass = chn->autos[AUTO_SLOT_IIRMONO].param == NDSP_AUTO_IIR_MONO_HPF;
+		ndspiFilterMonoCoefs(c, autoAdvance(chn, AUTO_SLOT_IIRMONO), highPass);
+		iirMonoParams(chn->iirMono, c[0], c[1], c[2]);
+		flags |= CFLAG_IIRMONO;
+	}
+
+	if (active & BIT(AUTO_SLOT_IIRBIQUAD))
+	{
+		float c[6];
+		bool highPass = chn->autos[AUTO_SLOT_IIRBIQUAD].param == NDSP_AUTO_IIR_BIQUAD_HPF;
+		ndspiFilterBiquadCoefs(c, autoAdvance(chn, AUTO_SLOT_IIRBIQUAD), chn->autoQ, highPass);
+		iirBiquadParams(chn->iirBiquad, c[0], c[1], c[2], c[3], c[4], c[5]);
+		flags |= CFLAG_IIRBIQUAD;
+	}
+
+	return flags;
+}
+
 void ndspiInitChn(void)
 {
 	int i;
@@ -313,12 +550,17 @@ void ndspiUpdateChn(void)
 		u32 flags = chn->flags;
 		u32 stflags = st->flags;
 
+		if (chn->autoActive)
+			flags |= ndspiUpdateAutomation(chn);
+
 		if (flags & CFLAG_INITPARAMS)
 			stflags |= 0x20000000;
 
 		if (flags & CFLAG_MIX)
 		{
-			memcpy(st->mix, chn->mix, sizeof(st->mix));
+			int j;
+			for (j = 0; j < 12; j ++)
+				st->mix[j] = chn->mix[j] * chn->gain;
 			stflags |= 0xE000000;
 		}
 
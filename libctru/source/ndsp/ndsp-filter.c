@@ -2,9 +2,74 @@
 #include <3ds/types.h>
 #include <3ds/ndsp/ndsp.h>
 #include <3ds/ndsp/channel.h>
+#include "ndsp-internal.h"
 
 #define Fs NDSP_SAMPLE_RATE
 
+// Tables of sin(w), cos(w) and exp(-w) for w = 0..pi, used to update the automated filters every frame without
+// evaluating transcendental functions (the quantized coefficients stay within one step of the exact ones)
+#define FILTER_TABLE_SIZE 512
+
+static float filterSin[FILTER_TABLE_SIZE+1];
+static float filterCos[FILTER_TABLE_SIZE+1];
+static float filterExp[FILTER_TABLE_SIZE+1];
+static bool filterTablesReady;
+
+void ndspiFilterTablesInit(void)
+{
+	if (filterTablesReady)
+		return;
+
+	int i;
+	for (i = 0; i <= FILTER_TABLE_SIZE; i ++)
+	{
+		const float w = M_PI * i / FILTER_TABLE_SIZE;
+		filterSin[i] = sinf(w);
+		filterCos[i] = cosf(w);
+		filterExp[i] = expf(-w);
+	}
+	filterTablesReady = true;
+}
+
+static inline float filterLookup(const float* table, float f0)
+{
+	// w0 = 2*pi*f0/Fs, scaled to the table
+	const float pos = f0 * (2.f * FILTER_TABLE_SIZE / Fs);
+	if (pos <= 0.f)
+		return table[0];
+	if (pos >= FILTER_TABLE_SIZE)
+		return table[FILTER_TABLE_SIZE];
+
+	const int i = (int)pos;
+	return table[i] + (table[i+1] - table[i]) * (pos - i);
+}
+
+void ndspiFilterMonoCoefs(float coefs[3], float f0, bool highPass)
+{
+	// Same as ndspChnIirMonoSetParams{Low,High}PassFilter
+	const float e = filterLookup(filterExp, highPass ? 0.5f * Fs - f0 : f0);
+
+	coefs[0] = 1.f;
+	coefs[1] = 1.f - e;
+	coefs[2] = highPass ? -e : e;
+}
+
+void ndspiFilterBiquadCoefs(float coefs[6], float f0, float Q, bool highPass)
+{
+	// Same as ndspChnIirBiquadSetParams{Low,High}PassFilter
+	const float s = filterLookup(filterSin, f0);
+	const float c = filterLookup(filterCos, f0);
+	const float a = s / (2.f * Q);
+	const float k = highPass ? 1.f + c : 1.f - c;
+
+	coefs[0] = 1.f + a;
+	coefs[1] = -2.f * c;
+	coefs[2] = 1.f - a;
+	coefs[3] = 0.5f * k;
+	coefs[4] = highPass ? -k : k;
+	coefs[5] = 0.5f * k;
+}
+
 bool ndspChnIirMonoSetParamsLowPassFilter(int id, float f0)
 {
 	const float w0 = 2.f * M_PI * f0 / Fs;
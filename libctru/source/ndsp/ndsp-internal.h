@@ -106,3 +106,7 @@ void ndspiInitChn(void);
 void ndspiDirtyChn(void);
 void ndspiUpdateChn(void);
 void ndspiReadChnState(void);
+
+void ndspiFilterTablesInit(void);
+void ndspiFilterMonoCoefs(float coefs[3], float f0, bool highPass);
+void ndspiFilterBiquadCoefs(float coefs[6], float f0, float Q, bool highPass);
@@ -16,23 +16,142 @@ static inline double u64_to_double(u64 value) {
 
 __attribute__((weak)) bool __ctru_speedup = false;
 
+// Physical memory regions, indexed by the region map below
+typedef struct {
+	u32 vaddr, size, offset;
+} osPhysRegion;
+
+#define PHYS_REGION(_name) { OS_##_name##_VADDR, OS_##_name##_SIZE, OS_##_name##_PADDR - OS_##_name##_VADDR }
+#define PHYS_MAP(_name, _idx) [OS_##_name##_VADDR >> 20 ... (OS_##_name##_VADDR + OS_##_name##_SIZE - 1) >> 20] = _idx
+
+static const osPhysRegion s_physRegions[] = {
+	{ 0, 0, 0 },
+	PHYS_REGION(FCRAM),
+	PHYS_REGION(VRAM),
+	PHYS_REGION(OLD_FCRAM),
+	PHYS_REGION(DSPRAM),
+	PHYS_REGION(QTMRAM),
+	PHYS_REGION(MMIO),
+};
+
+// Region of each 1 MiB of the address space (0 if none)
+static const u8 s_physRegionMap[0x1000] = {
+	PHYS_MAP(FCRAM, 1),
+	PHYS_MAP(VRAM, 2),
+	PHYS_MAP(OLD_FCRAM, 3),
+	PHYS_MAP(DSPRAM, 4),
+	PHYS_MAP(QTMRAM, 5),
+	PHYS_MAP(MMIO, 6),
+};
+
+#undef PHYS_REGION
+#undef PHYS_MAP
+
+// User-registered mappings, looked up when the address is outside the fixed regions.
+// The count is modified with the lock held, and read without it to skip the lookup when there are no mappings.
+static LightLock s_physMappingLock = 1;
+static osPhysRegion s_physMappings[OS_MAX_PHYS_MAPPINGS];
+static u32 s_physMappingCount;
+
+static u32 osConvertRegisteredToPhys(u32 vaddr)
+{
+	u32 ret = 0;
+	LightLock_Lock(&s_physMappingLock);
+	for (u32 i = 0; i < s_physMappingCount; i ++)
+	{
+		const osPhysRegion* r = &s_physMappings[i];
+		if (vaddr - r->vaddr < r->size)
+		{
+			ret = vaddr + r->offset;
+			break;
+		}
+	}
+	LightLock_Unlock(&s_physMappingLock);
+	return ret;
+}
+
+static inline u32 osConvertToPhys(u32 vaddr)
+{
+	const osPhysRegion* r = &s_physRegions[s_physRegionMap[vaddr >> 20]];
+	if (vaddr - r->vaddr < r->size)
+		return vaddr + r->offset;
+	if (!__atomic_load_n(&s_physMappingCount, __ATOMIC_ACQUIRE))
+		return 0;
+	return osConvertRegisteredToPhys(vaddr);
+}
+
 //---------------------------------------------------------------------------------
 u32 osConvertVirtToPhys(const void* addr) {
 //---------------------------------------------------------------------------------
-	u32 vaddr = (u32)addr;
-#define CONVERT_REGION(_name) \
-	if (vaddr >= OS_##_name##_VADDR && vaddr < (OS_##_name##_VADDR + OS_##_name##_SIZE)) \
-		return vaddr + (OS_##_name##_PADDR - OS_##_name##_VADDR);
-
-	CONVERT_REGION(FCRAM);
-	CONVERT_REGION(VRAM);
-	CONVERT_REGION(OLD_FCRAM);
-	CONVERT_REGION(DSPRAM);
-	CONVERT_REGION(QTMRAM);
-	CONVERT_REGION(MMIO);
-
-#undef CONVERT_REGION
-	return 0;
+	return osConvertToPhys((u32)addr);
+}
+
+//---------------------------------------------------------------------------------
+size_t osConvertVirtToPhysBatch(u32* out, const void* const* vaddrs, size_t count) {
+//---------------------------------------------------------------------------------
+	size_t converted = 0;
+	for (size_t i = 0; i < count; i ++)
+	{
+		out[i] = osConvertToPhys((u32)vaddrs[i]);
+		if (out[i]) converted ++;
+	}
+	return converted;
+}
+
+//---------------------------------------------------------------------------------
+Result osRegisterPhysMapping(const void* vaddr, u32 paddr, u32 size) {
+//---------------------------------------------------------------------------------
+	u32 start = (u32)vaddr;
+	if (!size || start + size < start)
+		return MAKERESULT(RL_USAGE, RS_INVALIDARG, RM_OS, RD_INVALID_SIZE);
+
+	// The range must not overlap a fixed region or another mapping
+	for (u32 mb = start >> 20; mb <= (start + size - 1) >> 20; mb ++)
+	{
+		const osPhysRegion* r = &s_physRegions[s_physRegionMap[mb]];
+		if (r->size && start < r->vaddr + r->size && r->vaddr < start + size)
+			return MAKERESULT(RL_USAGE, RS_INVALIDARG, RM_OS, RD_INVALID_ADDRESS);
+	}
+
+	Result ret = 0;
+	LightLock_Lock(&s_physMappingLock);
+	for (u32 i = 0; i < s_physMappingCount; i ++)
+	{
+		const osPhysRegion* r = &s_physMappings[i];
+		if (start < r->vaddr + r->size && r->vaddr < start + size)
+			ret = MAKERESULT(RL_USAGE, RS_INVALIDARG, RM_OS, RD_INVALID_ADDRESS);
+	}
+	if (R_SUCCEEDED(ret) && s_physMappingCount == OS_MAX_PHYS_MAPPINGS)
+		ret = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_OS, RD_OUT_OF_RANGE);
+	if (R_SUCCEEDED(ret))
+	{
+		osPhysRegion* r = &s_physMappings[s_physMappingCount];
+		r->vaddr = start;
+		r->size = size;
+		r->offset = paddr - start;
+		__atomic_store_n(&s_physMappingCount, s_physMappingCount + 1, __ATOMIC_RELEASE);
+	}
+	LightLock_Unlock(&s_physMappingLock);
+	return ret;
+}
+
+//---------------------------------------------------------------------------------
+Result osUnregisterPhysMapping(const void* vaddr) {
+//---------------------------------------------------------------------------------
+	Result ret = MAKERESULT(RL_USAGE, RS_NOTFOUND, RM_OS, RD_NOT_FOUND);
+	LightLock_Lock(&s_physMappingLock);
+	for (u32 i = 0; i < s_physMappingCount; i ++)
+	{
+		if (s_physMappings[i].vaddr == (u32)vaddr)
+		{
+			s_physMappings[i] = s_physMappings[s_physMappingCount - 1];
+			__atomic_store_n(&s_physMappingCount, s_physMappingCount - 1, __ATOMIC_RELEASE);
+			ret = 0;
+			break;
+		}
+	}
+	LightLock_Unlock(&s_physMappingLock);
+	return ret;
 }
 
 //---------------------------------------------------------------------------------
@@ -17,6 +17,7 @@
 #include <3ds/env.h>
 
 #include "path_buf.h"
+#include "romfs_hash.h"
 
 typedef struct romfs_mount
 {
@@ -355,22 +356,10 @@ Result romfsUnmount(const char* name)
 
 //-----------------------------------------------------------------------------
 
-static u32 calcHash(u32 parent, u16* name, u32 namelen, u32 total)
-{
-	u32 hash = parent ^ 123456789;
-	u32 i;
-	for (i = 0; i < namelen; i ++)
-	{
-		hash = (hash >> 5) | (hash << 27);
-		hash ^= name[i];
-	}
-	return hash % total;
-}
-
 static romfs_dir* searchForDir(romfs_mount *mount, romfs_dir* parent, u16* name, u32 namelen)
 {
 	u32 parentOff = (u32)parent - (u32)mount->dirTable;
-	u32 hash = calcHash(parentOff, name, namelen, mount->header.dirHashTableSize/4);
+	u32 hash = romfsCalcHash(parentOff, name, namelen, mount->header.dirHashTableSize/4);
 	romfs_dir* curDir = NULL;
 	u32 curOff;
 	for (curOff = mount->dirHashTable[hash]; curOff != romFS_none; curOff = curDir->nextHash)
@@ -387,7 +376,7 @@ static romfs_dir* searchForDir(romfs_mount *mount, romfs_dir* parent, u16* name,
 static romfs_file* searchForFile(romfs_mount *mount, romfs_dir* parent, u16* name, u32 namelen)
 {
 	u32 parentOff = (u32)parent - (u32)mount->dirTable;
-	u32 hash = calcHash(parentOff, name, namelen, mount->header.fileHashTableSize/4);
+	u32 hash = romfsCalcHash(parentOff, name, namelen, mount->header.fileHashTableSize/4);
 	romfs_file* curFile = NULL;
 	u32 curOff;
 	for (curOff = mount->fileHashTable[hash]; curOff != romFS_none; curOff = curFile->nextHash)
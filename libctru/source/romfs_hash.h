@@ -0,0 +1,15 @@
+#pragma once
+#include <3ds/types.h>
+
+// Hash of a directory or file name in the RomFS hash tables
+static inline u32 romfsCalcHash(u32 parent, const u16* name, u32 namelen, u32 total)
+{
+	u32 hash = parent ^ 123456789;
+	u32 i;
+	for (i = 0; i < namelen; i ++)
+	{
+		hash = (hash >> 5) | (hash << 27);
+		hash ^= name[i];
+	}
+	return hash % total;
+}
@@ -593,21 +593,31 @@ static Result aptReceiveParameter(APT_Command* cmd, size_t* actualSize, Handle*
 	return res;
 }
 
-APT_Command aptWaitForWakeUp(APT_Transition transition)
+static void aptWakeUpBegin(APT_Transition transition)
 {
-	APT_Command cmd;
 	APT_NotifyToWait(envGetAptAppId());
 	aptFlags &= ~FLAG_ACTIVE;
 	if (transition != TR_ENABLE)
 		APT_SleepIfShellClosed();
+}
+
+// Receives parameters until a wakeup command is found; only handles the pending ones if not blocking
+static bool aptWakeUpPoll(APT_Command* cmd, bool block)
+{
 	for (;;)
 	{
-		Result res = aptReceiveParameter(&cmd, NULL, NULL);
+		if (!block && !LightEvent_TryWait(&aptReceiveEvent))
+			return false;
+		Result res = aptReceiveParameter(cmd, NULL, NULL);
 		if (R_SUCCEEDED(res)
-			&& (cmd==APTCMD_WAKEUP || cmd==APTCMD_WAKEUP_PAUSE || cmd==APTCMD_WAKEUP_EXIT || cmd==APTCMD_WAKEUP_CANCEL
-			|| cmd==APTCMD_WAKEUP_CANCELALL || cmd==APTCMD_WAKEUP_POWERBUTTON || cmd==APTCMD_WAKEUP_JUMPTOHOME
-			|| cmd==APTCMD_WAKEUP_LAUNCHAPP)) break;
+			&& (*cmd==APTCMD_WAKEUP || *cmd==APTCMD_WAKEUP_PAUSE || *cmd==APTCMD_WAKEUP_EXIT || *cmd==APTCMD_WAKEUP_CANCEL
+			|| *cmd==APTCMD_WAKEUP_CANCELALL || *cmd==APTCMD_WAKEUP_POWERBUTTON || *cmd==APTCMD_WAKEUP_JUMPTOHOME
+			|| *cmd==APTCMD_WAKEUP_LAUNCHAPP)) return true;
 	}
+}
+
+static void aptWakeUpFinish(APT_Transition transition, APT_Command cmd)
+{
 	aptFlags |= FLAG_ACTIVE;
 
 	void __ctru_speedup_config();
@@ -647,7 +657,14 @@ APT_Command aptWaitForWakeUp(APT_Transition transition)
 		if (cmd != APTCMD_WAKEUP_JUMPTOHOME)
 			aptClearJumpToHome();
 	}
+}
 
+APT_Command aptWaitForWakeUp(APT_Transition transition)
+{
+	APT_Command cmd;
+	aptWakeUpBegin(transition);
+	aptWakeUpPoll(&cmd, true);
+	aptWakeUpFinish(transition, cmd);
 	return cmd;
 }
 
@@ -836,12 +853,23 @@ void aptSetMessageCallback(aptMessageCb callback, void* user)
 
 void aptLaunchLibraryApplet(NS_APPID appId, void* buf, size_t bufsize, Handle handle)
 {
-	bool sleep = aptIsSleepAllowed();
+	aptLibraryApplet applet;
+	aptLaunchLibraryAppletAsync(&applet, appId, buf, bufsize, handle);
+	aptLibraryAppletWait(&applet);
+}
+
+void aptLaunchLibraryAppletAsync(aptLibraryApplet* applet, NS_APPID appId, void* buf, size_t bufsize, Handle handle)
+{
+	applet->appId = appId;
+	applet->buf = buf;
+	applet->bufsize = bufsize;
+	applet->sleep = aptIsSleepAllowed();
+	applet->running = true;
 
 	aptSetSleepAllowed(false);
 	aptFlags &= ~FLAG_SPURIOUS; // If we haven't received a spurious wakeup by now, we probably never will (see aptInit)
 	APT_PrepareToStartLibraryApplet(appId);
-	aptSetSleepAllowed(sleep);
+	aptSetSleepAllowed(applet->sleep);
 
 	aptCallHook(APTHOOK_ONSUSPEND);
 
@@ -853,9 +881,32 @@ void aptLaunchLibraryApplet(NS_APPID appId, void* buf, size_t bufsize, Handle ha
 	APT_StartLibraryApplet(appId, buf, bufsize, handle);
 	aptFlags &= ~FLAG_ACTIVE;
 
-	aptWaitForWakeUp(TR_LIBAPPLET);
-	memcpy(buf, aptParameters, bufsize);
-	aptSetSleepAllowed(sleep);
+	aptWakeUpBegin(TR_LIBAPPLET);
+}
+
+static bool aptLibraryAppletUpdate(aptLibraryApplet* applet, bool block)
+{
+	APT_Command cmd;
+	if (!applet->running)
+		return true;
+	if (!aptWakeUpPoll(&cmd, block))
+		return false;
+
+	aptWakeUpFinish(TR_LIBAPPLET, cmd);
+	memcpy(applet->buf, aptParameters, applet->bufsize);
+	aptSetSleepAllowed(applet->sleep);
+	applet->running = false;
+	return true;
+}
+
+bool aptLibraryAppletPoll(aptLibraryApplet* applet)
+{
+	return aptLibraryAppletUpdate(applet, false);
+}
+
+void aptLibraryAppletWait(aptLibraryApplet* applet)
+{
+	aptLibraryAppletUpdate(applet, true);
 }
 
 Result APT_GetLockHandle(u16 flags, Handle* lockHandle)
@@ -0,0 +1,380 @@
+#include <stdlib.h>
+#include <string.h>
+#include <3ds/types.h>
+#include <3ds/result.h>
+#include <3ds/svc.h>
+#include <3ds/os.h>
+#include <3ds/synchronization.h>
+#include <3ds/thread.h>
+#include <3ds/services/boss.h>
+
+#define BOSS_SCHEDULER_STACK_SIZE 0x2000
+#define BOSS_SCHED_STATUS_UNKNOWN 0xFF
+
+static bossSchedulerConfig bossSchedConfig;
+static LightLock bossSchedLock = 1;
+static CondVar bossSchedCond;
+static bossScheduledTask *bossSchedTasks;
+static bossScheduledTask *bossSchedCurrent;
+static Handle bossSchedEvents[2]; // Wake-up event, exit event
+static Thread bossSchedThread;
+static void *bossSchedBuffer;
+static u64 bossSchedBudgetTick; // System tick at which the bandwidth budget is available again
+
+static inline u64 bossSchedMsToTicks(u32 ms)
+{
+	return (u64)ms * CPU_TICKS_PER_MSEC;
+}
+
+static inline bool bossSchedFinished(const bossScheduledTask *task)
+{
+	return task->state == BOSSSCHEDSTATE_DONE || task->state == BOSSSCHEDSTATE_FAILED || task->state == BOSSSCHEDSTATE_TIMEDOUT;
+}
+
+static void bossSchedFinish(bossScheduledTask *task, bossScheduledTaskState state, Result result)
+{
+	task->result = result;
+	task->state = state;
+	LightEvent_Signal(&task->done);
+}
+
+static void bossSchedStart(bossScheduledTask *task)
+{
+	Result ret = 0;
+
+	if (task->ctx)
+	{
+		ret = bossSendContextConfig(task->ctx);
+		if (R_SUCCEEDED(ret)) ret = bossRegisterTask(task->taskID, 0, 0);
+	}
+
+	// A task completing before the first poll is only noticed through its status changing
+	task->startStatus = BOSS_SCHED_STATUS_UNKNOWN;
+	if (R_SUCCEEDED(ret) && R_FAILED(bossGetTaskState(task->taskID, 0, &task->startStatus, NULL, NULL)))
+		task->startStatus = BOSS_SCHED_STATUS_UNKNOWN;
+
+	if (R_SUCCEEDED(ret)) ret = bossStartTaskImmediate(task->taskID);
+	if (R_FAILED(ret))
+	{
+		bossSchedFinish(task, BOSSSCHEDSTATE_FAILED, ret);
+		return;
+	}
+
+	task->state = BOSSSCHEDSTATE_RUNNING;
+	task->pollMs = bossSchedConfig.minPollMs;
+	task->nextTick = svcGetSystemTick() + bossSchedMsToTicks(task->pollMs);
+}
+
+static void bossSchedBeginRead(bossScheduledTask *task, u32 size)
+{
+	task->size = size;
+	task->offset = 0;
+	task->state = BOSSSCHEDSTATE_READING;
+	task->nextTick = 0;
+}
+
+static void bossSchedPoll(bossScheduledTask *task)
+{
+	u8 status = 0;
+	Result ret = bossGetTaskState(task->taskID, 0, &status, NULL, NULL);
+
+	if (R_FAILED(ret) || status == BOSSTASKSTATUS_ERROR)
+	{
+		bossSchedFinish(task, BOSSSCHEDSTATE_FAILED, R_FAILED(ret) ? ret : MAKERESULT(RL_PERMANENT, RS_INTERNAL, RM_BOSS, RD_NO_DATA));
+		return;
+	}
+
+	// The task may not have been picked up yet right after starting it, so a stopped task is only treated as
+	// completed once it was seen running, or once its status differs from the one it had before being started.
+	if (status == BOSSTASKSTATUS_STARTED) task->seenStarted = true;
+	bool completed = status != BOSSTASKSTATUS_STARTED &&
+		(task->seenStarted || (task->startStatus != BOSS_SCHED_STATUS_UNKNOWN && status != task->startStatus));
+
+	u32 size = 0;
+	if (!completed && !task->seenStarted && task->pollMs >= bossSchedConfig.maxPollMs)
+	{
+		// The task may also have completed before the first poll without any visible status change,
+		// its content being available tells so. Otherwise its outcome is unknown.
+		if (!task->NsDataId || !task->callback ||
+			R_FAILED(bossGetNsDataHeaderInfo(task->NsDataId, bossNsDataHeaderInfoType_ContentSize, &size, bossNsDataHeaderInfoTypeSize_ContentSize)))
+		{
+			bossSchedFinish(task, BOSSSCHEDSTATE_TIMEDOUT, MAKERESULT(RL_TEMPORARY, RS_NOTFOUND, RM_BOSS, RD_TIMEOUT));
+			return;
+		}
+
+		bossSchedBeginRead(task, size);
+		return;
+	}
+
+	if (!completed)
+	{
+		task->pollMs = task->pollMs*2 > bossSchedConfig.maxPollMs ? bossSchedConfig.maxPollMs : task->pollMs*2;
+		task->nextTick = svcGetSystemTick() + bossSchedMsToTicks(task->pollMs);
+		return;
+	}
+
+	if (!task->NsDataId || !task->callback)
+	{
+		bossSchedFinish(task, BOSSSCHEDSTATE_DONE, 0);
+		return;
+	}
+
+	ret = bossGetNsDataHeaderInfo(task->NsDataId, bossNsDataHeaderInfoType_ContentSize, &size, bossNsDataHeaderInfoTypeSize_ContentSize);
+	if (R_FAILED(ret))
+	{
+		bossSchedFinish(task, BOSSSCHEDSTATE_FAILED, ret);
+		return;
+	}
+
+	bossSchedBeginRead(task, size);
+}
+
+static void bossSchedRead(bossScheduledTask *task)
+{
+	u32 chunk = bossSchedConfig.chunkSize;
+	u32 transferred = 0;
+
+	if (task->size - task->offset < chunk) chunk = task->size - task->offset;
+	if (!chunk)
+	{
+		bossSchedFinish(task, BOSSSCHEDSTATE_DONE, 0);
+		return;
+	}
+
+	// Bandwidth budget: each chunk pushes the next allowed read time forward, the task waits in the
+	// schedule until then so that other tasks can still be polled.
+	if (bossSchedConfig.bytesPerSecond)
+	{
+		u64 now = svcGetSystemTick();
+		if (bossSchedBudgetTick > now)
+		{
+			task->nextTick = bossSchedBudgetTick;
+			return;
+		}
+		bossSchedBudgetTick = now;
+		bossSchedBudgetTick += (u64)chunk * SYSCLOCK_ARM11 / bossSchedConfig.bytesPerSecond;
+	}
+
+	Result ret = bossReadNsData(task->NsDataId, task->offset, bossSchedBuffer, chunk, &transferred, NULL);
+	if (R_SUCCEEDED(ret) && !transferred) ret = MAKERESULT(RL_PERMANENT, RS_INTERNAL, RM_BOSS, RD_NO_DATA);
+	if (R_FAILED(ret))
+	{
+		bossSchedFinish(task, BOSSSCHEDSTATE_FAILED, ret);
+		return;
+	}
+
+	u64 offset = task->offset;
+	task->offset += transferred;
+	if (!task->callback(task, offset, bossSchedBuffer, transferred))
+		bossSchedFinish(task, BOSSSCHEDSTATE_FAILED, MAKERESULT(RL_STATUS, RS_CANCELED, RM_BOSS, RD_CANCEL_REQUESTED));
+	else if (task->offset >= task->size)
+		bossSchedFinish(task, BOSSSCHEDSTATE_DONE, 0);
+}
+
+static void bossSchedThreadMain(void *arg)
+{
+	for (;;)
+	{
+		u64 now = svcGetSystemTick();
+		u64 wakeTick = U64_MAX;
+		bossScheduledTask *task = NULL;
+
+		// Pick the first task that is due, and compute when the next one is
+		LightLock_Lock(&bossSchedLock);
+		for (bossScheduledTask *t = bossSchedTasks; t; t = t->next)
+		{
+			if (bossSchedFinished(t))
+				continue;
+			if (t->nextTick <= now)
+			{
+				task = t;
+				break;
+			}
+			if (t->nextTick < wakeTick) wakeTick = t->nextTick;
+		}
+		bossSchedCurrent = task;
+		LightLock_Unlock(&bossSchedLock);
+
+		if (!task)
+		{
+			s32 index = -1;
+			s64 timeout = wakeTick == U64_MAX ? -1 : (s64)((wakeTick - now) * 1000000 / CPU_TICKS_PER_MSEC);
+			Result ret = svcWaitSynchronizationN(&index, bossSchedEvents, 2, false, timeout);
+			if (R_SUCCEEDED(ret) && index == 1)
+				break;
+			continue;
+		}
+
+		switch (task->state)
+		{
+			case BOSSSCHEDSTATE_PENDING: bossSchedStart(task); break;
+			case BOSSSCHEDSTATE_RUNNING: bossSchedPoll(task); break;
+			case BOSSSCHEDSTATE_READING: bossSchedRead(task); break;
+			default: break;
+		}
+
+		// Move the task to the end of the list so that due tasks are served round-robin
+		LightLock_Lock(&bossSchedLock);
+		bossScheduledTask **pp = &bossSchedTasks;
+		while (*pp && *pp != task) pp = &(*pp)->next;
+		if (*pp && task->next)
+		{
+			*pp = task->next;
+			while (*pp) pp = &(*pp)->next;
+			*pp = task;
+			task->next = NULL;
+		}
+		bossSchedCurrent = NULL;
+		CondVar_Broadcast(&bossSchedCond);
+		LightLock_Unlock(&bossSchedLock);
+
+		// Give the foreground threads a chance to run between IPC requests
+		svcSleepThread(0);
+	}
+}
+
+void bossSchedulerConfigDefault(bossSchedulerConfig *config)
+{
+	config->minPollMs = 250;
+	config->maxPollMs = 8000;
+	config->chunkSize = 0x10000;
+	config->bytesPerSecond = 0;
+	config->priority = -1;
+}
+
+Result bossSchedulerInit(const bossSchedulerConfig *config)
+{
+	if (bossSchedThread) return 0;
+
+	if (config) bossSchedConfig = *config;
+	else bossSchedulerConfigDefault(&bossSchedConfig);
+
+	if (!bossSchedConfig.minPollMs) bossSchedConfig.minPollMs = 1;
+	if (bossSchedConfig.maxPollMs < bossSchedConfig.minPollMs) bossSchedConfig.maxPollMs = bossSchedConfig.minPollMs;
+	if (!bossSchedConfig.chunkSize) bossSchedConfig.chunkSize = 0x10000;
+
+	bossSchedBuffer = malloc(bossSchedConfig.chunkSize);
+	if (!bossSchedBuffer) return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_BOSS, RD_OUT_OF_MEMORY);
+
+	Result ret = svcCreateEvent(&bossSchedEvents[0], RESET_ONESHOT);
+	if (R_SUCCEEDED(ret))
+	{
+		ret = svcCreateEvent(&bossSchedEvents[1], RESET_ONESHOT);
+		if (R_FAILED(ret)) svcCloseHandle(bossSchedEvents[0]);
+	}
+	if (R_FAILED(ret))
+	{
+		free(bossSchedBuffer);
+		bossSchedBuffer = NULL;
+		return ret;
+	}
+
+	s32 prio = bossSchedConfig.priority;
+	if (prio < 0)
+	{
+		prio = 0x30;
+		svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+		if (prio < 0x3F) prio++;
+	}
+
+	bossSchedBudgetTick = 0;
+	bossSchedThread = threadCreate(bossSchedThreadMain, NULL, BOSS_SCHEDULER_STACK_SIZE, prio, -2, false);
+	if (!bossSchedThread)
+	{
+		svcCloseHandle(bossSchedEvents[0]);
+		svcCloseHandle(bossSchedEvents[1]);
+		free(bossSchedBuffer);
+		bossSchedBuffer = NULL;
+		return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_BOSS, RD_OUT_OF_MEMORY);
+	}
+
+	return 0;
+}
+
+void bossSchedulerExit(void)
+{
+	if (!bossSchedThread) return;
+
+	svcSignalEvent(bossSchedEvents[1]);
+	threadJoin(bossSchedThread, U64_MAX);
+	threadFree(bossSchedThread);
+	bossSchedThread = NULL;
+
+	svcCloseHandle(bossSchedEvents[0]);
+	svcCloseHandle(bossSchedEvents[1]);
+	free(bossSchedBuffer);
+	bossSchedBuffer = NULL;
+
+	// Nothing will complete the remaining tasks anymore, so their waiters are released
+	LightLock_Lock(&bossSchedLock);
+	bossScheduledTask *task = bossSchedTasks;
+	bossSchedTasks = NULL;
+	LightLock_Unlock(&bossSchedLock);
+
+	while (task)
+	{
+		bossScheduledTask *next = task->next;
+		task->next = NULL;
+		if (!bossSchedFinished(task))
+			bossSchedFinish(task, BOSSSCHEDSTATE_FAILED, MAKERESULT(RL_STATUS, RS_CANCELED, RM_BOSS, RD_CANCEL_REQUESTED));
+		task = next;
+	}
+}
+
+Result bossSchedulerAdd(bossScheduledTask *task, const char *taskID, bossContext *ctx, u32 NsDataId, bossNsDataCallback callback, void *user)
+{
+	if (!bossSchedThread) return MAKERESULT(RL_USAGE, RS_INVALIDSTATE, RM_BOSS, RD_NOT_INITIALIZED);
+	if (!taskID || strlen(taskID) >= sizeof(task->taskID) || (NsDataId && !callback))
+		return MAKERESULT(RL_USAGE, RS_INVALIDARG, RM_BOSS, RD_INVALID_COMBINATION);
+
+	LightLock_Lock(&bossSchedLock);
+
+	// The task is only initialized once it's known not to be in use, its fields can't be trusted before
+	for (bossScheduledTask *t = bossSchedTasks; t; t = t->next)
+	{
+		if (t != task)
+			continue;
+		LightLock_Unlock(&bossSchedLock);
+		return MAKERESULT(RL_USAGE, RS_INVALIDSTATE, RM_BOSS, RD_ALREADY_EXISTS);
+	}
+
+	memset(task, 0, sizeof(*task));
+	strncpy(task->taskID, taskID, sizeof(task->taskID)-1);
+	task->ctx = ctx;
+	task->NsDataId = NsDataId;
+	task->callback = callback;
+	task->user = user;
+	task->state = BOSSSCHEDSTATE_PENDING;
+	LightEvent_Init(&task->done, RESET_STICKY);
+
+	task->next = bossSchedTasks;
+	bossSchedTasks = task;
+	LightLock_Unlock(&bossSchedLock);
+
+	svcSignalEvent(bossSchedEvents[0]);
+	return 0;
+}
+
+void bossSchedulerRemove(bossScheduledTask *task)
+{
+	bool found = false;
+
+	LightLock_Lock(&bossSchedLock);
+	while (bossSchedCurrent == task)
+		CondVar_Wait(&bossSchedCond, &bossSchedLock);
+
+	for (bossScheduledTask **pp = &bossSchedTasks; *pp; pp = &(*pp)->next)
+	{
+		if (*pp != task)
+			continue;
+		*pp = task->next;
+		task->next = NULL;
+		found = true;
+		break;
+	}
+	LightLock_Unlock(&bossSchedLock);
+
+	// Nothing will complete the task anymore, so its waiters are released (as in bossSchedulerExit)
+	if (found && !bossSchedFinished(task))
+		bossSchedFinish(task, BOSSSCHEDSTATE_FAILED, MAKERESULT(RL_STATUS, RS_CANCELED, RM_BOSS, RD_CANCEL_REQUESTED));
+}
@@ -1,6 +1,8 @@
+#include <stdlib.h>
 #include <string.h>
 #include <3ds/types.h>
 #include <3ds/svc.h>
+#include <3ds/thread.h>
 #include <3ds/synchronization.h>
 #include <3ds/ipc.h>
 #include <3ds/result.h>
@@ -486,3 +488,231 @@ Result FRD_RemoveFriend(u32 principalId, u64 localFriendCode)
 
 	return cmdbuf[1];
 }
+
+Result FRD_GetRoster(FriendRoster *roster, u32 attributes)
+{
+	FriendKey keys[FRIEND_LIST_SIZE];
+	u32 count = 0;
+
+	memset(roster, 0, sizeof(*roster));
+
+	Result ret = FRD_GetFriendKeyList(keys, &count, 0, FRIEND_LIST_SIZE);
+	if (R_FAILED(ret)) return ret;
+	if (count > FRIEND_LIST_SIZE) count = FRIEND_LIST_SIZE;
+
+	// Lay out all the arrays in a single allocation
+	size_t size = count * sizeof(FriendKey);
+	size_t profilesOffset = size;
+	if (attributes & FRIEND_ROSTER_PROFILE) size += (count * sizeof(FriendProfile) + 7) &~ 7;
+	size_t miisOffset = size;
+	if (attributes & FRIEND_ROSTER_MII) size += (count * sizeof(MiiData) + 7) &~ 7;
+	size_t playingOffset = size;
+	if (attributes & FRIEND_ROSTER_PLAYING) size += count * sizeof(GameDescription);
+
+	u8 *arena = (u8*)malloc(size ? size : 1);
+	if (!arena) return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+	roster->arena = arena;
+	roster->count = count;
+	roster->attributes = attributes;
+	roster->keys = (FriendKey*)arena;
+	memcpy(roster->keys, keys, count * sizeof(FriendKey));
+
+	if (attributes & FRIEND_ROSTER_PROFILE)
+		roster->profiles = (FriendProfile*)(arena + profilesOffset);
+	if (attributes & FRIEND_ROSTER_MII)
+		roster->miis = (MiiData*)(arena + miisOffset);
+	if (attributes & FRIEND_ROSTER_PLAYING)
+		roster->playing = (GameDescription*)(arena + playingOffset);
+
+	if (count)
+	{
+		if (R_SUCCEEDED(ret) && roster->profiles)
+			ret = FRD_GetFriendProfile(roster->profiles, roster->keys, count);
+		if (R_SUCCEEDED(ret) && roster->miis)
+			ret = FRD_GetFriendMii(roster->miis, roster->keys, count);
+		if (R_SUCCEEDED(ret) && roster->playing)
+			ret = FRD_GetFriendPlayingGame(roster->playing, roster->keys, count);
+	}
+
+	if (R_FAILED(ret))
+		FRD_FreeRoster(roster);
+	return ret;
+}
+
+void FRD_FreeRoster(FriendRoster *roster)
+{
+	free(roster->arena);
+	memset(roster, 0, sizeof(*roster));
+}
+
+#define FRD_ROSTER_STACK_SIZE 0x2000
+#define FRD_ROSTER_MAX_EVENTS 16
+
+static FriendRoster frdRoster;
+static LightLock frdRosterLock = 1;
+static u32 frdRosterGeneration;
+static u32 frdRosterAttributes;
+static Handle frdRosterEvents[2]; // Notification event, exit event
+static Thread frdRosterThread;
+
+// Refreshes the given attributes of a cached friend, returns false if the friend isn't in the cache
+static bool frdRosterRefreshFriend(const FriendKey *key, u32 attributes)
+{
+	FriendProfile profile;
+	MiiData mii;
+	GameDescription playing;
+	Result ret = 0;
+
+	attributes &= frdRosterAttributes;
+	if (attributes & FRIEND_ROSTER_PROFILE) ret = FRD_GetFriendProfile(&profile, key, 1);
+	if (R_SUCCEEDED(ret) && (attributes & FRIEND_ROSTER_MII)) ret = FRD_GetFriendMii(&mii, key, 1);
+	if (R_SUCCEEDED(ret) && (attributes & FRIEND_ROSTER_PLAYING)) ret = FRD_GetFriendPlayingGame(&playing, key, 1);
+	if (R_FAILED(ret)) return false;
+
+	bool found = false;
+	LightLock_Lock(&frdRosterLock);
+	for (u32 i = 0; i < frdRoster.count; i ++)
+	{
+		if (frdRoster.keys[i].principalId != key->principalId)
+			continue;
+		if (attributes & FRIEND_ROSTER_PROFILE) frdRoster.profiles[i] = profile;
+		if (attributes & FRIEND_ROSTER_MII) frdRoster.miis[i] = mii;
+		if (attributes & FRIEND_ROSTER_PLAYING) frdRoster.playing[i] = playing;
+		frdRosterGeneration++;
+		found = true;
+		break;
+	}
+	LightLock_Unlock(&frdRosterLock);
+	return found;
+}
+
+static void frdRosterRefreshAll(void)
+{
+	FriendRoster roster, old;
+	if (R_FAILED(FRD_GetRoster(&roster, frdRosterAttributes)))
+		return;
+
+	LightLock_Lock(&frdRosterLock);
+	old = frdRoster;
+	frdRoster = roster;
+	frdRosterGeneration++;
+	LightLock_Unlock(&frdRosterLock);
+
+	FRD_FreeRoster(&old);
+}
+
+static void frdRosterThreadMain(void *arg)
+{
+	NotificationEvent events[FRD_ROSTER_MAX_EVENTS];
+
+	for (;;)
+	{
+		s32 index = -1;
+		if (R_FAILED(svcWaitSynchronizationN(&index, frdRosterEvents, 2, false, U64_MAX)) || index != 0)
+			break;
+
+		u32 num = 0;
+		do
+		{
+			if (R_FAILED(FRD_GetEventNotification(events, FRD_ROSTER_MAX_EVENTS, &num)))
+				break;
+
+			bool refreshAll = false;
+			for (u32 i = 0; i < num && !refreshAll; i ++)
+			{
+				u32 attributes = 0;
+				switch (events[i].type)
+				{
+					case FRIEND_WENT_ONLINE:
+					case FRIEND_UPDATED_PRESENCE:
+					case FRIEND_WENT_OFFLINE:
+						attributes = FRIEND_ROSTER_PLAYING;
+						break;
+					case FRIEND_UPDATED_MII:
+						attributes = FRIEND_ROSTER_MII;
+						break;
+					case FRIEND_UPDATED_PROFILE:
+						attributes = FRIEND_ROSTER_PROFILE;
+						break;
+					case FRIEND_REGISTERED_USER:
+						refreshAll = true; // The friend list itself changed
+						break;
+					default:
+						break;
+				}
+
+				if (attributes && !frdRosterRefreshFriend(&events[i].key, attributes))
+					refreshAll = true;
+			}
+
+			if (refreshAll)
+				frdRosterRefreshAll();
+		} while (num == FRD_ROSTER_MAX_EVENTS);
+	}
+}
+
+Result frdRosterCacheInit(u32 attributes)
+{
+	if (frdRosterThread) return 0;
+
+	frdRosterAttributes = attributes;
+
+	Result ret = FRD_GetRoster(&frdRoster, attributes);
+	if (R_FAILED(ret)) return ret;
+
+	ret = svcCreateEvent(&frdRosterEvents[0], RESET_ONESHOT);
+	if (R_SUCCEEDED(ret))
+	{
+		ret = svcCreateEvent(&frdRosterEvents[1], RESET_ONESHOT);
+		if (R_FAILED(ret)) svcCloseHandle(frdRosterEvents[0]);
+	}
+	if (R_FAILED(ret))
+	{
+		FRD_FreeRoster(&frdRoster);
+		return ret;
+	}
+
+	ret = FRD_AttachToEventNotification(frdRosterEvents[0]);
+	if (R_SUCCEEDED(ret))
+	{
+		s32 prio = 0x30;
+		svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+		frdRosterThread = threadCreate(frdRosterThreadMain, NULL, FRD_ROSTER_STACK_SIZE, prio, -2, false);
+		if (!frdRosterThread) ret = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+	}
+
+	if (R_FAILED(ret))
+	{
+		svcCloseHandle(frdRosterEvents[0]);
+		svcCloseHandle(frdRosterEvents[1]);
+		FRD_FreeRoster(&frdRoster);
+	}
+	return ret;
+}
+
+void frdRosterCacheExit(void)
+{
+	if (!frdRosterThread) return;
+
+	svcSignalEvent(frdRosterEvents[1]);
+	threadJoin(frdRosterThread, U64_MAX);
+	threadFree(frdRosterThread);
+	frdRosterThread = NULL;
+
+	svcCloseHandle(frdRosterEvents[0]);
+	svcCloseHandle(frdRosterEvents[1]);
+	FRD_FreeRoster(&frdRoster);
+}
+
+const FriendRoster* frdRosterCacheLock(u32 *generation)
+{
+	LightLock_Lock(&frdRosterLock);
+	if (generation) *generation = frdRosterGeneration;
+	return &frdRoster;
+}
+
+void frdRosterCacheUnlock(void)
+{
+	LightLock_Unlock(&frdRosterLock);
+}
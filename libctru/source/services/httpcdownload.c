@@ -0,0 +1,408 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <3ds/types.h>
+#include <3ds/result.h>
+#include <3ds/svc.h>
+#include <3ds/os.h>
+#include <3ds/thread.h>
+#include <3ds/synchronization.h>
+#include <3ds/services/fs.h>
+#include <3ds/services/sslc.h>
+#include <3ds/services/httpc.h>
+
+#define DOWNLOAD_BUFFER_SIZE   0x10000
+#define DOWNLOAD_STACK_SIZE    0x4000
+#define JOURNAL_MAGIC          0x4A4C4448 // "HDLJ"
+#define JOURNAL_UPDATE_INTERVAL 0x100000
+
+typedef struct
+{
+	u32 magic;
+	u32 numSegments;
+	u64 size;
+	char etag[64];
+} httpcJournalHeader;
+
+static FS_Path httpcJournalPath(const httpcDownload* dl, char* buf, size_t size)
+{
+	snprintf(buf, size, "%s.dlj", dl->path);
+	return fsMakePath(PATH_ASCII, buf);
+}
+
+static Result httpcJournalWriteSegment(httpcDownload* dl, u32 index)
+{
+	httpcDownloadSegment seg;
+	u32 written;
+
+	LightLock_Lock(&dl->lock);
+	seg = dl->segments[index];
+	LightLock_Unlock(&dl->lock);
+
+	return FSFILE_Write(dl->journal, &written, sizeof(httpcJournalHeader) + index*sizeof(seg), &seg, sizeof(seg), FS_WRITE_FLUSH);
+}
+
+static Result httpcJournalCreate(httpcDownload* dl)
+{
+	httpcJournalHeader hdr;
+	u32 written;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = JOURNAL_MAGIC;
+	hdr.numSegments = dl->numSegments;
+	hdr.size = dl->size;
+	memcpy(hdr.etag, dl->etag, sizeof(hdr.etag));
+
+	Result ret = FSFILE_SetSize(dl->journal, sizeof(hdr) + dl->numSegments*sizeof(httpcDownloadSegment));
+	if (R_SUCCEEDED(ret))
+		ret = FSFILE_Write(dl->journal, &written, 0, &hdr, sizeof(hdr), 0);
+	if (R_SUCCEEDED(ret))
+		ret = FSFILE_Write(dl->journal, &written, sizeof(hdr), dl->segments, dl->numSegments*sizeof(httpcDownloadSegment), FS_WRITE_FLUSH);
+	return ret;
+}
+
+// Loads the segments from the journal, returns false if it doesn't match the resource
+static bool httpcJournalLoad(httpcDownload* dl)
+{
+	httpcJournalHeader hdr;
+	u32 read;
+
+	if (R_FAILED(FSFILE_Read(dl->journal, &read, 0, &hdr, sizeof(hdr))) || read != sizeof(hdr))
+		return false;
+	if (hdr.magic != JOURNAL_MAGIC || hdr.size != dl->size || hdr.numSegments == 0 || hdr.numSegments > HTTPC_DOWNLOAD_MAX_SEGMENTS)
+		return false;
+	if (strncmp(hdr.etag, dl->etag, sizeof(hdr.etag)) != 0)
+		return false;
+
+	u32 segSize = hdr.numSegments*sizeof(httpcDownloadSegment);
+	if (R_FAILED(FSFILE_Read(dl->journal, &read, sizeof(hdr), dl->segments, segSize)) || read != segSize)
+		return false;
+
+	for (u32 i = 0; i < hdr.numSegments; i ++)
+	{
+		httpcDownloadSegment* seg = &dl->segments[i];
+		if (seg->start > seg->end || seg->end > dl->size || seg->done > seg->end - seg->start)
+			return false;
+	}
+
+	dl->numSegments = hdr.numSegments;
+	return true;
+}
+
+// Opens a GET request for a byte range (end == 0 for the whole resource)
+static Result httpcOpenRange(httpcDownload* dl, httpcContext* context, u64 start, u64 end, u32* status)
+{
+	char range[48];
+
+	Result ret = httpcOpenContext(context, HTTPC_METHOD_GET, dl->url, 1);
+	if (R_FAILED(ret))
+		return ret;
+
+	if (dl->sslOpts)
+		ret = httpcSetSSLOpt(context, dl->sslOpts);
+	if (R_SUCCEEDED(ret))
+		ret = httpcSetKeepAlive(context, HTTPC_KEEPALIVE_ENABLED);
+	if (R_SUCCEEDED(ret) && end)
+	{
+		snprintf(range, sizeof(range), "bytes=%llu-%llu", (unsigned long long)start, (unsigned long long)(end-1));
+		ret = httpcAddRequestHeaderField(context, "Range", range);
+	}
+	if (R_SUCCEEDED(ret))
+		ret = httpcBeginRequest(context);
+	if (R_SUCCEEDED(ret))
+		ret = httpcGetResponseStatusCode(context, status);
+
+	if (R_FAILED(ret))
+		httpcCloseContext(context);
+	return ret;
+}
+
+static void httpcCloseRange(httpcContext* context, bool complete)
+{
+	// Closing a context hangs if its content wasn't entirely downloaded
+	if (!complete)
+		httpcCancelConnection(context);
+	httpcCloseContext(context);
+}
+
+static void httpcSegmentFail(httpcDownload* dl, Result ret)
+{
+	LightLock_Lock(&dl->lock);
+	if (R_SUCCEEDED(dl->result))
+		dl->result = ret;
+	LightLock_Unlock(&dl->lock);
+	dl->cancel = true;
+}
+
+static void httpcSegmentThread(void* arg)
+{
+	httpcDownloadThreadArgs* args = (httpcDownloadThreadArgs*)arg;
+	httpcDownload* dl = args->dl;
+	httpcDownloadSegment* seg = &dl->segments[args->index];
+	httpcContext context;
+	u32 status = 0;
+	bool ranged = dl->numSegments > 1 || seg->done;
+
+	u8* buf = (u8*)malloc(DOWNLOAD_BUFFER_SIZE);
+	if (!buf)
+	{
+		httpcSegmentFail(dl, MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY));
+		return;
+	}
+
+	u64 offset = seg->start + seg->done;
+	Result ret = httpcOpenRange(dl, &context, offset, ranged ? seg->end : 0, &status);
+	if (R_SUCCEEDED(ret) && status != (ranged ? 206 : 200))
+	{
+		httpcCloseRange(&context, false);
+		ret = MAKERESULT(RL_PERMANENT, RS_NOTSUPPORTED, RM_APPLICATION, RD_NOT_IMPLEMENTED);
+	}
+	if (R_FAILED(ret))
+	{
+		free(buf);
+		httpcSegmentFail(dl, ret);
+		return;
+	}
+
+	u64 lastJournal = seg->done;
+	Result dlret = HTTPC_RESULTCODE_DOWNLOADPENDING;
+	while (dlret == (Result)HTTPC_RESULTCODE_DOWNLOADPENDING && offset < seg->end && !dl->cancel)
+	{
+		u32 size = 0, written = 0;
+		dlret = httpcDownloadData(&context, buf, DOWNLOAD_BUFFER_SIZE, &size);
+		if (R_FAILED(dlret) && dlret != (Result)HTTPC_RESULTCODE_DOWNLOADPENDING)
+			break;
+
+		if (size > seg->end - offset)
+			size = seg->end - offset;
+		if (!size)
+			continue;
+
+		ret = FSFILE_Write(dl->file, &written, offset, buf, size, 0);
+		if (R_FAILED(ret))
+			break;
+
+		offset += size;
+		LightLock_Lock(&dl->lock);
+		seg->done += size;
+		dl->sessionBytes += size;
+		LightLock_Unlock(&dl->lock);
+
+		if (seg->done - lastJournal >= JOURNAL_UPDATE_INTERVAL)
+		{
+			// The data must reach the file before the journal records it
+			ret = FSFILE_Flush(dl->file);
+			if (R_SUCCEEDED(ret))
+				ret = httpcJournalWriteSegment(dl, args->index);
+			if (R_FAILED(ret))
+				break;
+			lastJournal = seg->done;
+		}
+	}
+
+	bool complete = (offset >= seg->end || dl->streaming) && dlret != (Result)HTTPC_RESULTCODE_DOWNLOADPENDING;
+	httpcCloseRange(&context, complete);
+	free(buf);
+
+	if (R_SUCCEEDED(ret) && R_FAILED(dlret) && dlret != (Result)HTTPC_RESULTCODE_DOWNLOADPENDING)
+		ret = dlret;
+	if (R_SUCCEEDED(ret) && !dl->cancel && offset < seg->end)
+	{
+		if (!dl->streaming)
+			ret = MAKERESULT(RL_PERMANENT, RS_INVALIDSTATE, RM_APPLICATION, RD_NO_DATA); // Connection closed early
+		else
+		{
+			// The end of the stream gives the size of the resource
+			LightLock_Lock(&dl->lock);
+			seg->end = offset;
+			dl->size = offset;
+			LightLock_Unlock(&dl->lock);
+		}
+	}
+
+	if (R_SUCCEEDED(FSFILE_Flush(dl->file)))
+		httpcJournalWriteSegment(dl, args->index);
+	if (R_FAILED(ret))
+		httpcSegmentFail(dl, ret);
+}
+
+// Gets the size and ETag of the resource, and whether the server supports range requests
+static Result httpcDownloadProbe(httpcDownload* dl, bool* ranges)
+{
+	httpcContext context;
+	char value[64];
+	u32 status = 0;
+
+	Result ret = httpcOpenRange(dl, &context, 0, 1, &status);
+	if (R_FAILED(ret))
+		return ret;
+
+	dl->etag[0] = 0;
+	httpcGetResponseHeader(&context, "ETag", dl->etag, sizeof(dl->etag));
+
+	*ranges = false;
+	if (status == 206 && R_SUCCEEDED(httpcGetResponseHeader(&context, "Content-Range", value, sizeof(value))))
+	{
+		const char* total = strchr(value, '/');
+		if (total && total[1] != '*')
+		{
+			dl->size = strtoull(total+1, NULL, 10);
+			*ranges = true;
+		}
+	}
+
+	dl->streaming = false;
+	if (!*ranges)
+	{
+		u32 contentsize = 0;
+		if (status != 200 && status != 206)
+			ret = MAKERESULT(RL_PERMANENT, RS_NOTFOUND, RM_APPLICATION, RD_NOT_FOUND);
+		else if (status == 200)
+			ret = httpcGetDownloadSizeState(&context, NULL, &contentsize);
+		dl->size = contentsize;
+
+		// Without a Content-Length (e.g. chunked responses) or a total in the Content-Range, the size of the
+		// resource is only known once it has been entirely received
+		dl->streaming = R_SUCCEEDED(ret) && !contentsize;
+	}
+
+	httpcCloseRange(&context, false);
+	return ret;
+}
+
+Result httpcDownloadStart(httpcDownload* dl, const char* url, FS_Archive archive, const char* path, u32 numSegments, u32 sslOpts)
+{
+	char journalPath[0x110];
+	bool ranges;
+
+	if (!numSegments || numSegments > HTTPC_DOWNLOAD_MAX_SEGMENTS || strlen(path) >= sizeof(dl->path))
+		return MAKERESULT(RL_USAGE, RS_INVALIDARG, RM_APPLICATION, RD_INVALID_SELECTION);
+
+	memset(dl, 0, sizeof(*dl));
+	dl->url = url;
+	dl->sslOpts = sslOpts;
+	dl->archive = archive;
+	strcpy(dl->path, path);
+	LightLock_Init(&dl->lock);
+
+	Result ret = httpcDownloadProbe(dl, &ranges);
+	if (R_FAILED(ret))
+		return ret;
+
+	// Tiny resources (and servers without range support) are downloaded with a single request
+	if (!ranges)
+		numSegments = 1;
+	else if (dl->size < numSegments*(u64)DOWNLOAD_BUFFER_SIZE)
+		numSegments = dl->size ? (dl->size + DOWNLOAD_BUFFER_SIZE - 1) / DOWNLOAD_BUFFER_SIZE : 1;
+
+	ret = FSUSER_OpenFile(&dl->journal, archive, httpcJournalPath(dl, journalPath, sizeof(journalPath)), FS_OPEN_READ | FS_OPEN_WRITE | FS_OPEN_CREATE, 0);
+	if (R_FAILED(ret))
+		return ret;
+
+	ret = FSUSER_OpenFile(&dl->file, archive, fsMakePath(PATH_ASCII, dl->path), FS_OPEN_READ | FS_OPEN_WRITE | FS_OPEN_CREATE, 0);
+	if (R_FAILED(ret))
+	{
+		FSFILE_Close(dl->journal);
+		return ret;
+	}
+
+	bool resumed = ranges && httpcJournalLoad(dl);
+	if (!resumed)
+	{
+		dl->numSegments = numSegments;
+		u64 segSize = dl->size / numSegments;
+		for (u32 i = 0; i < numSegments; i ++)
+		{
+			dl->segments[i].start = i*segSize;
+			dl->segments[i].end = i == numSegments-1 ? dl->size : (i+1)*segSize;
+			dl->segments[i].done = 0;
+		}
+		if (dl->streaming)
+			dl->segments[0].end = U64_MAX;
+
+		// Preallocate the file so that each range can be written at its offset
+		ret = FSFILE_SetSize(dl->file, dl->size);
+		if (R_SUCCEEDED(ret))
+			ret = httpcJournalCreate(dl);
+		if (R_FAILED(ret))
+		{
+			FSFILE_Close(dl->file);
+			FSFILE_Close(dl->journal);
+			return ret;
+		}
+	}
+
+	s32 prio = 0x30;
+	svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+
+	dl->startTick = svcGetSystemTick();
+	for (u32 i = 0; i < dl->numSegments; i ++)
+	{
+		httpcDownloadSegment* seg = &dl->segments[i];
+		if (seg->start + seg->done >= seg->end)
+			continue;
+
+		httpcDownloadThreadArgs* args = &dl->threadArgs[i];
+		args->dl = dl;
+		args->index = i;
+
+		dl->threads[i] = threadCreate(httpcSegmentThread, args, DOWNLOAD_STACK_SIZE, prio, -2, false);
+		if (!dl->threads[i])
+		{
+			httpcSegmentFail(dl, MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY));
+			break;
+		}
+	}
+
+	return 0;
+}
+
+Result httpcDownloadWait(httpcDownload* dl)
+{
+	char journalPath[0x110];
+
+	for (u32 i = 0; i < dl->numSegments; i ++)
+	{
+		if (!dl->threads[i])
+			continue;
+		threadJoin(dl->threads[i], U64_MAX);
+		threadFree(dl->threads[i]);
+		dl->threads[i] = NULL;
+	}
+
+	FSFILE_Close(dl->file);
+	FSFILE_Close(dl->journal);
+
+	Result ret = dl->result;
+	if (R_SUCCEEDED(ret) && dl->cancel)
+		ret = MAKERESULT(RL_STATUS, RS_CANCELED, RM_APPLICATION, RD_CANCEL_REQUESTED);
+	if (R_SUCCEEDED(ret))
+		FSUSER_DeleteFile(dl->archive, httpcJournalPath(dl, journalPath, sizeof(journalPath)));
+	return ret;
+}
+
+void httpcDownloadCancel(httpcDownload* dl)
+{
+	dl->cancel = true;
+}
+
+u32 httpcDownloadGetProgress(httpcDownload* dl, u64* downloaded, u64* total)
+{
+	u64 done = 0, sessionBytes;
+
+	LightLock_Lock(&dl->lock);
+	for (u32 i = 0; i < dl->numSegments; i ++)
+		done += dl->segments[i].done;
+	sessionBytes = dl->sessionBytes;
+	LightLock_Unlock(&dl->lock);
+
+	if (downloaded)
+		*downloaded = done;
+	if (total)
+		*total = dl->size;
+
+	u64 elapsed = svcGetSystemTick() - dl->startTick;
+	if (!elapsed)
+		return 0;
+	return (u32)(sessionBytes * (u64)SYSCLOCK_ARM11 / elapsed);
+}
@@ -4,6 +4,8 @@
 #include <3ds/svc.h>
 #include <3ds/srv.h>
 #include <3ds/synchronization.h>
+#include <3ds/os.h>
+#include <3ds/thread.h>
 #include <3ds/services/nfc.h>
 #include <3ds/services/apt.h>
 #include <3ds/ipc.h>
@@ -24,6 +26,8 @@ static Result NFC_CommunicationGetResult(Result *out);
 static Result NFC_StartTagScanning(u16 unknown);
 static Result NFC_StartOtherTagScanning(u16 unk0, u32 unk1);
 static Result NFC_StopTagScanning(void);
+static Result NFC_GetTagInRangeEvent(Handle *out);
+static Result NFC_GetTagOutOfRangeEvent(Handle *out);
 
 static Result NFC_InitializeWriteAppData(u32 amiibo_appid, NFC_AppDataInitStruct *initstruct, const void *buf, size_t size);
 static Result NFC_GetAppDataInitStruct(NFC_AppDataInitStruct *out);
@@ -70,6 +74,7 @@ static Result NFC_StartCommsAdapter(void)
 	Result ret, ret2;
 	bool new3ds_flag = false;
 	u8 status;
+	u32 delay_ms = 5;
 
 	APT_CheckNew3DS(&new3ds_flag);
 
@@ -86,7 +91,9 @@ static Result NFC_StartCommsAdapter(void)
 
 		if(status==1)//"Attempting to initialize Old3DS NFC adapter communication."
 		{
-			svcSleepThread(1000000*100);
+			// There is no completion event for this, back off from 5ms up to 100ms between polls.
+			svcSleepThread(1000000ULL*delay_ms);
+			if(delay_ms < 100)delay_ms = delay_ms*2 > 100 ? 100 : delay_ms*2;
 			continue;
 		}
 		else if(status==2)//"Old3DS NFC adapter communication initialization successfully finished."
@@ -216,6 +223,36 @@ static Result NFC_StopTagScanning(void)
 	return ret;
 }
 
+static Result NFC_GetTagInRangeEvent(Handle *out)
+{
+	Result ret=0;
+	u32* cmdbuf=getThreadCommandBuffer();
+
+	cmdbuf[0]=IPC_MakeHeader(0xB,0,0); // 0xB0000
+
+	if(R_FAILED(ret = svcSendSyncRequest(nfcHandle)))return ret;
+	ret = cmdbuf[1];
+
+	if(R_SUCCEEDED(ret) && out)*out = cmdbuf[3];
+
+	return ret;
+}
+
+static Result NFC_GetTagOutOfRangeEvent(Handle *out)
+{
+	Result ret=0;
+	u32* cmdbuf=getThreadCommandBuffer();
+
+	cmdbuf[0]=IPC_MakeHeader(0xC,0,0); // 0xC0000
+
+	if(R_FAILED(ret = svcSendSyncRequest(nfcHandle)))return ret;
+	ret = cmdbuf[1];
+
+	if(R_SUCCEEDED(ret) && out)*out = cmdbuf[3];
+
+	return ret;
+}
+
 Result nfcLoadAmiiboData(void)
 {
 	Result ret=0;
@@ -247,6 +284,8 @@ Result nfcUpdateStoredAmiiboData(void)
 	Result ret=0;
 	u32* cmdbuf=getThreadCommandBuffer();
 
+	nfcTagReaderFlushCache();
+
 	cmdbuf[0]=IPC_MakeHeader(0x9,0,2); // 0x90002
 	cmdbuf[1]=IPC_Desc_CurProcessId();
 
@@ -335,6 +374,8 @@ Result nfcInitializeWriteAppData(u32 amiibo_appid, const void *buf, size_t size)
 	Result ret=0;
 	NFC_AppDataInitStruct initstruct;
 
+	nfcTagReaderFlushCache();
+
 	ret = NFC_GetAppDataInitStruct(&initstruct);
 	if(R_FAILED(ret))return ret;
 
@@ -400,6 +441,8 @@ Result nfcWriteAppData(const void *buf, size_t size, NFC_TagInfo *taginfo)
 	if(taginfo==NULL)return -1;
 	if(taginfo->id_offset_size>10)return -2;
 
+	nfcTagReaderFlushCache();
+
 	memset(&writestruct, 0, sizeof(NFC_AppDataWriteStruct));
 	writestruct.id_size = taginfo->id_offset_size;
 	memcpy(writestruct.id, taginfo->id, sizeof(writestruct.id));
@@ -532,3 +575,209 @@ Result nfcCmd22(void)
 	return ret;
 }
 
+
+#define NFC_READER_STACK_SIZE 0x2000
+#define NFC_READER_CACHE_SIZE 8
+#define NFC_READER_POLL_MS 50
+
+static Thread nfcReaderThread;
+static Handle nfcReaderExitEvent;
+static Handle nfcReaderInRangeEvent, nfcReaderOutOfRangeEvent; // 0 when unavailable, the state is then polled
+static nfcTagReaderCallback nfcReaderCallback;
+static void *nfcReaderUser;
+static u16 nfcReaderInval;
+static u32 nfcReaderAppId;
+static u32 nfcReaderDebounceMs;
+static NFC_TagRecord nfcReaderRecord;
+
+static LightLock nfcReaderCacheLock = 1;
+static NFC_TagRecord nfcReaderCache[NFC_READER_CACHE_SIZE];
+static u32 nfcReaderCacheStamps[NFC_READER_CACHE_SIZE]; // 0 = unused entry
+static u32 nfcReaderCacheClock;
+
+static bool nfcReaderCacheLookup(NFC_TagRecord *rec)
+{
+	bool found = false;
+
+	LightLock_Lock(&nfcReaderCacheLock);
+	for (u32 i = 0; i < NFC_READER_CACHE_SIZE; i ++)
+	{
+		if (!nfcReaderCacheStamps[i] || memcmp(&nfcReaderCache[i].info, &rec->info, sizeof(NFC_TagInfo)) != 0)
+			continue;
+		*rec = nfcReaderCache[i];
+		rec->cached = true;
+		nfcReaderCacheStamps[i] = ++nfcReaderCacheClock;
+		found = true;
+		break;
+	}
+	LightLock_Unlock(&nfcReaderCacheLock);
+	return found;
+}
+
+static void nfcReaderCacheInsert(const NFC_TagRecord *rec)
+{
+	u32 victim = 0;
+
+	LightLock_Lock(&nfcReaderCacheLock);
+	for (u32 i = 1; i < NFC_READER_CACHE_SIZE; i ++)
+		if (nfcReaderCacheStamps[i] < nfcReaderCacheStamps[victim])
+			victim = i;
+	nfcReaderCache[victim] = *rec;
+	nfcReaderCacheStamps[victim] = ++nfcReaderCacheClock;
+	LightLock_Unlock(&nfcReaderCacheLock);
+}
+
+void nfcTagReaderFlushCache(void)
+{
+	LightLock_Lock(&nfcReaderCacheLock);
+	memset(nfcReaderCacheStamps, 0, sizeof(nfcReaderCacheStamps));
+	LightLock_Unlock(&nfcReaderCacheLock);
+}
+
+// Waits until the tag state becomes the specified one. Returns 1 when it did, 0 on timeout and -1 on error or when the reader is stopped.
+static int nfcReaderWaitState(Handle event, NFC_TagState state, s32 timeout_ms)
+{
+	Handle handles[2] = { nfcReaderExitEvent, event };
+	u64 start = svcGetSystemTick();
+	NFC_TagState cur;
+	s32 index;
+
+	for (;;)
+	{
+		// Clear the event before checking the state so that a change in between isn't missed
+		if (event) svcClearEvent(event);
+		if (R_FAILED(nfcGetTagState(&cur))) return -1;
+		if (cur == state) return 1;
+
+		s64 timeout = -1;
+		if (timeout_ms >= 0)
+		{
+			u64 elapsed = (svcGetSystemTick() - start) / CPU_TICKS_PER_MSEC;
+			if (elapsed >= (u64)timeout_ms) return 0;
+			timeout = (s64)(timeout_ms - elapsed) * 1000000;
+		}
+		if (!event && (timeout < 0 || timeout > NFC_READER_POLL_MS * 1000000LL))
+			timeout = NFC_READER_POLL_MS * 1000000LL;
+
+		index = -1;
+		Result ret = svcWaitSynchronizationN(&index, handles, event ? 2 : 1, false, timeout);
+		if (R_FAILED(ret) && R_DESCRIPTION(ret) != RD_TIMEOUT) return -1;
+		if (R_SUCCEEDED(ret) && index == 0) return -1;
+	}
+}
+
+static void nfcReaderReadTag(NFC_TagRecord *rec)
+{
+	memset(rec, 0, sizeof(*rec));
+	rec->settingsResult = rec->appDataResult = -1;
+
+	rec->result = nfcGetTagInfo(&rec->info);
+	if (R_FAILED(rec->result) || nfcReaderCacheLookup(rec))
+		return;
+
+	rec->result = nfcLoadAmiiboData();
+	if (R_SUCCEEDED(rec->result)) rec->result = nfcGetAmiiboConfig(&rec->config);
+	if (R_FAILED(rec->result))
+		return;
+
+	rec->settingsResult = nfcGetAmiiboSettings(&rec->settings);
+	if (nfcReaderAppId)
+	{
+		rec->appDataResult = nfcOpenAppData(nfcReaderAppId);
+		if (R_SUCCEEDED(rec->appDataResult)) rec->appDataResult = nfcReadAppData(rec->appData, sizeof(rec->appData));
+	}
+
+	// Go back to NFC_TagState_InRange so that the removal of the tag is still tracked
+	nfcResetTagScanState();
+	nfcReaderCacheInsert(rec);
+}
+
+static void nfcReaderThreadMain(void *arg)
+{
+	int ret;
+
+	for (;;)
+	{
+		if (nfcReaderWaitState(nfcReaderInRangeEvent, NFC_TagState_InRange, -1) < 0)
+			break;
+
+		// Debounce: tags which leave the field before the debounce delay are ignored
+		ret = nfcReaderWaitState(nfcReaderOutOfRangeEvent, NFC_TagState_OutOfRange, nfcReaderDebounceMs);
+		if (ret < 0)
+			break;
+
+		if (ret == 0)
+		{
+			nfcReaderReadTag(&nfcReaderRecord);
+			nfcReaderCallback(&nfcReaderRecord, false, nfcReaderUser);
+
+			ret = nfcReaderWaitState(nfcReaderOutOfRangeEvent, NFC_TagState_OutOfRange, -1);
+			if (ret < 0)
+				break;
+			nfcReaderCallback(&nfcReaderRecord, true, nfcReaderUser);
+		}
+
+		// The out-of-range state is final, scanning must be restarted to detect the next tag
+		NFC_StopTagScanning();
+		if (R_FAILED(NFC_StartTagScanning(nfcReaderInval)))
+			break;
+	}
+}
+
+Result nfcTagReaderStart(u16 inval, u32 amiibo_appid, u32 debounce_ms, nfcTagReaderCallback callback, void *user)
+{
+	if (nfcReaderThread) return 0;
+	if (!callback) return MAKERESULT(RL_USAGE, RS_INVALIDARG, RM_APPLICATION, RD_INVALID_POINTER);
+
+	nfcReaderCallback = callback;
+	nfcReaderUser = user;
+	nfcReaderInval = inval;
+	nfcReaderAppId = amiibo_appid;
+	nfcReaderDebounceMs = debounce_ms;
+
+	Result ret = svcCreateEvent(&nfcReaderExitEvent, RESET_ONESHOT);
+	if (R_FAILED(ret)) return ret;
+
+	// Older NFC modules may not provide the events, fall back to polling the tag state then
+	if (R_FAILED(NFC_GetTagInRangeEvent(&nfcReaderInRangeEvent))) nfcReaderInRangeEvent = 0;
+	if (R_FAILED(NFC_GetTagOutOfRangeEvent(&nfcReaderOutOfRangeEvent))) nfcReaderOutOfRangeEvent = 0;
+
+	ret = nfcStartScanning(inval);
+	if (R_SUCCEEDED(ret))
+	{
+		s32 prio = 0x30;
+		svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+		nfcReaderThread = threadCreate(nfcReaderThreadMain, NULL, NFC_READER_STACK_SIZE, prio, -2, false);
+		if (!nfcReaderThread)
+		{
+			nfcStopScanning();
+			ret = MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+		}
+	}
+
+	if (R_FAILED(ret))
+	{
+		svcCloseHandle(nfcReaderExitEvent);
+		if (nfcReaderInRangeEvent) svcCloseHandle(nfcReaderInRangeEvent);
+		if (nfcReaderOutOfRangeEvent) svcCloseHandle(nfcReaderOutOfRangeEvent);
+		nfcReaderExitEvent = nfcReaderInRangeEvent = nfcReaderOutOfRangeEvent = 0;
+	}
+	return ret;
+}
+
+void nfcTagReaderStop(void)
+{
+	if (!nfcReaderThread) return;
+
+	svcSignalEvent(nfcReaderExitEvent);
+	threadJoin(nfcReaderThread, U64_MAX);
+	threadFree(nfcReaderThread);
+	nfcReaderThread = NULL;
+
+	nfcStopScanning();
+
+	svcCloseHandle(nfcReaderExitEvent);
+	if (nfcReaderInRangeEvent) svcCloseHandle(nfcReaderInRangeEvent);
+	if (nfcReaderOutOfRangeEvent) svcCloseHandle(nfcReaderOutOfRangeEvent);
+	nfcReaderExitEvent = nfcReaderInRangeEvent = nfcReaderOutOfRangeEvent = 0;
+}
@@ -0,0 +1,103 @@
+#include "soc_common.h"
+#include <errno.h>
+#include <malloc.h>
+#include <sys/socket.h>
+
+#define PAGE_SIZE 0x1000
+
+int SOCU_BufferPoolInit(SOCU_BufferPool *pool, void *mem, u32 buf_size, u32 num_bufs)
+{
+	if(pool == NULL || buf_size == 0 || num_bufs == 0 || ((u32)mem & (PAGE_SIZE-1))) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	buf_size = (buf_size + PAGE_SIZE-1) &~ (PAGE_SIZE-1);
+	if(buf_size > UINT32_MAX / num_bufs) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	pool->owned = mem == NULL;
+	if(pool->owned)
+		mem = memalign(PAGE_SIZE, buf_size*num_bufs);
+	if(mem == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	pool->base      = (u8*)mem;
+	pool->buf_size  = buf_size;
+	pool->num_bufs  = num_bufs;
+	pool->num_free  = num_bufs;
+	LightLock_Init(&pool->lock);
+
+	// The free list is threaded through the free buffers themselves
+	pool->free_list = NULL;
+	for(u32 i = num_bufs; i > 0; --i) {
+		void **buf = (void**)(pool->base + (i-1)*buf_size);
+		*buf = pool->free_list;
+		pool->free_list = buf;
+	}
+
+	return 0;
+}
+
+void SOCU_BufferPoolExit(SOCU_BufferPool *pool)
+{
+	if(pool->base == NULL)
+		return;
+
+	if(pool->owned)
+		free(pool->base);
+	pool->base = NULL;
+	pool->free_list = NULL;
+	pool->num_free = 0;
+}
+
+void* SOCU_BufferAlloc(SOCU_BufferPool *pool)
+{
+	LightLock_Lock(&pool->lock);
+	void **buf = (void**)pool->free_list;
+	if(buf != NULL) {
+		pool->free_list = *buf;
+		pool->num_free--;
+	}
+	LightLock_Unlock(&pool->lock);
+	return buf;
+}
+
+void SOCU_BufferFree(SOCU_BufferPool *pool, void *buf)
+{
+	if(buf == NULL)
+		return;
+
+	LightLock_Lock(&pool->lock);
+	*(void**)buf = pool->free_list;
+	pool->free_list = buf;
+	pool->num_free++;
+	LightLock_Unlock(&pool->lock);
+}
+
+ssize_t SOCU_SendBuffer(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen)
+{
+	sockfd = soc_get_fd(sockfd);
+	if(sockfd < 0) {
+		errno = -sockfd;
+		return -1;
+	}
+
+	// Always map the buffer, even for small payloads which sendto() copies through a static buffer
+	return socuipc_cmd9(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+ssize_t SOCU_RecvBuffer(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	sockfd = soc_get_fd(sockfd);
+	if(sockfd < 0) {
+		errno = -sockfd;
+		return -1;
+	}
+
+	return socuipc_cmd7(sockfd, buf, len, flags, src_addr, addrlen);
+}
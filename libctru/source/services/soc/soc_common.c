@@ -1,11 +1,125 @@
 #include "soc_common.h"
 #include <errno.h>
 #include <sys/iosupport.h>
+#include "../../internal.h"
 
 Handle	SOCU_handle = 0;
 Handle	socMemhandle = 0;
 int h_errno = 0;
 
+// Until socInit is called, the pool only holds a null session so that calls fail instead of blocking
+static socSessionPool_s socPool = { .numSessions = 1, .maxSessions = 1 };
+static LightLock        socPoolLock = 1;
+static CondVar          socPoolCond;
+static __thread int     socPreferredSession = -1;
+
+void socSessionPoolInit(Handle primary)
+{
+	socPool.handles[0]  = primary;
+	socPool.busyMask    = 0;
+	socPool.numSessions = 1;
+	socPool.maxSessions = SOC_MAX_SESSIONS;
+	LightLock_Init(&socPoolLock);
+	CondVar_Init(&socPoolCond);
+}
+
+void socSessionPoolExit(void)
+{
+	u32 i;
+	LightLock_Lock(&socPoolLock);
+	for(i = 1; i < socPool.numSessions; ++i)
+		svcCloseHandle(socPool.handles[i]);
+	socPool.handles[0]  = 0;
+	socPool.busyMask    = 0;
+	socPool.numSessions = 1;
+	socPool.maxSessions = 1;
+	LightLock_Unlock(&socPoolLock);
+}
+
+static Result socSessionOpen(Handle *session)
+{
+	// The caller has already filled in the command buffer, and srv uses it too
+	u32 *cmdbuf = getThreadCommandBuffer();
+	u32 saved_cmdbuf[0x40];
+	memcpy(saved_cmdbuf, cmdbuf, sizeof(saved_cmdbuf));
+
+	// Never wait for a slot on the port: failing just means the pool can't grow anymore
+	bool saved_policy = srvGetBlockingPolicy();
+	srvSetBlockingPolicy(true);
+
+	Result ret = srvGetServiceHandleDirect(session, "soc:U");
+
+	srvSetBlockingPolicy(saved_policy);
+	memcpy(cmdbuf, saved_cmdbuf, sizeof(saved_cmdbuf));
+	return ret;
+}
+
+Handle socSessionAcquire(bool blocking)
+{
+	int id;
+
+	LightLock_Lock(&socPoolLock);
+	for(;;)
+	{
+		id = socSessionPick(&socPool, socPreferredSession, blocking);
+		if(id >= 0)
+			break;
+
+		if(id == SOC_SESSION_GROW)
+		{
+			// Reserve the slot, the session is opened without holding the lock (it's an IPC to srv)
+			socPool.numOpening++;
+			LightLock_Unlock(&socPoolLock);
+
+			Handle session;
+			Result ret = socSessionOpen(&session);
+
+			LightLock_Lock(&socPoolLock);
+			socPool.numOpening--;
+			if(R_SUCCEEDED(ret))
+			{
+				// The pool may have been closed in the meantime
+				if(socPool.numSessions < socPool.maxSessions)
+				{
+					id = socPool.numSessions++;
+					socPool.handles[id] = session;
+					break;
+				}
+				svcCloseHandle(session);
+			} else
+			{
+				// Out of sessions, stop trying to grow the pool
+				socPool.maxSessions = socPool.numSessions + socPool.numOpening;
+			}
+
+			// Threads waiting for the reserved slot have to pick again
+			CondVar_Broadcast(&socPoolCond);
+			continue;
+		}
+
+		CondVar_Wait(&socPoolCond, &socPoolLock);
+	}
+
+	socPool.busyMask |= BIT(id);
+	Handle session = socPool.handles[id];
+	LightLock_Unlock(&socPoolLock);
+
+	socPreferredSession = id;
+	return session;
+}
+
+void socSessionRelease(Handle session)
+{
+	LightLock_Lock(&socPoolLock);
+	int id = socSessionFind(&socPool, session);
+	if(id >= 0)
+	{
+		socPool.busyMask &= ~BIT(id);
+		CondVar_Signal(&socPoolCond);
+	}
+	LightLock_Unlock(&socPoolLock);
+}
+
 //This is based on the array from libogc network_wii.c.
 static u8 _net_error_code_map[] = {
 	0, // 0
@@ -7,13 +7,33 @@
 #include <3ds/types.h>
 #include <3ds/svc.h>
 #include <3ds/srv.h>
+#include <3ds/synchronization.h>
 #include <3ds/services/soc.h>
+#include "soc_session.h"
 
 #define SYNC_ERROR ENODEV
 
 extern Handle	SOCU_handle;
 extern Handle	socMemhandle;
 
+void socSessionPoolInit(Handle primary);
+void socSessionPoolExit(void);
+
+// Gets a SOCU session that isn't in use by another thread, opening a new one if needed
+Handle socSessionAcquire(bool blocking);
+void socSessionRelease(Handle session);
+
+// Sends the request in the thread command buffer on a free SOCU session.
+// Calls which may block for a long time should set blocking to true.
+static inline Result
+socSendSyncRequest(bool blocking)
+{
+	Handle session = socSessionAcquire(blocking);
+	Result ret = svcSendSyncRequest(session);
+	socSessionRelease(session);
+	return ret;
+}
+
 static inline int
 soc_get_fd(int fd)
 {
@@ -27,6 +47,15 @@ soc_get_fd(int fd)
 
 s32 _net_convert_error(s32 sock_retval);
 
+// Host name lookups. These return 0 on success, or an h_errno value.
+int soc_gethostbyname_ipc(const char *name, char *canon, size_t canonlen, struct in_addr *addrs, u32 *num_addrs);
+int soc_resolve(const char *name, char *canon, size_t canonlen, struct in_addr *addrs, u32 *num_addrs);
+void soc_resolver_exit(void);
+
+// Receive/send using mapped buffer descriptors (cmd7/cmd9) or static buffers (cmd8/cmdA)
+ssize_t socuipc_cmd7(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen);
+ssize_t socuipc_cmd9(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
+
 ssize_t soc_recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen);
 
 ssize_t soc_sendto(int sockfd, const void *buf, size_t len, int flags, const struct sockaddr *dest_addr, socklen_t addrlen);
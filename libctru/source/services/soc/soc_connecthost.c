@@ -0,0 +1,196 @@
+#include "soc_common.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <3ds/os.h>
+
+typedef struct
+{
+	int fd;
+	u32 addr;
+} connect_attempt;
+
+static void close_attempts(connect_attempt *attempts, u32 num, int keep)
+{
+	for(u32 i = 0; i < num; ++i) {
+		if(attempts[i].fd >= 0 && attempts[i].fd != keep)
+			close(attempts[i].fd);
+		attempts[i].fd = -1;
+	}
+}
+
+// Creates a configured non-blocking socket and starts connecting it, returns 1 if connected, 0 if in progress, -1 on failure
+static int start_attempt(connect_attempt *attempt, struct in_addr addr, u16 port, const SOCU_ConnectOptions *opts)
+{
+	struct sockaddr_in sa;
+	int                one = 1;
+
+	attempt->fd = socket(AF_INET, SOCK_STREAM, 0);
+	if(attempt->fd < 0)
+		return -1;
+
+	// Buffer sizes must be set before connecting for the window size to take them into account
+	if(opts->nodelay)
+		setsockopt(attempt->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	if(opts->sndbuf > 0)
+		setsockopt(attempt->fd, SOL_SOCKET, SO_SNDBUF, &opts->sndbuf, sizeof(opts->sndbuf));
+	if(opts->rcvbuf > 0)
+		setsockopt(attempt->fd, SOL_SOCKET, SO_RCVBUF, &opts->rcvbuf, sizeof(opts->rcvbuf));
+
+	// New sockets have no other flags set, so there is no need to query them first
+	if(fcntl(attempt->fd, F_SETFL, O_NONBLOCK) < 0) {
+		int err = errno;
+		close(attempt->fd);
+		attempt->fd = -1;
+		errno = err;
+		return -1;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port   = htons(port);
+	sa.sin_addr   = addr;
+
+	if(connect(attempt->fd, (struct sockaddr*)&sa, sizeof(sa)) == 0)
+		return 1;
+	if(errno == EINPROGRESS || errno == EALREADY || errno == EWOULDBLOCK)
+		return 0;
+
+	int err = errno;
+	close(attempt->fd);
+	attempt->fd = -1;
+	errno = err;
+	return -1;
+}
+
+int SOCU_ConnectAddrs(const struct in_addr *addrs, u32 num_addrs, u16 port, const SOCU_ConnectOptions *opts)
+{
+	static const SOCU_ConnectOptions default_opts = { .timeout_ms = -1, .stagger_ms = 250 };
+	connect_attempt attempts[SOCU_MAX_HOST_ADDRS];
+	struct pollfd   fds[SOCU_MAX_HOST_ADDRS];
+	u32             num_started = 0, num_pending = 0, i;
+	int             winner = -1, last_error = ECONNREFUSED;
+
+	if(opts == NULL)
+		opts = &default_opts;
+	if(addrs == NULL || num_addrs == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	if(num_addrs > SOCU_MAX_HOST_ADDRS)
+		num_addrs = SOCU_MAX_HOST_ADDRS;
+
+	u64 now      = osGetTime();
+	u64 deadline = opts->timeout_ms < 0 ? U64_MAX : now + opts->timeout_ms;
+	u64 next_start = now;
+
+	for(;;) {
+		// Start the next attempt once the stagger delay has elapsed, or right away if all the others failed
+		if(num_started < num_addrs && (now >= next_start || num_pending == 0)) {
+			int ret = start_attempt(&attempts[num_started], addrs[num_started], port, opts);
+			if(ret > 0) {
+				winner = attempts[num_started++].fd;
+				break;
+			}
+			if(ret == 0)
+				num_pending++;
+			else
+				last_error = errno;
+			num_started++;
+			next_start = now + opts->stagger_ms;
+			continue;
+		}
+
+		if(num_pending == 0)
+			break;
+		if(now >= deadline) {
+			last_error = ETIMEDOUT;
+			break;
+		}
+
+		u64 wake = deadline;
+		if(num_started < num_addrs && next_start < wake)
+			wake = next_start;
+
+		nfds_t nfds = 0;
+		for(i = 0; i < num_started; ++i) {
+			if(attempts[i].fd < 0)
+				continue;
+			fds[nfds].fd      = attempts[i].fd;
+			fds[nfds].events  = POLLOUT;
+			fds[nfds].revents = 0;
+			nfds++;
+		}
+
+		int timeout = wake == U64_MAX ? -1 : (int)(wake - now);
+		// The outstanding attempts can't be tracked anymore, they are all closed below
+		if(poll(fds, nfds, timeout) < 0) {
+			last_error = errno;
+			break;
+		}
+
+		for(i = 0; i < nfds && winner < 0; ++i) {
+			if(!fds[i].revents)
+				continue;
+
+			int       err = 0;
+			socklen_t len = sizeof(err);
+			if(getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+				err = errno;
+
+			if(err == 0 && (fds[i].revents & POLLOUT)) {
+				winner = fds[i].fd;
+				break;
+			}
+
+			// This attempt failed, drop it
+			last_error = err ? err : ECONNREFUSED;
+			for(u32 j = 0; j < num_started; ++j) {
+				if(attempts[j].fd == fds[i].fd) {
+					close(attempts[j].fd);
+					attempts[j].fd = -1;
+				}
+			}
+			num_pending--;
+		}
+		if(winner >= 0)
+			break;
+
+		now = osGetTime();
+	}
+
+	close_attempts(attempts, num_started, winner);
+	if(winner < 0) {
+		errno = last_error;
+		return -1;
+	}
+
+	if(!opts->nonblocking && fcntl(winner, F_SETFL, 0) < 0) {
+		int err = errno;
+		close(winner);
+		errno = err;
+		return -1;
+	}
+
+	return winner;
+}
+
+int SOCU_ConnectHost(const char *host, u16 port, const SOCU_ConnectOptions *opts)
+{
+	struct in_addr addrs[SOCU_MAX_HOST_ADDRS];
+	char           canon[256];
+	u32            num_addrs;
+
+	int err = soc_resolve(host, canon, sizeof(canon), addrs, &num_addrs);
+	if(err != 0 || num_addrs == 0) {
+		h_errno = err ? err : NO_DATA;
+		errno = EHOSTUNREACH;
+		return -1;
+	}
+
+	return SOCU_ConnectAddrs(addrs, num_addrs, port, opts);
+}
@@ -52,6 +52,8 @@ static struct addrinfo * buffer2addrinfo(addrinfo_3ds_t * entry)
 		ai->ai_addrlen  = entry->ai_addrlen;
 
 		memcpy(ai->ai_canonname, entry->ai_canonname, ai_canonname_len);
+		if(ai_canonname_len == 0 || !(ai->ai_flags & AI_CANONNAME))
+			ai->ai_canonname = NULL;
 		memcpy(ai->ai_addr, &entry->ai_addr, ai->ai_addrlen);
 		ai->ai_addr->sa_family = ntohs(ai->ai_addr->sa_family) & 0xFF; // Clear sa_len to match the API
 	}
@@ -91,7 +93,7 @@ static int getaddrinfo_detail(const char *node, const char *service, const struc
 	staticbufs[0] = IPC_Desc_StaticBuffer(sizeof(addrinfo_3ds_t) * info_count, 0);
 	staticbufs[1] = (u32)info;
 
-	int ret = svcSendSyncRequest(SOCU_handle);
+	int ret = socSendSyncRequest(true);
 
 	// Restore the thread storage values
 	for(i = 0 ; i < 2 ; ++i)
@@ -135,6 +137,65 @@ static int getaddrinfo_detail(const char *node, const char *service, const struc
 	return 0;
 }
 
+// Answers simple IPv4 queries from the resolver cache, returns 1 if the query must go through SOCU instead
+static int getaddrinfo_cached(const char *node, const char *service, const struct addrinfo *hints, struct addrinfo **res)
+{
+	struct in_addr addrs[SOCU_MAX_HOST_ADDRS];
+	char           canon[256];
+	u32            num_addrs, i;
+	unsigned long  port = 0;
+	char           *end;
+
+	if(node == NULL || hints == NULL || hints->ai_socktype == 0)
+		return 1;
+	if(hints->ai_family != AF_UNSPEC && hints->ai_family != AF_INET)
+		return 1;
+	if(hints->ai_flags & (AI_CANONNAME | AI_NUMERICHOST))
+		return 1;
+	if(service != NULL)
+	{
+		port = strtoul(service, &end, 10);
+		if(*service == 0 || *end != 0 || port > 0xFFFF)
+			return 1;
+	}
+
+	if(soc_resolve(node, canon, sizeof(canon), addrs, &num_addrs) != 0 || num_addrs == 0)
+		return 1;
+
+	struct addrinfo **ptr = res;
+	for(i = 0; i < num_addrs; ++i)
+	{
+		struct addrinfo    *ai = (struct addrinfo*)calloc(1, sizeof(*ai) + sizeof(struct sockaddr_storage));
+		struct sockaddr_in *sa;
+		if(ai == NULL)
+		{
+			*ptr = NULL;
+			freeaddrinfo(*res);
+			*res = NULL;
+			return EAI_MEMORY;
+		}
+
+		ai->ai_canonname = NULL; // AI_CANONNAME queries don't go through the cache
+		ai->ai_addr      = (struct sockaddr*)((char*)ai + sizeof(*ai));
+		ai->ai_flags     = hints->ai_flags;
+		ai->ai_family    = AF_INET;
+		ai->ai_socktype  = hints->ai_socktype;
+		ai->ai_protocol  = hints->ai_protocol;
+		ai->ai_addrlen   = sizeof(struct sockaddr_in);
+
+		sa = (struct sockaddr_in*)ai->ai_addr;
+		sa->sin_family = AF_INET;
+		sa->sin_port   = htons(port);
+		sa->sin_addr   = addrs[i];
+
+		*ptr = ai;
+		ptr = &ai->ai_next;
+	}
+	*ptr = NULL;
+
+	return 0;
+}
+
 int getaddrinfo(const char *node, const char *service, const struct addrinfo *hints, struct addrinfo **res)
 {
 	Result ret;
@@ -146,6 +207,10 @@ int getaddrinfo(const char *node, const char *service, const struct addrinfo *hi
 		return EAI_NONAME;
 	}
 
+	ret = getaddrinfo_cached(node, service, hints, res);
+	if(ret != 1)
+		return ret;
+
 	do
 	{
 		info_count = count;
@@ -1,24 +1,28 @@
 #include "soc_common.h"
 #include <netdb.h>
+#include <stdlib.h>
 #include <3ds/ipc.h>
 
-#define MAX_HOSTENT_RESULTS 16
-static struct hostent SOC_hostent;
-static char           *SOC_hostent_results[MAX_HOSTENT_RESULTS+1];
-static char           *SOC_hostent_alias = NULL;
+#define HOSTENT_OUTBUF_SIZE 0x1A88
 
-struct hostent* gethostbyname(const char *name)
+static __thread struct hostent SOC_hostent;
+static __thread char           SOC_hostent_buf[(SOCU_MAX_HOST_ADDRS+2)*sizeof(char*) + SOCU_MAX_HOST_ADDRS*4 + 256];
+
+int soc_gethostbyname_ipc(const char *name, char *canon, size_t canonlen, struct in_addr *addrs, u32 *num_addrs)
 {
 	int ret = 0;
 	u32 *cmdbuf = getThreadCommandBuffer();
 	u32 saved_threadstorage[2];
-	static u8 outbuf[0x1A88];
+	u8 *outbuf;
 
-	h_errno = 0;
+	*num_addrs = 0;
+	outbuf = (u8*)malloc(HOSTENT_OUTBUF_SIZE);
+	if(outbuf == NULL)
+		return TRY_AGAIN;
 
 	cmdbuf[0] = IPC_MakeHeader(0xD,2,2); // 0xD0082
 	cmdbuf[1] = strlen(name)+1;
-	cmdbuf[2] = sizeof(outbuf);
+	cmdbuf[2] = HOSTENT_OUTBUF_SIZE;
 	cmdbuf[3] = ((strlen(name)+1) << 14) | 0xC02;
 	cmdbuf[4] = (u32)name;
 
@@ -26,47 +30,109 @@ struct hostent* gethostbyname(const char *name)
 	saved_threadstorage[0] = staticbufs[0];
 	saved_threadstorage[1] = staticbufs[1];
 
-	staticbufs[0] = IPC_Desc_StaticBuffer(sizeof(outbuf),0);
+	staticbufs[0] = IPC_Desc_StaticBuffer(HOSTENT_OUTBUF_SIZE,0);
 	staticbufs[1] = (u32)outbuf;
 
-	ret = svcSendSyncRequest(SOCU_handle);
+	ret = socSendSyncRequest(true);
 
 	staticbufs[0] = saved_threadstorage[0];
 	staticbufs[1] = saved_threadstorage[1];
 
 	if(ret != 0) {
-		h_errno = NO_RECOVERY;
-		return NULL;
+		free(outbuf);
+		return NO_RECOVERY;
 	}
 
 	ret = (int)cmdbuf[1];
 	if(ret == 0)
 		ret = _net_convert_error(cmdbuf[2]);
 
-        if(ret < 0) {
-		/* TODO: set h_errno based on ret */
-		h_errno = HOST_NOT_FOUND;
-		return NULL;
+	if(ret < 0) {
+		free(outbuf);
+		// Only an answer saying that the name doesn't exist is definitive (and cached by the resolver),
+		// failures such as the network being down or a timeout are worth retrying
+		if(ret == -ENOENT || ret == -ENODATA || ret == -ENXIO)
+			return HOST_NOT_FOUND;
+		return TRY_AGAIN;
 	}
 
 	u32 num_results, i;
-	memcpy(&num_results, (char*)outbuf+4, sizeof(num_results));
-	if(num_results > MAX_HOSTENT_RESULTS)
-		num_results = MAX_HOSTENT_RESULTS;
-
-	SOC_hostent.h_name      = (char*)outbuf + 8;
-	SOC_hostent.h_aliases   = &SOC_hostent_alias;
-	SOC_hostent.h_addrtype  = AF_INET;
-	SOC_hostent.h_length    = 4;
-	SOC_hostent.h_addr_list = SOC_hostent_results;
+	memcpy(&num_results, outbuf+4, sizeof(num_results));
+	if(num_results > SOCU_MAX_HOST_ADDRS)
+		num_results = SOCU_MAX_HOST_ADDRS;
 
-	SOC_hostent_alias = NULL;
+	if(canonlen) {
+		strncpy(canon, (char*)outbuf + 8, canonlen-1);
+		canon[canonlen-1] = 0;
+	}
 
 	for(i = 0; i < num_results; ++i)
-		SOC_hostent_results[i] = (char*)outbuf + 0x1908 + i*0x10;
-	SOC_hostent_results[num_results] = NULL;
+		memcpy(&addrs[i], outbuf + 0x1908 + i*0x10, sizeof(addrs[i]));
+	*num_addrs = num_results;
+
+	free(outbuf);
+	return 0;
+}
+
+int gethostbyname_r(const char *name, struct hostent *ret, char *buf, size_t buflen, struct hostent **result, int *h_errnop)
+{
+	struct in_addr addrs[SOCU_MAX_HOST_ADDRS];
+	char           canon[256];
+	u32            num_addrs, i;
+	int            err;
+
+	*result = NULL;
+
+	err = soc_resolve(name, canon, sizeof(canon), addrs, &num_addrs);
+	if(err != 0) {
+		*h_errnop = err;
+		return 0;
+	}
 
-	SOC_hostent.h_addr = SOC_hostent.h_addr_list[0];
+	// Layout: alias list, address list, addresses, canonical name
+	size_t canon_len = strlen(canon)+1;
+	size_t align     = (sizeof(char*) - ((u32)buf & (sizeof(char*)-1))) & (sizeof(char*)-1);
+	size_t needed    = align + (num_addrs+2)*sizeof(char*) + num_addrs*4 + canon_len;
+	if(buflen < needed) {
+		*h_errnop = NO_RECOVERY;
+		return ERANGE;
+	}
+
+	char **ptrs    = (char**)(buf + align);
+	char *addr_buf = (char*)&ptrs[num_addrs+2];
+	char *name_buf = addr_buf + num_addrs*4;
+
+	ptrs[0] = NULL;
+	for(i = 0; i < num_addrs; ++i) {
+		memcpy(addr_buf + i*4, &addrs[i], 4);
+		ptrs[1+i] = addr_buf + i*4;
+	}
+	ptrs[1+num_addrs] = NULL;
+	memcpy(name_buf, canon, canon_len);
+
+	ret->h_name      = name_buf;
+	ret->h_aliases   = &ptrs[0];
+	ret->h_addrtype  = AF_INET;
+	ret->h_length    = 4;
+	ret->h_addr_list = &ptrs[1];
+	ret->h_addr      = ret->h_addr_list[0];
+
+	*h_errnop = 0;
+	*result = ret;
+	return 0;
+}
+
+struct hostent* gethostbyname(const char *name)
+{
+	struct hostent *result;
+	int err;
+
+	h_errno = 0;
+
+	if(gethostbyname_r(name, &SOC_hostent, SOC_hostent_buf, sizeof(SOC_hostent_buf), &result, &err) != 0 || result == NULL) {
+		h_errno = err;
+		return NULL;
+	}
 
-	return &SOC_hostent;
+	return result;
 }
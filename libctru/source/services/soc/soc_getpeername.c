@@ -28,7 +28,7 @@ int getpeername(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
 	staticbufs[0] = IPC_Desc_StaticBuffer(0x1c,0);
 	staticbufs[1] = (u32)tmpaddr;
 
-	ret = svcSendSyncRequest(SOCU_handle);
+	ret = socSendSyncRequest(false);
 
 	staticbufs[0] = saved_threadstorage[0];
 	staticbufs[1] = saved_threadstorage[1];
@@ -115,6 +115,7 @@ Result socInit(u32* context_addr, u32 context_size)
 		return dev;
 	}
 
+	socSessionPoolInit(SOCU_handle);
 	return 0;
 }
 
@@ -123,9 +124,12 @@ Result socExit(void)
 	Result ret = 0;
 	int dev;
 
+	soc_resolver_exit();
+
 	svcCloseHandle(socMemhandle);
 	socMemhandle = 0;
 
+	socSessionPoolExit();
 	ret = SOCU_Shutdown();
 
 	svcCloseHandle(SOCU_handle);
@@ -162,7 +166,7 @@ soc_close(struct _reent *r,
 	cmdbuf[1] = (u32)sockfd;
 	cmdbuf[2] = IPC_Desc_CurProcessId();
 
-	ret = svcSendSyncRequest(SOCU_handle);
+	ret = socSendSyncRequest(false);
 	if(ret != 0) {
 		errno = SYNC_ERROR;
 		return ret;
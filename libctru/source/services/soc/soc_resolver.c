@@ -0,0 +1,338 @@
+#include "soc_common.h"
+#include <netdb.h>
+#include <strings.h>
+#include <3ds/os.h>
+#include <3ds/thread.h>
+
+#define DNS_CACHE_SIZE        16
+#define DNS_WORKER_STACK_SIZE 0x2000
+
+// SOCU doesn't report record TTLs, so cached results expire after fixed delays
+#define DNS_DEFAULT_POSITIVE_TTL (5*60*1000)
+#define DNS_DEFAULT_NEGATIVE_TTL (30*1000)
+
+enum
+{
+	DNS_ENTRY_EMPTY = 0,
+	DNS_ENTRY_PENDING,
+	DNS_ENTRY_VALID,
+};
+
+typedef struct
+{
+	char name[256];
+	char canon[256];
+	struct in_addr addrs[SOCU_MAX_HOST_ADDRS];
+	u32 num_addrs;
+	int error;
+	u8 state;
+	bool owned;               // Whether a thread is currently performing the lookup
+	u64 expires;
+	u64 last_used;
+	SOCU_HostLookup* waiters; // Asynchronous lookups waiting for the result
+} dnsEntry;
+
+static dnsEntry dnsCache[DNS_CACHE_SIZE];
+static LightLock dnsLock = 1;
+static CondVar dnsCond;
+static u32 dnsPositiveTTL = DNS_DEFAULT_POSITIVE_TTL;
+static u32 dnsNegativeTTL = DNS_DEFAULT_NEGATIVE_TTL;
+
+static Thread dnsWorker;
+static LightEvent dnsWorkEvent;
+static bool dnsWorkerQuit;
+
+static inline u64 dnsMsToTicks(u32 ms)
+{
+	return (u64)(ms * CPU_TICKS_PER_MSEC);
+}
+
+static dnsEntry* dnsFind(const char* name)
+{
+	for (int i = 0; i < DNS_CACHE_SIZE; i ++)
+		if (dnsCache[i].state != DNS_ENTRY_EMPTY && strcasecmp(dnsCache[i].name, name) == 0)
+			return &dnsCache[i];
+	return NULL;
+}
+
+// Picks an empty entry, or evicts the least recently used completed entry
+static dnsEntry* dnsAlloc(const char* name)
+{
+	dnsEntry* victim = NULL;
+	for (int i = 0; i < DNS_CACHE_SIZE; i ++)
+	{
+		dnsEntry* e = &dnsCache[i];
+		if (e->state == DNS_ENTRY_EMPTY)
+		{
+			victim = e;
+			break;
+		}
+		if (e->state == DNS_ENTRY_VALID && (!victim || e->last_used < victim->last_used))
+			victim = e;
+	}
+
+	if (victim)
+	{
+		strcpy(victim->name, name);
+		victim->state = DNS_ENTRY_EMPTY;
+		victim->waiters = NULL;
+	}
+	return victim;
+}
+
+static void dnsCopyToLookup(const dnsEntry* e, SOCU_HostLookup* lookup)
+{
+	lookup->error = e->error;
+	lookup->num_addrs = e->num_addrs;
+	memcpy(lookup->addrs, e->addrs, e->num_addrs*sizeof(struct in_addr));
+	strcpy(lookup->canonname, e->canon);
+}
+
+static void dnsNotify(SOCU_HostLookup* list)
+{
+	while (list)
+	{
+		SOCU_HostLookup* next = list->next;
+		// The lookup may be freed as soon as it is signaled, so the callback goes first
+		if (list->callback)
+			list->callback(list);
+		LightEvent_Signal(&list->done);
+		list = next;
+	}
+}
+
+// Stores the result of a lookup in its entry, must be called with the lock held
+static SOCU_HostLookup* dnsComplete(dnsEntry* e, int error, const char* canon, const struct in_addr* addrs, u32 num_addrs)
+{
+	u64 now = svcGetSystemTick();
+
+	e->error = error;
+	e->num_addrs = num_addrs;
+	memcpy(e->addrs, addrs, num_addrs*sizeof(struct in_addr));
+	strcpy(e->canon, canon);
+	e->state = DNS_ENTRY_VALID;
+	e->owned = false;
+	e->last_used = now;
+
+	// Transient failures are not cached
+	if (error == TRY_AGAIN || error == NO_RECOVERY)
+		e->expires = now;
+	else
+		e->expires = now + dnsMsToTicks(error ? dnsNegativeTTL : dnsPositiveTTL);
+
+	SOCU_HostLookup* list = e->waiters;
+	for (SOCU_HostLookup* l = list; l; l = l->next)
+		dnsCopyToLookup(e, l);
+	e->waiters = NULL;
+
+	CondVar_Broadcast(&dnsCond);
+	return list;
+}
+
+// Performs the lookup of an entry owned by the calling thread, must be called with the lock held (it is released on
+// return). The result is also returned through canon (256 bytes), addrs and num_addrs: once completed, the entry may be
+// evicted and reused for another name as soon as the lock is released.
+static int dnsResolveEntry(dnsEntry* e, char* canon, struct in_addr* addrs, u32* num_addrs)
+{
+	char name[256];
+
+	strcpy(name, e->name);
+	LightLock_Unlock(&dnsLock);
+
+	canon[0] = 0;
+	int error = soc_gethostbyname_ipc(name, canon, sizeof(e->canon), addrs, num_addrs);
+
+	LightLock_Lock(&dnsLock);
+	SOCU_HostLookup* list = dnsComplete(e, error, canon, addrs, *num_addrs);
+	LightLock_Unlock(&dnsLock);
+
+	dnsNotify(list);
+	return error;
+}
+
+static void dnsWorkerMain(void* arg)
+{
+	for (;;)
+	{
+		LightEvent_Wait(&dnsWorkEvent);
+
+		LightLock_Lock(&dnsLock);
+		for (int i = 0; i < DNS_CACHE_SIZE; i ++)
+		{
+			dnsEntry* e = &dnsCache[i];
+			if (e->state != DNS_ENTRY_PENDING || e->owned)
+				continue;
+			e->owned = true;
+
+			char canon[256];
+			struct in_addr addrs[SOCU_MAX_HOST_ADDRS];
+			u32 num_addrs;
+			dnsResolveEntry(e, canon, addrs, &num_addrs);
+
+			LightLock_Lock(&dnsLock);
+			i = -1; // The cache may have changed while the lock was released
+		}
+		bool quit = dnsWorkerQuit;
+		LightLock_Unlock(&dnsLock);
+
+		if (quit)
+			break;
+	}
+}
+
+int soc_resolve(const char *name, char *canon, size_t canonlen, struct in_addr *addrs, u32 *num_addrs)
+{
+	if (strlen(name) >= sizeof(dnsCache[0].name))
+		return soc_gethostbyname_ipc(name, canon, canonlen, addrs, num_addrs);
+
+	LightLock_Lock(&dnsLock);
+
+	dnsEntry* e;
+	for (;;)
+	{
+		e = dnsFind(name);
+		if (!e || e->state != DNS_ENTRY_PENDING)
+			break;
+		// Another thread is already resolving this name, wait for its result
+		CondVar_Wait(&dnsCond, &dnsLock);
+	}
+
+	if (!e || svcGetSystemTick() >= e->expires)
+	{
+		if (!e)
+			e = dnsAlloc(name);
+		if (!e)
+		{
+			// Every entry is being resolved, bypass the cache
+			LightLock_Unlock(&dnsLock);
+			return soc_gethostbyname_ipc(name, canon, canonlen, addrs, num_addrs);
+		}
+
+		e->state = DNS_ENTRY_PENDING;
+		e->owned = true;
+
+		char entry_canon[256];
+		int error = dnsResolveEntry(e, entry_canon, addrs, num_addrs);
+		if (canonlen)
+		{
+			strncpy(canon, entry_canon, canonlen-1);
+			canon[canonlen-1] = 0;
+		}
+		return error;
+	}
+
+	e->last_used = svcGetSystemTick();
+	int error = e->error;
+	*num_addrs = e->num_addrs;
+	memcpy(addrs, e->addrs, e->num_addrs*sizeof(struct in_addr));
+	if (canonlen)
+	{
+		strncpy(canon, e->canon, canonlen-1);
+		canon[canonlen-1] = 0;
+	}
+
+	LightLock_Unlock(&dnsLock);
+	return error;
+}
+
+int SOCU_ResolveHostAsync(SOCU_HostLookup *lookup, const char *name, SOCU_HostLookupCallback callback, void *user)
+{
+	if (!lookup || !name || strlen(name) >= sizeof(dnsCache[0].name))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	LightEvent_Init(&lookup->done, RESET_STICKY);
+	lookup->callback = callback;
+	lookup->user = user;
+	lookup->next = NULL;
+
+	LightLock_Lock(&dnsLock);
+
+	dnsEntry* e = dnsFind(name);
+	if (e && e->state == DNS_ENTRY_VALID && svcGetSystemTick() < e->expires)
+	{
+		e->last_used = svcGetSystemTick();
+		dnsCopyToLookup(e, lookup);
+		LightLock_Unlock(&dnsLock);
+		dnsNotify(lookup);
+		return 0;
+	}
+
+	if (!dnsWorker)
+	{
+		LightEvent_Init(&dnsWorkEvent, RESET_ONESHOT);
+		dnsWorkerQuit = false;
+
+		s32 prio = 0x30;
+		svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+		dnsWorker = threadCreate(dnsWorkerMain, NULL, DNS_WORKER_STACK_SIZE, prio, -2, false);
+		if (!dnsWorker)
+		{
+			LightLock_Unlock(&dnsLock);
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+	if (!e)
+		e = dnsAlloc(name);
+	if (!e)
+	{
+		LightLock_Unlock(&dnsLock);
+		errno = EAGAIN;
+		return -1;
+	}
+
+	if (e->state != DNS_ENTRY_PENDING)
+	{
+		e->state = DNS_ENTRY_PENDING;
+		e->owned = false;
+	}
+
+	// Join the lookup already in progress (if any)
+	lookup->next = e->waiters;
+	e->waiters = lookup;
+
+	LightLock_Unlock(&dnsLock);
+	LightEvent_Signal(&dnsWorkEvent);
+	return 0;
+}
+
+void SOCU_SetResolverTTL(u32 positive_ms, u32 negative_ms)
+{
+	LightLock_Lock(&dnsLock);
+	dnsPositiveTTL = positive_ms;
+	dnsNegativeTTL = negative_ms;
+	LightLock_Unlock(&dnsLock);
+}
+
+void SOCU_FlushResolverCache(void)
+{
+	LightLock_Lock(&dnsLock);
+	for (int i = 0; i < DNS_CACHE_SIZE; i ++)
+		if (dnsCache[i].state == DNS_ENTRY_VALID)
+			dnsCache[i].state = DNS_ENTRY_EMPTY;
+	LightLock_Unlock(&dnsLock);
+}
+
+void soc_resolver_exit(void)
+{
+	LightLock_Lock(&dnsLock);
+	Thread worker = dnsWorker;
+	dnsWorkerQuit = true;
+	LightLock_Unlock(&dnsLock);
+
+	if (worker)
+	{
+		// The worker completes the lookups which are still queued before exiting
+		LightEvent_Signal(&dnsWorkEvent);
+		threadJoin(worker, U64_MAX);
+		threadFree(worker);
+		dnsWorker = NULL;
+	}
+
+	// Network settings may change before the service is used again
+	SOCU_FlushResolverCache();
+}
@@ -0,0 +1,29 @@
+#include "soc_session.h"
+
+int socSessionPick(const socSessionPool_s *pool, int preferred, bool blocking)
+{
+	u32 allMask  = pool->numSessions >= 32 ? ~0U : (1U << pool->numSessions) - 1;
+	u32 freeMask = allMask &~ pool->busyMask;
+	bool canGrow = pool->numSessions + pool->numOpening < pool->maxSessions;
+
+	if(freeMask == 0)
+		return canGrow ? SOC_SESSION_GROW : SOC_SESSION_WAIT;
+
+	// Keep the last free session for short calls if the pool can still grow
+	if(blocking && canGrow && (freeMask & (freeMask - 1)) == 0)
+		return SOC_SESSION_GROW;
+
+	if(preferred >= 0 && (freeMask & BIT(preferred)))
+		return preferred;
+
+	return __builtin_ctz(freeMask);
+}
+
+int socSessionFind(const socSessionPool_s *pool, Handle session)
+{
+	u32 i;
+	for(i = 0; i < pool->numSessions; ++i)
+		if(pool->handles[i] == session)
+			return i;
+	return -1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <3ds/types.h>
+
+#define SOC_MAX_SESSIONS 8
+
+#define SOC_SESSION_GROW (-1)
+#define SOC_SESSION_WAIT (-2)
+
+typedef struct
+{
+	Handle handles[SOC_MAX_SESSIONS];
+	u32    busyMask;
+	u32    numSessions;
+	u32    numOpening;  // Sessions being opened, which will be added after the current ones
+	u32    maxSessions;
+} socSessionPool_s;
+
+// Picks the session to use for a SOCU call.
+// Returns the index of a free session, SOC_SESSION_GROW if a new session should be opened,
+// or SOC_SESSION_WAIT if the caller has to wait for a session to be released (or opened by another thread).
+// Calls which may block for a long time (accept, blocking recv, DNS...) get a new session rather than
+// taking the last free one, so that short calls from other threads are not stuck behind them.
+int socSessionPick(const socSessionPool_s *pool, int preferred, bool blocking);
+
+// Returns the index of the given session in the pool, or -1 if it isn't part of it.
+int socSessionFind(const socSessionPool_s *pool, Handle session);
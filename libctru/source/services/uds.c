@@ -7,6 +7,7 @@
 #include <3ds/types.h>
 #include <3ds/result.h>
 #include <3ds/svc.h>
+#include <3ds/os.h>
 #include <3ds/srv.h>
 #include <3ds/synchronization.h>
 #include <3ds/services/uds.h>
@@ -43,6 +44,7 @@ static Result udsipc_Unbind(udsBindContext *bindcontext);
 static Result udsipc_DecryptBeaconData(udsNetworkStruct *network, u8 *tag0, u8 *tag1, udsNodeInfo *out);
 
 static Result usd_parsebeacon(u8 *buf, u32 size, udsNetworkScanInfo *networkscan);
+static Result uds_scanraw(u8 *outbuf, size_t maxsize, u32 wlancommID, u8 id8, const u8 *host_macaddress, bool connected);
 
 Result udsInit(size_t sharedmem_size, const char *username)
 {
@@ -455,19 +457,12 @@ Result udsGetNodeInformation(u16 NetworkNodeID, udsNodeInfo *output)
 	return ret;
 }
 
-Result udsScanBeacons(void *buf, size_t maxsize, udsNetworkScanInfo **networks, size_t *total_networks, u32 wlancommID, u8 id8, const u8 *host_macaddress, bool connected)
+static Result uds_scanraw(u8 *outbuf, size_t maxsize, u32 wlancommID, u8 id8, const u8 *host_macaddress, bool connected)
 {
 	Result ret=0;
 	Handle event=0;
-	u8 *outbuf = (u8*)buf;
-	u32 entpos, curpos;
 	nwmScanInputStruct scaninput;
 	nwmBeaconDataReplyHeader *hdr;
-	nwmBeaconDataReplyEntry *entry;
-	udsNetworkScanInfo *networks_ptr;
-
-	if(total_networks)*total_networks = 0;
-	if(networks)*networks = NULL;
 
 	memset(&scaninput, 0, sizeof(nwmScanInputStruct));
 
@@ -490,11 +485,31 @@ Result udsScanBeacons(void *buf, size_t maxsize, udsNetworkScanInfo **networks,
 	if(R_FAILED(ret))return ret;
 
 	hdr = (nwmBeaconDataReplyHeader*)outbuf;
-	curpos = sizeof(nwmBeaconDataReplyHeader);
 
 	if(hdr->maxsize != maxsize)return -2;
 	if(hdr->size > maxsize)return -2;
 
+	return 0;
+}
+
+Result udsScanBeacons(void *buf, size_t maxsize, udsNetworkScanInfo **networks, size_t *total_networks, u32 wlancommID, u8 id8, const u8 *host_macaddress, bool connected)
+{
+	Result ret=0;
+	u8 *outbuf = (u8*)buf;
+	u32 entpos, curpos;
+	nwmBeaconDataReplyHeader *hdr;
+	nwmBeaconDataReplyEntry *entry;
+	udsNetworkScanInfo *networks_ptr;
+
+	if(total_networks)*total_networks = 0;
+	if(networks)*networks = NULL;
+
+	ret = uds_scanraw(outbuf, maxsize, wlancommID, id8, host_macaddress, connected);
+	if(R_FAILED(ret))return ret;
+
+	hdr = (nwmBeaconDataReplyHeader*)outbuf;
+	curpos = sizeof(nwmBeaconDataReplyHeader);
+
 	if(hdr->total_entries)
 	{
 		if(networks)
@@ -1014,3 +1029,164 @@ static Result udsipc_ScanOnConnection(u8 *outbuf, u32 maxsize, nwmScanInputStruc
 	return cmdbuf[1];
 }
 
+static u32 uds_beaconhash(const u8 *buf, u32 size)
+{
+	u32 hash = 0x811C9DC5;//FNV-1a
+
+	while(size--)
+	{
+		hash ^= *buf++;
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
+Result udsBeaconCacheInit(udsBeaconCache *cache, size_t scanbuf_size, u32 wlancommID, u8 id8, u32 maxAgeMs, u32 scanIntervalMs)
+{
+	memset(cache, 0, sizeof(udsBeaconCache));
+
+	if(scanbuf_size < sizeof(nwmBeaconDataReplyHeader))return -2;
+
+	cache->scanbuf = malloc(scanbuf_size);
+	if(cache->scanbuf == NULL)return -1;
+
+	cache->scanbuf_size = scanbuf_size;
+	cache->wlancommID = wlancommID;
+	cache->id8 = id8;
+	cache->maxAgeMs = maxAgeMs;
+	cache->scanIntervalMs = scanIntervalMs;
+
+	return 0;
+}
+
+void udsBeaconCacheExit(udsBeaconCache *cache)
+{
+	free(cache->scanbuf);
+	memset(cache, 0, sizeof(udsBeaconCache));
+}
+
+void udsBeaconCacheSetScanInterval(udsBeaconCache *cache, u32 scanIntervalMs)
+{
+	cache->scanIntervalMs = scanIntervalMs;
+}
+
+Result udsBeaconCacheRefresh(udsBeaconCache *cache, const u8 *host_macaddress, bool connected, bool force)
+{
+	Result ret=0;
+	u8 *outbuf = (u8*)cache->scanbuf;
+	u32 entpos, curpos, pos, datasize, hash;
+	u64 now = svcGetSystemTick();
+	nwmBeaconDataReplyHeader *hdr;
+	nwmBeaconDataReplyEntry *entry;
+	udsBeaconCacheEntry *cacheent;
+	udsNetworkScanInfo networkscan;
+
+	//Within the scan interval the cached list is returned as-is.
+	if(!force && cache->lastScan && now - cache->lastScan < (u64)cache->scanIntervalMs * CPU_TICKS_PER_MSEC)return 0;
+
+	ret = uds_scanraw(outbuf, cache->scanbuf_size, cache->wlancommID, cache->id8, host_macaddress, connected);
+	if(R_FAILED(ret))return ret;
+
+	cache->lastScan = now;
+	hdr = (nwmBeaconDataReplyHeader*)outbuf;
+	curpos = sizeof(nwmBeaconDataReplyHeader);
+
+	for(entpos=0; entpos<hdr->total_entries; entpos++)
+	{
+		if(curpos >= hdr->size)break;
+
+		entry = (nwmBeaconDataReplyEntry*)&outbuf[curpos];
+		if(entry->size > hdr->size || curpos + entry->size > hdr->size || entry->size <= sizeof(nwmBeaconDataReplyEntry))break;
+
+		datasize = entry->size - sizeof(nwmBeaconDataReplyEntry);
+		if(datasize < 0xc)//Beacons without tagged parameters can't be parsed.
+		{
+			curpos+= entry->size;
+			continue;
+		}
+
+		//Only the tagged parameters are hashed, the fixed fields start with the TSF timestamp which changes with every beacon.
+		hash = uds_beaconhash(&outbuf[curpos + sizeof(nwmBeaconDataReplyEntry) + 0xc], datasize - 0xc);
+
+		//Beacons are keyed by host MAC address only, since a host broadcasts a single network: a new networkID replaces the entry. An unchanged beacon is only marked as seen, without decoding/decrypting it again.
+		cacheent = NULL;
+		for(pos=0; pos<UDS_BEACONCACHE_MAXENTRIES; pos++)
+		{
+			if(cache->entries[pos].valid && memcmp(cache->entries[pos].info.datareply_entry.mac_address, entry->mac_address, sizeof(entry->mac_address))==0)
+			{
+				cacheent = &cache->entries[pos];
+				break;
+			}
+		}
+
+		if(cacheent && cacheent->beacon_hash == hash && cacheent->beacon_size == datasize - 0xc)
+		{
+			cacheent->lastSeen = now;
+			memcpy(&cacheent->info.datareply_entry, entry, sizeof(nwmBeaconDataReplyEntry));
+			curpos+= entry->size;
+			continue;
+		}
+
+		memset(&networkscan, 0, sizeof(networkscan));
+		memcpy(&networkscan.datareply_entry, entry, sizeof(nwmBeaconDataReplyEntry));
+
+		//Invalid beacons from other hosts don't affect the rest of the list.
+		if(R_SUCCEEDED(usd_parsebeacon(&outbuf[curpos + sizeof(nwmBeaconDataReplyEntry)], datasize, &networkscan)))
+		{
+			if(cacheent == NULL)//Use a free entry, otherwise replace the least recently seen one.
+			{
+				cacheent = &cache->entries[0];
+				for(pos=0; pos<UDS_BEACONCACHE_MAXENTRIES; pos++)
+				{
+					if(!cache->entries[pos].valid)
+					{
+						cacheent = &cache->entries[pos];
+						break;
+					}
+					if(cache->entries[pos].lastSeen < cacheent->lastSeen)cacheent = &cache->entries[pos];
+				}
+			}
+
+			memcpy(&cacheent->info, &networkscan, sizeof(udsNetworkScanInfo));
+			cacheent->networkID = networkscan.network.networkID;
+			cacheent->beacon_hash = hash;
+			cacheent->beacon_size = datasize - 0xc;
+			cacheent->lastSeen = now;
+			cacheent->valid = true;
+			cache->generation++;
+		}
+
+		curpos+= entry->size;
+	}
+
+	//Drop the networks which weren't seen for maxAgeMs. A scan filtered by host only says something about that host's network.
+	for(pos=0; pos<UDS_BEACONCACHE_MAXENTRIES; pos++)
+	{
+		cacheent = &cache->entries[pos];
+		if(!cacheent->valid)continue;
+		if(host_macaddress && memcmp(cacheent->info.datareply_entry.mac_address, host_macaddress, sizeof(cacheent->info.datareply_entry.mac_address))!=0)continue;
+		if(now - cacheent->lastSeen > (u64)cache->maxAgeMs * CPU_TICKS_PER_MSEC)
+		{
+			cacheent->valid = false;
+			cache->generation++;
+		}
+	}
+
+	return 0;
+}
+
+const udsNetworkScanInfo *udsBeaconCacheFind(const udsBeaconCache *cache, const u8 *host_macaddress, u32 networkID)
+{
+	u32 pos;
+
+	for(pos=0; pos<UDS_BEACONCACHE_MAXENTRIES; pos++)
+	{
+		const udsBeaconCacheEntry *cacheent = &cache->entries[pos];
+		if(!cacheent->valid || cacheent->networkID != networkID)continue;
+		if(memcmp(cacheent->info.datareply_entry.mac_address, host_macaddress, sizeof(cacheent->info.datareply_entry.mac_address))!=0)continue;
+		return &cacheent->info;
+	}
+
+	return NULL;
+}
@@ -19,7 +19,7 @@
 static Handle srvHandle;
 static int srvRefCount;
 
-static bool srvGetBlockingPolicy(void)
+bool srvGetBlockingPolicy(void)
 {
 	ThreadVars *tv = getThreadVars();
 	return tv->magic == THREADVARS_MAGIC && tv->srv_blocking_policy;
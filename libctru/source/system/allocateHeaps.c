@@ -1,11 +1,17 @@
+#include <malloc.h>
+#include <sys/reent.h>
+#include <unistd.h>
 #include <3ds/svc.h>
 #include <3ds/allocator/mappable.h>
+#include <3ds/allocator/heap.h>
 #include <3ds/env.h>
 #include <3ds/os.h>
 #include <3ds/result.h>
+#include <3ds/synchronization.h>
 
 #define HEAP_SPLIT_SIZE_CAP  (24 << 20) // 24MB
 #define LINEAR_HEAP_SIZE_CAP (32 << 20) // 32MB
+#define LINEAR_HEAP_INITIAL_SIZE_CAP (8 << 20) // 8MB, the rest of the linear heap share is committed on demand
 
 extern char* fake_heap_start;
 extern char* fake_heap_end;
@@ -16,6 +22,16 @@ u32 __ctru_linear_heap;
 __attribute__((weak)) u32 __ctru_heap_size        = 0;
 __attribute__((weak)) u32 __ctru_linear_heap_size = 0;
 
+// Commit memory not given to either heap yet, and linear heap telemetry (updated by the linear allocator)
+u32 __ctru_heap_pool_size;
+u32 __ctru_linear_heap_grown;
+u32 __ctru_linear_heap_used;
+u32 __ctru_linear_heap_peak;
+u32 __ctru_linear_heap_grow_count;
+u32 __ctru_linear_heap_grow_failures;
+
+static LightLock __ctru_heap_pool_lock = 1;
+
 void __attribute__((weak)) __system_allocateHeaps(void) {
 	Result rc;
 
@@ -38,7 +54,8 @@ void __attribute__((weak)) __system_allocateHeaps(void) {
 	if (__ctru_heap_size + __ctru_linear_heap_size > remaining)
 		svcBreak(USERBREAK_PANIC);
 
-	if (__ctru_heap_size == 0 && __ctru_linear_heap_size == 0) {
+	bool adaptive = __ctru_heap_size == 0 && __ctru_linear_heap_size == 0;
+	if (adaptive) {
 		// Split available memory equally between linear and application heaps (with rounding in favor of the latter)
 		__ctru_linear_heap_size = (remaining / 2) & ~0xFFF;
 		__ctru_heap_size = remaining - __ctru_linear_heap_size;
@@ -60,6 +77,12 @@ void __attribute__((weak)) __system_allocateHeaps(void) {
 		__ctru_linear_heap_size = remaining - __ctru_heap_size;
 	}
 
+	// With the default split, only part of the linear heap share is committed upfront: the rest is kept in
+	// the pool, from which the linear heap grows on demand (or the application heap, through heapGrow).
+	if (adaptive && __ctru_linear_heap_size > LINEAR_HEAP_INITIAL_SIZE_CAP)
+		__ctru_linear_heap_size = LINEAR_HEAP_INITIAL_SIZE_CAP;
+	__ctru_heap_pool_size = remaining - __ctru_heap_size - __ctru_linear_heap_size;
+
 	// Allocate the application heap
 	rc = svcControlMemory(&__ctru_heap, OS_HEAP_AREA_BEGIN, 0x0, __ctru_heap_size, MEMOP_ALLOC, MEMPERM_READ | MEMPERM_WRITE);
 	if (R_FAILED(rc))
@@ -78,3 +101,85 @@ void __attribute__((weak)) __system_allocateHeaps(void) {
 	fake_heap_end = fake_heap_start + __ctru_heap_size;
 
 }
+
+bool __ctru_heap_pool_take(u32 size)
+{
+	bool ret = false;
+	LightLock_Lock(&__ctru_heap_pool_lock);
+	if (size <= __ctru_heap_pool_size)
+	{
+		__ctru_heap_pool_size -= size;
+		ret = true;
+	}
+	LightLock_Unlock(&__ctru_heap_pool_lock);
+	return ret;
+}
+
+void __ctru_heap_pool_give(u32 size)
+{
+	LightLock_Lock(&__ctru_heap_pool_lock);
+	__ctru_heap_pool_size += size;
+	LightLock_Unlock(&__ctru_heap_pool_lock);
+}
+
+Result heapGrow(u32 size)
+{
+	size = (size + 0xFFF) &~ 0xFFF;
+	if (!size)
+		return 0;
+
+	if (!__ctru_heap_pool_take(size))
+		return MAKERESULT(RL_PERMANENT, RS_OUTOFRESOURCE, RM_APPLICATION, RD_OUT_OF_MEMORY);
+
+	// The heap is contiguous: commit the pages right after its end, then move the newlib heap limit
+	u32 tmp = 0;
+	__malloc_lock(_REENT);
+	Result rc = svcControlMemory(&tmp, __ctru_heap + __ctru_heap_size, 0x0, size, MEMOP_ALLOC, MEMPERM_READ | MEMPERM_WRITE);
+	if (R_SUCCEEDED(rc))
+	{
+		__ctru_heap_size += size;
+		fake_heap_end += size;
+	}
+	__malloc_unlock(_REENT);
+
+	if (R_FAILED(rc))
+		__ctru_heap_pool_give(size);
+	return rc;
+}
+
+u32 heapTrim(void)
+{
+	u32 tmp = 0, size = 0;
+
+	// Let newlib give back the free memory at the top of its heap first
+	malloc_trim(0);
+
+	__malloc_lock(_REENT);
+	u32 brk = ((u32)sbrk(0) + 0xFFF) &~ 0xFFF;
+	u32 end = __ctru_heap + __ctru_heap_size;
+	if (brk > __ctru_heap && brk < end && R_SUCCEEDED(svcControlMemory(&tmp, brk, 0x0, end - brk, MEMOP_FREE, 0x0)))
+	{
+		size = end - brk;
+		__ctru_heap_size -= size;
+		fake_heap_end = (char*)brk;
+	}
+	__malloc_unlock(_REENT);
+
+	if (size)
+		__ctru_heap_pool_give(size);
+	return size;
+}
+
+void heapGetStats(HeapStats* stats)
+{
+	u32 brk = (u32)sbrk(0);
+
+	stats->heapSize = __ctru_heap_size;
+	stats->heapUsed = brk > __ctru_heap ? brk - __ctru_heap : 0;
+	stats->linearSize = __ctru_linear_heap_size + __ctru_linear_heap_grown;
+	stats->linearUsed = __ctru_linear_heap_used;
+	stats->linearPeakUsed = __ctru_linear_heap_peak;
+	stats->poolSize = __ctru_heap_pool_size;
+	stats->linearGrowCount = __ctru_linear_heap_grow_count;
+	stats->linearGrowFailures = __ctru_linear_heap_grow_failures;
+}
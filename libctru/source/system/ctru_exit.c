@@ -9,6 +9,9 @@ extern u32 __ctru_linear_heap_size;
 
 extern void (*__system_retAddr)(void);
 
+// Frees the linear memory committed on demand, only linked in when the linear allocator is used
+void __ctru_linear_heap_exit(void) __attribute__((weak));
+
 void envDestroyHandles(void);
 Result __sync_fini(void);
 
@@ -17,6 +20,8 @@ void __attribute__((weak)) __attribute__((noreturn)) __libctru_exit(int rc)
 	u32 tmp=0;
 
 	// Unmap the linear heap
+	if (__ctru_linear_heap_exit)
+		__ctru_linear_heap_exit();
 	svcControlMemory(&tmp, __ctru_linear_heap, 0x0, __ctru_linear_heap_size, MEMOP_FREE, 0x0);
 
 	// Unmap the application heap
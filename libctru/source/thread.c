@@ -1,4 +1,5 @@
 #include "internal.h"
+#include <3ds/synchronization.h>
 #include <stdlib.h>
 #include <malloc.h>
 #include <string.h>
@@ -8,15 +9,114 @@ extern const u8 __tdata_lma_end[];
 extern u8 __tls_start[];
 extern u8 __tls_end[];
 
+// Flushes the thread cache of the thread-caching allocator, only linked in when it is used
+void __ctru_malloc_thread_exit(void) __attribute__((weak));
+
 static void __panic(void)
 {
 	svcBreak(USERBREAK_PANIC);
 	for (;;);
 }
 
+#define THREAD_POOL_MAX     8
+#define THREAD_STACK_GUARD  0xA5
+
+// Blocks (control block + stack + TLS) of freed threads, reused by threadCreate
+static LightLock threadPoolLock = 1;
+static Thread threadPool;
+static u32 threadPoolCount;
+// Blocks of detached threads that exited while the pool was full, freed by another thread (see threadReap)
+static Thread threadReaper;
+static bool threadStackWatermark;
+
+static Thread threadPoolGet(size_t allocsize)
+{
+	Thread t = NULL;
+
+	LightLock_Lock(&threadPoolLock);
+	for (Thread* pp = &threadPool; *pp; pp = &(*pp)->next)
+	{
+		if ((*pp)->allocsize != allocsize)
+			continue;
+		t = *pp;
+		*pp = t->next;
+		threadPoolCount--;
+		break;
+	}
+	LightLock_Unlock(&threadPoolLock);
+
+	// The previous owner may still be running its last instructions on this stack
+	if (t && t->handle)
+	{
+		svcWaitSynchronization(t->handle, U64_MAX);
+		svcCloseHandle(t->handle);
+	}
+	return t;
+}
+
+static void threadReap(void)
+{
+	LightLock_Lock(&threadPoolLock);
+	Thread t = threadReaper;
+	threadReaper = NULL;
+	LightLock_Unlock(&threadPoolLock);
+
+	while (t)
+	{
+		Thread next = t->next;
+		svcWaitSynchronization(t->handle, U64_MAX);
+		svcCloseHandle(t->handle);
+		free(t);
+		t = next;
+	}
+}
+
+static void threadRelease(Thread t, bool exiting)
+{
+	LightLock_Lock(&threadPoolLock);
+	if (threadPoolCount < THREAD_POOL_MAX)
+	{
+		// The thread handle is kept open until the block is reused, see threadPoolGet
+		t->next = threadPool;
+		threadPool = t;
+		threadPoolCount++;
+		t = NULL;
+	} else if (exiting)
+	{
+		// The exiting thread still runs on this block, and memory it frees may stay in its allocator cache
+		t->next = threadReaper;
+		threadReaper = t;
+		t = NULL;
+	}
+	LightLock_Unlock(&threadPoolLock);
+
+	if (t)
+	{
+		if (t->handle)
+			svcCloseHandle(t->handle);
+		free(t);
+	}
+}
+
 static void _thread_begin(void* arg)
 {
 	Thread t = (Thread)arg;
+	size_t tlssize = __tls_end-__tls_start;
+	size_t tlsloadsize = __tdata_lma_end-__tdata_lma;
+	size_t tbsssize = tlssize-tlsloadsize;
+
+	// TLS and reent are set up by the thread itself, so that creating a thread stays cheap for the caller
+	if (tlsloadsize)
+		memcpy(t->stacktop, __tdata_lma, tlsloadsize);
+	if (tbsssize)
+		memset((u8*)t->stacktop+tlsloadsize, 0, tbsssize);
+
+	// Set up the reent struct, inheriting standard file handles
+	_REENT_INIT_PTR(&t->reent);
+	t->reent._stdin  = t->stdfiles[0];
+	t->reent._stdout = t->stdfiles[1];
+	t->reent._stderr = t->stdfiles[2];
+
 	initThreadVars(t);
 	t->ep(t->arg);
 	threadExit(0);
@@ -27,40 +127,43 @@ Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stack_size, int pri
 	size_t stackoffset = (sizeof(struct Thread_tag)+7)&~7;
 	size_t allocsize   = stackoffset + ((stack_size+7)&~7);
 	size_t tlssize = __tls_end-__tls_start;
-	size_t tlsloadsize = __tdata_lma_end-__tdata_lma;
-	size_t tbsssize = tlssize-tlsloadsize;
 
 	// Guard against overflow
 	if (allocsize < stackoffset) return NULL;
 	if ((allocsize-stackoffset) < stack_size) return NULL;
 	if ((allocsize+tlssize) < allocsize) return NULL;
 
-	Thread t = (Thread)memalign(8,allocsize+tlssize);
+	threadReap();
+
+	Thread t = threadPoolGet(allocsize);
+	if (!t)
+		t = (Thread)memalign(8,allocsize+tlssize);
 	if (!t) return NULL;
 
-	t->ep       = entrypoint;
-	t->arg      = arg;
-	t->detached = detached;
-	t->finished = false;
-	t->stacktop = (u8*)t + allocsize;
+	t->ep        = entrypoint;
+	t->arg       = arg;
+	t->detached  = detached;
+	t->finished  = false;
+	t->stacktop  = (u8*)t + allocsize;
+	t->allocsize = allocsize;
+	t->handle    = 0;
 
-	if (tlsloadsize)
-		memcpy(t->stacktop, __tdata_lma, tlsloadsize);
-	if (tbsssize)
-		memset((u8*)t->stacktop+tlsloadsize, 0, tbsssize);
+	// Fill the stack with the guard pattern to be able to measure its high-water mark
+	t->watermark = threadStackWatermark;
+	if (t->watermark)
+		memset((u8*)t + stackoffset, THREAD_STACK_GUARD, allocsize - stackoffset);
 
-	// Set up child thread's reent struct, inheriting standard file handles
-	_REENT_INIT_PTR(&t->reent);
 	struct _reent* cur = getThreadVars()->reent;
-	t->reent._stdin  = cur->_stdin;
-	t->reent._stdout = cur->_stdout;
-	t->reent._stderr = cur->_stderr;
+	t->stdfiles[0] = cur->_stdin;
+	t->stdfiles[1] = cur->_stdout;
+	t->stdfiles[2] = cur->_stderr;
 
 	Result rc;
 	rc = svcCreateThread(&t->handle, _thread_begin, (u32)t, (u32*)t->stacktop, prio, core_id);
 	if (R_FAILED(rc))
 	{
-		free(t);
+		t->handle = 0;
+		threadRelease(t, false);
 		return NULL;
 	}
 
@@ -82,8 +185,47 @@ int threadGetExitCode(Thread thread)
 void threadFree(Thread thread)
 {
 	if (!thread || !thread->finished) return;
-	svcCloseHandle(thread->handle);
-	free(thread);
+	threadRelease(thread, false);
+}
+
+void threadPoolTrim(void)
+{
+	threadReap();
+
+	LightLock_Lock(&threadPoolLock);
+	Thread t = threadPool;
+	threadPool = NULL;
+	threadPoolCount = 0;
+	LightLock_Unlock(&threadPoolLock);
+
+	while (t)
+	{
+		Thread next = t->next;
+		if (t->handle)
+		{
+			svcWaitSynchronization(t->handle, U64_MAX);
+			svcCloseHandle(t->handle);
+		}
+		free(t);
+		t = next;
+	}
+}
+
+void threadSetStackWatermark(bool enable)
+{
+	threadStackWatermark = enable;
+}
+
+size_t threadGetStackUsage(Thread thread)
+{
+	if (!thread || !thread->watermark) return 0;
+
+	// The stack grows down: the first byte that isn't the guard pattern is the deepest one used
+	u8* bottom = (u8*)thread + ((sizeof(struct Thread_tag)+7)&~7);
+	u8* p = bottom;
+	while (p < (u8*)thread->stacktop && *p == THREAD_STACK_GUARD)
+		p++;
+	return (u8*)thread->stacktop - p;
 }
 
 Result threadJoin(Thread thread, u64 timeout_ns)
@@ -119,9 +261,12 @@ void threadExit(int rc)
 	if (!t)
 		__panic();
 
+	if (__ctru_malloc_thread_exit)
+		__ctru_malloc_thread_exit();
+
 	t->finished = true;
 	if (t->detached)
-		threadFree(t);
+		threadRelease(t, true);
 	else
 		t->rc = rc;
 
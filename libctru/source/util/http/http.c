@@ -0,0 +1,618 @@
+/** @file http.c
+ *  @brief In-process HTTP/1.1 client
+ */
+#include <3ds/util/http.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_LINE_SIZE    2048
+#define MAX_REQUEST_HEAD 4096
+
+/** @brief Parsed URL */
+typedef struct
+{
+  char     host[256]; ///< Host name
+  uint16_t port;      ///< Port
+  bool     tls;       ///< Whether to use TLS
+  const char *path;   ///< Path and query (points into the URL)
+} url_t;
+
+/** @brief Body transfer state */
+typedef struct
+{
+  const http_request_t *req;     ///< Request
+  http_response_t      *resp;    ///< Response
+  void                 *decoder; ///< Decoder state, or NULL
+  const http_decoder_t *codec;   ///< Decoder
+  bool                 aborted;  ///< Whether the data callback aborted the transfer
+} body_t;
+
+static inline void
+pool_lock(http_client_t *client)
+{
+  if(client->transport.lock)
+    client->transport.lock(client->transport.user);
+}
+
+static inline void
+pool_unlock(http_client_t *client)
+{
+  if(client->transport.unlock)
+    client->transport.unlock(client->transport.user);
+}
+
+/** @brief Parse an http:// or https:// URL
+ *  @param[out] url URL output
+ *  @param[in]  str URL string
+ *  @returns Whether the URL is valid
+ */
+static bool
+parse_url(url_t *url, const char *str)
+{
+  if(strncasecmp(str, "http://", 7) == 0)
+  {
+    url->tls  = false;
+    url->port = 80;
+    str += 7;
+  }
+  else if(strncasecmp(str, "https://", 8) == 0)
+  {
+    url->tls  = true;
+    url->port = 443;
+    str += 8;
+  }
+  else
+    return false;
+
+  size_t host_len = strcspn(str, ":/?#");
+  if(host_len == 0 || host_len >= sizeof(url->host))
+    return false;
+
+  memcpy(url->host, str, host_len);
+  url->host[host_len] = 0;
+  str += host_len;
+
+  if(*str == ':')
+  {
+    char          *end;
+    unsigned long port = strtoul(str + 1, &end, 10);
+    if(end == str + 1 || port == 0 || port > 0xFFFF)
+      return false;
+    url->port = port;
+    str = end;
+  }
+
+  url->path = str;
+  return *str == 0 || *str == '/' || *str == '?' || *str == '#';
+}
+
+/** @brief Get a connection to a host, reusing an idle one if possible
+ *  @param[in]  client Client
+ *  @param[in]  url    Parsed URL
+ *  @param[out] reused Whether the connection was reused
+ *  @returns Connection, or NULL on failure
+ */
+static http_connection_t*
+connection_get(http_client_t *client, const url_t *url, bool *reused)
+{
+  http_connection_t *c = NULL;
+
+  pool_lock(client);
+  for(uint32_t i = client->num_idle; i-- > 0;)
+  {
+    http_connection_t *idle = client->idle[i];
+    if(idle->port == url->port && idle->tls == url->tls && strcasecmp(idle->host, url->host) == 0)
+    {
+      c = idle;
+      client->idle[i] = client->idle[--client->num_idle];
+      break;
+    }
+  }
+  pool_unlock(client);
+
+  *reused = c != NULL;
+  if(c)
+    return c;
+
+  c = (http_connection_t*)malloc(sizeof(*c));
+  if(!c)
+    return NULL;
+
+  c->conn = client->transport.connect(client->transport.user, url->host, url->port, url->tls);
+  if(!c->conn)
+  {
+    free(c);
+    return NULL;
+  }
+
+  strcpy(c->host, url->host);
+  c->port = url->port;
+  c->tls  = url->tls;
+  c->pos  = 0;
+  c->len  = 0;
+  return c;
+}
+
+static void
+connection_close(http_client_t *client, http_connection_t *c)
+{
+  client->transport.close(c->conn);
+  free(c);
+}
+
+/** @brief Return a connection to the idle pool, evicting the oldest idle connection if needed */
+static void
+connection_release(http_client_t *client, http_connection_t *c)
+{
+  http_connection_t *evicted = NULL;
+
+  pool_lock(client);
+  if(client->num_idle == HTTP_MAX_IDLE_CONNECTIONS)
+  {
+    evicted = client->idle[0];
+    memmove(&client->idle[0], &client->idle[1], (HTTP_MAX_IDLE_CONNECTIONS-1) * sizeof(client->idle[0]));
+    --client->num_idle;
+  }
+  client->idle[client->num_idle++] = c;
+  pool_unlock(client);
+
+  if(evicted)
+    connection_close(client, evicted);
+}
+
+static bool
+connection_write(http_client_t *client, http_connection_t *c, const void *data, size_t size)
+{
+  const uint8_t *p = (const uint8_t*)data;
+  while(size > 0)
+  {
+    ssize_t rc = client->transport.write(c->conn, p, size);
+    if(rc <= 0)
+      return false;
+    p    += rc;
+    size -= rc;
+  }
+  return true;
+}
+
+/** @brief Refill the receive buffer of a connection
+ *  @returns Number of bytes available, 0 if the connection was closed, negative on error
+ */
+static ssize_t
+connection_fill(http_client_t *client, http_connection_t *c)
+{
+  if(c->pos < c->len)
+    return c->len - c->pos;
+
+  ssize_t rc = client->transport.read(c->conn, c->buf, sizeof(c->buf));
+  c->pos = 0;
+  c->len = rc > 0 ? rc : 0;
+  return rc;
+}
+
+/** @brief Read a CRLF (or LF) terminated line, without the terminator
+ *  @returns Whether a complete line was read
+ */
+static bool
+connection_read_line(http_client_t *client, http_connection_t *c, char *line, size_t size)
+{
+  size_t len = 0;
+  for(;;)
+  {
+    if(connection_fill(client, c) <= 0)
+      return false;
+
+    uint8_t *start = c->buf + c->pos;
+    uint8_t *nl    = memchr(start, '\n', c->len - c->pos);
+    size_t  n      = nl ? (size_t)(nl - start) : c->len - c->pos;
+
+    if(len + n >= size)
+      return false;
+
+    memcpy(line + len, start, n);
+    len    += n;
+    c->pos += n;
+
+    if(nl)
+    {
+      ++c->pos;
+      if(len > 0 && line[len-1] == '\r')
+        --len;
+      line[len] = 0;
+      return true;
+    }
+  }
+}
+
+/** @brief Pass decoded body data to the data callback */
+static bool
+body_sink(void *user, const void *data, size_t size)
+{
+  body_t *body = (body_t*)user;
+  if(body->req->on_data && !body->req->on_data(body->req->user, data, size))
+  {
+    body->aborted = true;
+    return false;
+  }
+  return true;
+}
+
+/** @brief Pass body data to the decoder or the data callback */
+static bool
+body_emit(body_t *body, const void *data, size_t size)
+{
+  body->resp->received += size;
+
+  if(body->decoder)
+    return body->codec->decode(body->decoder, data, size, body_sink, body);
+  return body_sink(body, data, size);
+}
+
+/** @brief Read a body of known length (UINT64_MAX to read until the connection is closed) */
+static int
+read_body_length(http_client_t *client, http_connection_t *c, body_t *body, uint64_t length)
+{
+  while(length > 0)
+  {
+    ssize_t avail = connection_fill(client, c);
+    if(avail == 0 && length == UINT64_MAX)
+      return 0;
+    if(avail <= 0)
+      return HTTP_ERR_IO;
+
+    size_t n = (uint64_t)avail < length ? (size_t)avail : (size_t)length;
+    if(!body_emit(body, c->buf + c->pos, n))
+      return body->aborted ? HTTP_ERR_ABORTED : HTTP_ERR_DECODE;
+
+    c->pos += n;
+    if(length != UINT64_MAX)
+      length -= n;
+  }
+  return 0;
+}
+
+/** @brief Read a body with chunked transfer encoding */
+static int
+read_body_chunked(http_client_t *client, http_connection_t *c, body_t *body)
+{
+  char line[MAX_LINE_SIZE];
+
+  for(;;)
+  {
+    if(!connection_read_line(client, c, line, sizeof(line)))
+      return HTTP_ERR_IO;
+
+    char     *end;
+    uint64_t size = strtoull(line, &end, 16);
+    if(end == line)
+      return HTTP_ERR_PROTOCOL;
+
+    if(size == 0)
+      break;
+
+    int rc = read_body_length(client, c, body, size);
+    if(rc != 0)
+      return rc;
+
+    // CRLF after the chunk data
+    if(!connection_read_line(client, c, line, sizeof(line)) || line[0] != 0)
+      return HTTP_ERR_PROTOCOL;
+  }
+
+  // Trailer fields up to the final empty line
+  do
+  {
+    if(!connection_read_line(client, c, line, sizeof(line)))
+      return HTTP_ERR_IO;
+  } while(line[0] != 0);
+
+  return 0;
+}
+
+static void
+copy_header_value(char *dst, size_t size, const char *value)
+{
+  strncpy(dst, value, size - 1);
+  dst[size - 1] = 0;
+}
+
+/** @brief Check whether a comma separated header value contains a token */
+static bool
+has_token(const char *value, const char *token)
+{
+  size_t len = strlen(token);
+  while(*value)
+  {
+    while(*value == ' ' || *value == '\t' || *value == ',')
+      ++value;
+    if(strncasecmp(value, token, len) == 0 && (value[len] == 0 || value[len] == ',' || value[len] == ' ' || value[len] == ';'))
+      return true;
+    value += strcspn(value, ",");
+  }
+  return false;
+}
+
+/** @brief Append formatted text to the request head
+ *  @param[in,out] len Length of the head so far, set to size once the head doesn't fit
+ *  @returns Whether the text fit
+ */
+static bool
+head_printf(char *head, size_t size, size_t *len, const char *fmt, ...)
+{
+  va_list ap;
+  int     n;
+
+  // Nothing is written once the head overflowed, head + *len would point past the buffer
+  if(*len >= size)
+    return false;
+
+  va_start(ap, fmt);
+  n = vsnprintf(head + *len, size - *len, fmt, ap);
+  va_end(ap);
+
+  if(n < 0 || (size_t)n >= size - *len)
+  {
+    *len = size;
+    return false;
+  }
+
+  *len += n;
+  return true;
+}
+
+/** @brief Build the request head
+ *  @returns Length of the head, or 0 if it doesn't fit
+ */
+static size_t
+build_request(http_client_t *client, const http_request_t *req, const url_t *url, char *head, size_t size)
+{
+  bool   default_port = url->port == (url->tls ? 443 : 80);
+  int    path_len     = strcspn(url->path, "#");
+  size_t len          = 0;
+
+  head_printf(head, size, &len, "%s %s%.*s HTTP/1.1\r\nHost: %s",
+              req->method ? req->method : "GET", url->path[0] == '/' ? "" : "/", path_len, url->path, url->host);
+  if(!default_port)
+    head_printf(head, size, &len, ":%u", url->port);
+  head_printf(head, size, &len, "\r\n");
+
+  if(client->user_agent)
+    head_printf(head, size, &len, "User-Agent: %s\r\n", client->user_agent);
+  if(client->decoder)
+    head_printf(head, size, &len, "Accept-Encoding: %s\r\n", client->decoder->name);
+  if(req->range)
+  {
+    if(req->range_end == UINT64_MAX)
+      head_printf(head, size, &len, "Range: bytes=%" PRIu64 "-\r\n", req->range_start);
+    else
+      head_printf(head, size, &len, "Range: bytes=%" PRIu64 "-%" PRIu64 "\r\n", req->range_start, req->range_end);
+  }
+  if(req->body || req->body_size)
+    head_printf(head, size, &len, "Content-Length: %zu\r\n", req->body_size);
+  if(req->headers)
+    head_printf(head, size, &len, "%s", req->headers);
+
+  if(!head_printf(head, size, &len, "\r\n"))
+    return 0;
+  return len;
+}
+
+/** @brief Perform a request on a connection
+ *  @param[out] keep_alive Whether the connection can be reused
+ *  @param[out] retry      Whether the request failed before anything was received on a reused connection
+ */
+static int
+perform_on(http_client_t *client, http_connection_t *c, const http_request_t *req, http_response_t *resp,
+           const char *head, size_t head_len, bool reused, bool *keep_alive, bool *retry)
+{
+  char     line[MAX_LINE_SIZE];
+  bool     chunked = false, conn_close = false, http10 = false;
+  uint64_t length = UINT64_MAX;
+  const http_decoder_t *codec = NULL;
+
+  *keep_alive = false;
+  *retry      = false;
+
+  if(!connection_write(client, c, head, head_len)
+  || (req->body_size && !connection_write(client, c, req->body, req->body_size)))
+  {
+    *retry = reused;
+    return HTTP_ERR_IO;
+  }
+
+  // Status line, skipping interim 1xx responses
+  do
+  {
+    if(!connection_read_line(client, c, line, sizeof(line)))
+    {
+      // A kept-alive connection may have been closed by the server in the meantime
+      *retry = reused && resp->status == 0;
+      return HTTP_ERR_IO;
+    }
+
+    int major, minor, status;
+    if(sscanf(line, "HTTP/%d.%d %d", &major, &minor, &status) != 3)
+      return HTTP_ERR_PROTOCOL;
+
+    http10       = major == 1 && minor == 0;
+    resp->status = status;
+
+    if(status >= 100 && status < 200)
+    {
+      do
+      {
+        if(!connection_read_line(client, c, line, sizeof(line)))
+          return HTTP_ERR_IO;
+      } while(line[0] != 0);
+    }
+  } while(resp->status >= 100 && resp->status < 200);
+
+  conn_close = http10;
+
+  // Header fields
+  for(;;)
+  {
+    if(!connection_read_line(client, c, line, sizeof(line)))
+      return HTTP_ERR_IO;
+    if(line[0] == 0)
+      break;
+
+    char *value = strchr(line, ':');
+    if(!value)
+      return HTTP_ERR_PROTOCOL;
+    *value++ = 0;
+    while(*value == ' ' || *value == '\t')
+      ++value;
+
+    if(strcasecmp(line, "Content-Length") == 0)
+      length = strtoull(value, NULL, 10);
+    else if(strcasecmp(line, "Transfer-Encoding") == 0)
+      chunked = has_token(value, "chunked");
+    else if(strcasecmp(line, "Connection") == 0)
+    {
+      if(has_token(value, "close"))
+        conn_close = true;
+      else if(has_token(value, "keep-alive"))
+        conn_close = false;
+    }
+    else if(strcasecmp(line, "Content-Encoding") == 0)
+    {
+      if(client->decoder && has_token(value, client->decoder->name))
+        codec = client->decoder;
+    }
+    else if(strcasecmp(line, "Content-Type") == 0)
+      copy_header_value(resp->content_type, sizeof(resp->content_type), value);
+    else if(strcasecmp(line, "Location") == 0)
+      copy_header_value(resp->location, sizeof(resp->location), value);
+    else if(strcasecmp(line, "ETag") == 0)
+      copy_header_value(resp->etag, sizeof(resp->etag), value);
+    else if(strcasecmp(line, "Content-Range") == 0)
+    {
+      const char *total = strchr(value, '/');
+      if(total && total[1] != '*')
+        resp->range_total = strtoull(total + 1, NULL, 10);
+    }
+  }
+
+  resp->content_length = chunked ? UINT64_MAX : length;
+
+  // Responses without a body
+  bool no_body = resp->status == 204 || resp->status == 304
+              || (req->method && strcasecmp(req->method, "HEAD") == 0);
+  if(no_body)
+  {
+    *keep_alive = !conn_close;
+    return 0;
+  }
+
+  body_t body = { .req = req, .resp = resp, .codec = codec };
+  if(codec)
+  {
+    body.decoder = codec->create();
+    if(!body.decoder)
+      return HTTP_ERR_MEMORY;
+  }
+
+  int rc;
+  if(chunked)
+    rc = read_body_chunked(client, c, &body);
+  else
+  {
+    // Without a length, the body ends when the server closes the connection
+    if(length == UINT64_MAX)
+      conn_close = true;
+    rc = read_body_length(client, c, &body, length);
+  }
+
+  if(body.decoder)
+    codec->destroy(body.decoder);
+
+  *keep_alive = rc == 0 && !conn_close;
+  return rc;
+}
+
+void
+http_client_init(http_client_t          *client,
+                 const http_transport_t *transport)
+{
+  memset(client, 0, sizeof(*client));
+  client->transport = *transport;
+}
+
+void
+http_client_exit(http_client_t *client)
+{
+  pool_lock(client);
+  uint32_t          num_idle = client->num_idle;
+  http_connection_t *idle[HTTP_MAX_IDLE_CONNECTIONS];
+  memcpy(idle, client->idle, sizeof(idle));
+  client->num_idle = 0;
+  pool_unlock(client);
+
+  for(uint32_t i = 0; i < num_idle; ++i)
+    connection_close(client, idle[i]);
+}
+
+void
+http_client_set_decoder(http_client_t        *client,
+                        const http_decoder_t *decoder)
+{
+  client->decoder = decoder;
+}
+
+int
+http_perform(http_client_t        *client,
+             const http_request_t *req,
+             http_response_t      *resp)
+{
+  url_t url;
+  char  *head;
+  int   rc;
+
+  memset(resp, 0, sizeof(*resp));
+  resp->content_length = UINT64_MAX;
+  resp->range_total    = UINT64_MAX;
+
+  if(!parse_url(&url, req->url))
+    return HTTP_ERR_URL;
+
+  head = (char*)malloc(MAX_REQUEST_HEAD);
+  if(!head)
+    return HTTP_ERR_MEMORY;
+
+  size_t head_len = build_request(client, req, &url, head, MAX_REQUEST_HEAD);
+  if(head_len == 0)
+  {
+    free(head);
+    return HTTP_ERR_URL;
+  }
+
+  for(;;)
+  {
+    bool reused, keep_alive, retry;
+    http_connection_t *c = connection_get(client, &url, &reused);
+    if(!c)
+    {
+      rc = HTTP_ERR_CONNECT;
+      break;
+    }
+
+    rc = perform_on(client, c, req, resp, head, head_len, reused, &keep_alive, &retry);
+    if(keep_alive)
+      connection_release(client, c);
+    else
+      connection_close(client, c);
+
+    // Stale keep-alive connection, try again on a fresh one
+    if(!retry)
+      break;
+  }
+
+  free(head);
+  return rc;
+}
@@ -0,0 +1,118 @@
+/** @file http_soc.c
+ *  @brief HTTP client transport over SOC sockets and SSLC contexts
+ */
+#include <3ds/types.h>
+#include <3ds/result.h>
+#include <3ds/synchronization.h>
+#include <3ds/services/soc.h>
+#include <3ds/services/sslc.h>
+#include <3ds/util/http.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/** @brief SOC transport connection */
+typedef struct
+{
+  int         fd;  ///< Socket
+  bool        tls; ///< Whether the SSLC context is used
+  sslcContext ssl; ///< SSLC context
+} soc_conn_t;
+
+/** @brief Connection pool lock, shared by all the clients using this transport */
+static LightLock soc_pool_lock = 1;
+
+static void*
+soc_connect(void *user, const char *host, uint16_t port, bool tls)
+{
+  static const SOCU_ConnectOptions opts = { .timeout_ms = 10000, .stagger_ms = 250, .nodelay = true };
+
+  soc_conn_t *c = (soc_conn_t*)malloc(sizeof(*c));
+  if(!c)
+    return NULL;
+
+  c->tls = tls;
+  c->fd  = SOCU_ConnectHost(host, port, &opts);
+  if(c->fd < 0)
+  {
+    free(c);
+    return NULL;
+  }
+
+  if(tls)
+  {
+    Result rc = sslcCreateContext(&c->ssl, c->fd, (u32)(uintptr_t)user, host);
+    if(R_SUCCEEDED(rc))
+    {
+      rc = sslcStartConnection(&c->ssl, NULL, NULL);
+      if(R_FAILED(rc))
+        sslcDestroyContext(&c->ssl);
+    }
+    if(R_FAILED(rc))
+    {
+      close(c->fd);
+      free(c);
+      return NULL;
+    }
+  }
+
+  return c;
+}
+
+static ssize_t
+soc_read(void *conn, void *buf, size_t len)
+{
+  soc_conn_t *c = (soc_conn_t*)conn;
+  if(c->tls)
+  {
+    Result rc = sslcRead(&c->ssl, buf, len, false);
+    return R_FAILED(rc) ? -1 : rc;
+  }
+  return recv(c->fd, buf, len, 0);
+}
+
+static ssize_t
+soc_write(void *conn, const void *buf, size_t len)
+{
+  soc_conn_t *c = (soc_conn_t*)conn;
+  if(c->tls)
+  {
+    Result rc = sslcWrite(&c->ssl, buf, len);
+    return R_FAILED(rc) ? -1 : rc;
+  }
+  return send(c->fd, buf, len, 0);
+}
+
+static void
+soc_close(void *conn)
+{
+  soc_conn_t *c = (soc_conn_t*)conn;
+  if(c->tls)
+    sslcDestroyContext(&c->ssl);
+  close(c->fd);
+  free(c);
+}
+
+static void
+soc_lock(void *user)
+{
+  LightLock_Lock(&soc_pool_lock);
+}
+
+static void
+soc_unlock(void *user)
+{
+  LightLock_Unlock(&soc_pool_lock);
+}
+
+void
+http_transport_soc(http_transport_t *transport,
+                   uint32_t         sslc_opts)
+{
+  transport->connect = soc_connect;
+  transport->read    = soc_read;
+  transport->write   = soc_write;
+  transport->close   = soc_close;
+  transport->lock    = soc_lock;
+  transport->unlock  = soc_unlock;
+  transport->user    = (void*)(uintptr_t)sslc_opts; // SSLC options for HTTPS connections
+}